@@ -0,0 +1,237 @@
+#include "BodyStore.h"
+#include "KeplerSolver.h"
+#include "JobSystem.h"
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include "spdlog/spdlog.h"
+
+
+int BodyStore::add()
+{
+    parent.push_back(-1);
+    flags.push_back(BodyMotionFlags());
+    rotationAngularVelocity.push_back(0.0f);
+    orbitalAngularVelocity.push_back(0.0f);
+    eccentricity.push_back(0.0f);
+    eccentricAnomaly.push_back(0.0f);
+
+    for (int a = 0; a < BodyAngle_Count; a++)
+    {
+        angle[a].push_back(0.0f);
+        _epoch[a].push_back(Epoch());
+    }
+    _lastTime.push_back(0.0);
+    _evaluatedTime = std::numeric_limits<double>::quiet_NaN();
+    _bChunkParentsDirty = true;
+
+    return int(parent.size() - 1);
+}
+
+void BodyStore::setParent(int body, int parentBody)
+{
+    if (parentBody >= body)
+        spdlog::error("BodyStore: parent {} of body {} was added after it. Bodies must be added parents first.", parentBody, body);
+
+    parent[body] = parentBody;
+    _bChunkParentsDirty = true;
+}
+
+// Same as fmod(angle, 2 * pi), but much cheaper.
+static inline double _wrapAngle(double angle)
+{
+    return angle - 2 * M_PI * double((long long) (angle * (1.0 / (2 * M_PI))));
+}
+
+//
+// Bring one angle to time `t`, starting a new epoch first if the angle was written to from outside or its rate changed.
+//
+void BodyStore::_evaluateEpochAngle(float& angle, Epoch& epoch, double newRate, double lastTime, double t)
+{
+    if (angle != epoch.lastValue) {
+        epoch.angle = angle;
+        epoch.time = lastTime;
+    }
+    if (newRate != epoch.rate) {
+        epoch.angle = _wrapAngle(epoch.angle + epoch.rate * (lastTime - epoch.time));
+        epoch.time = lastTime;
+        epoch.rate = newRate;
+    }
+
+    angle = (float) _wrapAngle(epoch.angle + epoch.rate * (t - epoch.time));
+    epoch.lastValue = angle;
+}
+
+void BodyStore::angleRates(int body, double rate[BodyAngle_Count]) const
+{
+    const BodyMotionFlags& f = flags[body];
+    int p = parent[body];
+
+    rate[BodyAngle_Rotation] = 0.0;
+    if (f.bRotationMotion)
+    {
+        rate[BodyAngle_Rotation] = rotationAngularVelocity[body];
+        if (f.bSyncWithRevolution)
+            rate[BodyAngle_Rotation] = orbitalAngularVelocity[body] * 356.25f;
+    }
+
+    rate[BodyAngle_Orbital] = 0.0;
+    if (f.bRevolutionMotion)
+    {
+        rate[BodyAngle_Orbital] = orbitalAngularVelocity[body];
+        if (f.bOrbitalRevolutionSyncToParent && p >= 0)
+            rate[BodyAngle_Orbital] = orbitalAngularVelocity[p] * 12.3f;                // hardcode for moon
+    }
+
+    rate[BodyAngle_AxisRotation] = 0.0;
+    rate[BodyAngle_AxisTiltOrientation] = 0.0;
+    if (f.bPrecessionMotion)
+    {
+        rate[BodyAngle_AxisRotation] = -0.005;
+        rate[BodyAngle_AxisTiltOrientation] = -0.01;
+    }
+
+    rate[BodyAngle_NodalPrecession] = 0.0;
+    if (f.bOrbitalPlaneRotation)
+    {
+        rate[BodyAngle_NodalPrecession] = -0.005;
+        if (f.bNodalPrecessionSpeedSyncToParentsRevolution && p >= 0)                      // e.g. Moon's nodal precession with earth's revolution period with a factor of 18.6
+            rate[BodyAngle_NodalPrecession] = -orbitalAngularVelocity[p] / 18.6;        // hardcode this for moon
+    }
+}
+
+void BodyStore::_evaluateRange(size_t begin, size_t end, double t)
+{
+    for (size_t i = begin; i < end; i++)
+    {
+        double newRate[BodyAngle_Count];
+        angleRates(int(i), newRate);
+
+        for (int a = 0; a < BodyAngle_Count; a++)
+        {
+            _evaluateEpochAngle(angle[a][i], _epoch[a][i], newRate[a], _lastTime[i], t);
+        }
+        _lastTime[i] = t;
+    }
+
+    keplerSolveBatch(angle[BodyAngle_Orbital].data() + begin, eccentricity.data() + begin, eccentricAnomaly.data() + begin, end - begin);
+}
+
+void BodyStore::evaluateAt(double t, JobSystem* jobSystem)
+{
+    if (jobSystem == nullptr || jobSystem->numThreads() == 1 || size() <= BODY_STORE_CHUNK_SIZE)
+    {
+        _evaluateRange(0, size(), t);
+    }
+    else
+    {
+        // Job ids are chunk indices, since the job system starts with an empty graph
+        const std::vector<std::vector<int>>& chunkParents = _chunkDependencies();
+        for (size_t c = 0; c < chunkParents.size(); c++)
+        {
+            size_t begin = c * BODY_STORE_CHUNK_SIZE;
+            size_t end = std::min(begin + BODY_STORE_CHUNK_SIZE, size());
+            jobSystem->add([this, begin, end, t]() { _evaluateRange(begin, end, t); }, chunkParents[c]);
+        }
+        jobSystem->run();
+    }
+
+    _evaluatedTime = t;
+}
+
+const std::vector<std::vector<int>>& BodyStore::_chunkDependencies()
+{
+    if (!_bChunkParentsDirty)
+        return _chunkParents;
+
+    size_t numChunks = (size() + BODY_STORE_CHUNK_SIZE - 1) / BODY_STORE_CHUNK_SIZE;
+    _chunkParents.assign(numChunks, std::vector<int>());
+
+    for (size_t i = 0; i < size(); i++)
+    {
+        if (parent[i] < 0)
+            continue;
+
+        int chunk = int(i / BODY_STORE_CHUNK_SIZE);
+        int parentChunk = parent[i] / BODY_STORE_CHUNK_SIZE;
+        std::vector<int>& deps = _chunkParents[chunk];
+
+        // bodies within a chunk are evaluated in order, so a parent in the same chunk is already taken care of
+        if (parentChunk != chunk && std::find(deps.begin(), deps.end(), parentChunk) == deps.end())
+            deps.push_back(parentChunk);
+    }
+
+    _bChunkParentsDirty = false;
+    return _chunkParents;
+}
+
+void BodyStore::evaluateBodyAt(int body, double t)
+{
+    _evaluateRange(body, body + 1, t);
+}
+
+
+// Random bodies.  The first 10 are roots, the rest are children of one of them (like moons of planets).
+static void _addSyntheticBodies(BodyStore& store, size_t numBodies)
+{
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> velocityDist(0.0001f, 0.02f);
+    std::uniform_real_distribution<float> eccentricityDist(0.0f, 0.5f);
+
+    for (size_t i = 0; i < numBodies; i++)
+    {
+        int body = store.add();
+        if (body > 0)
+            store.setParent(body, body < 10 ? 0 : body % 10);
+        store.rotationAngularVelocity[body] = velocityDist(rng);
+        store.orbitalAngularVelocity[body] = velocityDist(rng);
+        store.eccentricity[body] = eccentricityDist(rng);
+        store.flags[body].bOrbitalPlaneRotation = (body % 3 == 0);
+    }
+}
+
+// Returns seconds per evaluation
+static double _timeEvaluation(BodyStore& store, JobSystem* jobSystem, int numRepetitions)
+{
+    store.evaluateAt(0.0, jobSystem);                  // warm up
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int r = 1; r <= numRepetitions; r++)
+        store.evaluateAt(r * 1000.0, jobSystem);
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+    return elapsed.count() / numRepetitions;
+}
+
+void bodyStoreRunBenchmark(size_t numBodies, int numRepetitions)
+{
+    BodyStore store;
+    _addSyntheticBodies(store, numBodies);
+
+    double seconds = _timeEvaluation(store, nullptr, numRepetitions);
+    spdlog::info("Body store benchmark: {} bodies x {} repetitions: {:.1f} ns/body, {:.2f} ms per evaluation",
+                 numBodies, numRepetitions, seconds * 1e9 / double(numBodies), seconds * 1e3);
+}
+
+void bodyStoreRunScalingBenchmark(size_t numBodies, int numRepetitions)
+{
+    BodyStore store;
+    _addSyntheticBodies(store, numBodies);
+
+    spdlog::info("Body store scaling benchmark: {} bodies x {} repetitions, {} hardware threads",
+                 numBodies, numRepetitions, JobSystem::defaultThreadCount());
+
+    double singleThreadSeconds = 0.0;
+    for (int numThreads : { 1, 2, 4, 8 })
+    {
+        JobSystem jobSystem(numThreads);
+        double seconds = _timeEvaluation(store, &jobSystem, numRepetitions);
+        if (numThreads == 1)
+            singleThreadSeconds = seconds;
+
+        spdlog::info("    {} thread(s): {:.2f} ms per evaluation, {:.1f} ns/body, {:.2f}x",
+                     numThreads, seconds * 1e3, seconds * 1e9 / double(numBodies), singleThreadSeconds / seconds);
+    }
+}
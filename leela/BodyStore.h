@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+class JobSystem;
+
+//
+// Flags controlling how a body's angles evolve over time.
+//
+struct BodyMotionFlags
+{
+    bool bRevolutionMotion = true;
+    bool bRotationMotion = true;
+    bool bPrecessionMotion = false;
+    bool bOrbitalPlaneRotation = false;
+    bool bSyncWithRevolution = false;                               // sync rotation with this body's revolution
+    bool bOrbitalRevolutionSyncToParent = false;
+    bool bNodalPrecessionSpeedSyncToParentsRevolution = false;
+};
+
+// Time-varying angles of a body.  Used to index BodyStore::angle and the epoch arrays.
+typedef enum
+{
+    BodyAngle_Rotation,
+    BodyAngle_Orbital,                  // mean anomaly
+    BodyAngle_AxisRotation,
+    BodyAngle_AxisTiltOrientation,
+    BodyAngle_NodalPrecession,
+    BodyAngle_Count
+} BodyAngleEnum;
+
+
+//
+// Struct-of-arrays store of the orbital and rotational state of all bodies.
+//  - One entry per body.  Bodies are added parents first, so a parent's index is always lower than its children's.
+//  - evaluateAt() brings all bodies to an absolute simulation time in a single loop, followed by a batched
+//    Kepler solve.  Works the same whether the store holds 10 planets or 100k small bodies.
+//  - Each angle is a linear function of time:  angle(t) = epochAngle + rate * (t - epochTime)
+//      - When the rate changes (motion paused/resumed, sync toggled), a new epoch is started at the angle reached
+//        at the previous evaluation, so the angle stays continuous.
+//      - When an angle was written to from outside (demos, manual movement), the written value becomes the new
+//        epoch angle.
+//
+class BodyStore
+{
+public:
+    // Returns index of the new body.
+    int add();
+    void setParent(int body, int parent);
+    size_t size() const                                 { return parent.size(); }
+
+    // Evaluate all bodies at absolute simulation time `t` (in reference frame steps).
+    //  - With a job system, bodies are evaluated in chunks across its threads.  A chunk holding a body's parent
+    //    always finishes before the chunk holding the body is started.  Job system must have no pending jobs.
+    void evaluateAt(double t, JobSystem* jobSystem = nullptr);
+    double evaluatedTime() const                        { return _evaluatedTime; }
+
+    // Evaluate a single body.  Parent's angular velocity must be up to date.
+    void evaluateBodyAt(int body, double t);
+
+    // Rate of change of each angle of `body` (radians per step), as given by its current motion flags.
+    void angleRates(int body, double rate[BodyAngle_Count]) const;
+
+private:
+    struct Epoch;
+    void _evaluateRange(size_t begin, size_t end, double t);
+    static void _evaluateEpochAngle(float& angle, Epoch& epoch, double newRate, double lastTime, double t);
+    const std::vector<std::vector<int>>& _chunkDependencies();
+
+public:
+    std::vector<int> parent;                                    // -1 if body has no parent in the store
+    std::vector<BodyMotionFlags> flags;
+    std::vector<float> rotationAngularVelocity;
+    std::vector<float> orbitalAngularVelocity;                  // mean motion
+    std::vector<float> eccentricity;
+    std::vector<float> eccentricAnomaly;                        // solved from the orbital angle after every evaluation
+
+    std::vector<float> angle[BodyAngle_Count];                  // current value of each angle
+
+private:
+    // Only touched by evaluation, and always together, so kept as one stream per angle.
+    struct Epoch
+    {
+        double angle = 0.0;
+        double time = 0.0;
+        double rate = 0.0;
+        float lastValue = 0.0f;                                 // value written by the last evaluation.  Used to detect outside writes.
+    };
+
+    std::vector<Epoch> _epoch[BodyAngle_Count];
+    std::vector<double> _lastTime;
+    double _evaluatedTime = std::numeric_limits<double>::quiet_NaN();     // time of last evaluateAt() of the whole store
+
+    // For each chunk of BODY_STORE_CHUNK_SIZE bodies, the earlier chunks holding parents of its bodies.
+    std::vector<std::vector<int>> _chunkParents;
+    bool _bChunkParentsDirty = true;
+};
+
+#define BODY_STORE_CHUNK_SIZE           4096
+
+// Evaluates a store of `numBodies` synthetic bodies `numRepetitions` times and logs ns/body.
+void bodyStoreRunBenchmark(size_t numBodies = 100000, int numRepetitions = 20);
+
+// Evaluates a store of `numBodies` synthetic bodies with 1, 2, 4 and 8 threads and logs time and speedup for each.
+void bodyStoreRunScalingBenchmark(size_t numBodies = 1000000, int numRepetitions = 10);
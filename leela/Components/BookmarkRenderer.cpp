@@ -1,5 +1,6 @@
 #include "BookmarkRenderer.h"
 #include "Leela.h"
+#include "GlslUniforms.h"
 #include "TessellationHelper.h"
 
 bool BookmarkRenderer::isSpherePointHidden(glm::vec3 p)
@@ -18,7 +19,7 @@ bool BookmarkRenderer::isSpherePointHidden(glm::vec3 p)
 void BookmarkRenderer::_renderBookmarks(GlslProgram& glslProgram)
 {
     //glm::mat4 combinedMatrix = g_leela->projectionMatrix * g_leela->viewMatrix;
-    //glslProgram.setMat4("projection", glm::value_ptr(combinedMatrix));
+    //glslProgram.set(Uniforms::projection, combinedMatrix);
 
     glm::mat4 projection = glm::ortho(float(g_leela->curViewportX),
                                       float(g_leela->curViewportX + g_leela->curViewportWidth),
@@ -26,7 +27,6 @@ void BookmarkRenderer::_renderBookmarks(GlslProgram& glslProgram)
                                       float(g_leela->curViewportY + g_leela->curViewportHeight),
                                       0.0f,
                                       100.0f);
-    glslProgram.setMat4("projection", glm::value_ptr(projection));
     
 
     // adjust scale based on zoom level to ensure font size is not too large.
@@ -53,7 +53,7 @@ void BookmarkRenderer::_renderBookmarks(GlslProgram& glslProgram)
         if (projected.z < 1.0f)
         {
             g_leela->RenderText(
-                glslProgram,
+                projection,
                 //RenderTextType_ObjectText,
                 RenderTextType_ScreenText,
                 _bookmark->_label.c_str(),
@@ -75,7 +75,7 @@ void BookmarkRenderer::_renderBookmarkSpheres(GlslProgram& glslProgram)
                                       float(g_leela->curViewportY + g_leela->curViewportHeight),
                                       0.0f,
                                       100.0f);
-    glslProgram.setMat4("projection", glm::value_ptr(projection));
+    glslProgram.set(Uniforms::projection, projection);
 
     glm::vec3 projected;
     glm::vec3 bookmarkPoint;
@@ -88,22 +88,19 @@ void BookmarkRenderer::_renderBookmarkSpheres(GlslProgram& glslProgram)
         projected = g_leela->getScreenCoordinates(bookmarkPoint);
         //spdlog::info("projected.z = {}", projected.z);
 
-        GLboolean curDepthMaskEnable;
-
-        glGetBooleanv(GL_DEPTH_WRITEMASK, &curDepthMaskEnable);       // backup current depth mask before disabling it
         glDepthMask(GL_FALSE);            // disable writing to depth buffer.  This will allow other objects (spheres, etc) to
         // overwrite the label when they are drawn later.
 
         if (projected.z < 1.0f)
         {
-            glslProgram.setVec3("offset", glm::value_ptr(projected));
+            glslProgram.set(Uniforms::offset, projected);
 
             //spdlog::info("Binding vertex and drawing bookmark spheres");
             glBindVertexArray(_bookmarkVao);
             glDrawArrays(GL_TRIANGLES, 0, (GLsizei)numBookmarkSphereVertices);
         }
 
-        glDepthMask(curDepthMaskEnable);    // restore depth mask
+        glDepthMask(GL_TRUE);               // depth writes are on outside of passes that turn them off
 
     }
 
@@ -158,6 +155,10 @@ void BookmarkRenderer::init()
 
 void BookmarkRenderer::render(ViewportType viewportType, RenderStage renderStage, GlslProgram& glslProgram)
 {
+    // hidden behind a body, e.g. on the far side of its own sphere
+    if (_bookmark->_bodyCulled)
+        return;
+
     if (renderStage == RenderStage::Main) {
         if (glslProgram.type() == GlslProgramType::BookmarkSphere) {
             if (viewportType == ViewportType::Primary) {
@@ -177,3 +178,12 @@ void BookmarkRenderer::render(ViewportType viewportType, RenderStage renderStage
 
 }
 
+bool BookmarkRenderer::rendersIn(ViewportType viewportType, RenderStage renderStage, GlslProgramType programType)
+{
+    if (viewportType != ViewportType::Primary)
+        return false;
+
+    return (renderStage == RenderStage::Main && programType == GlslProgramType::BookmarkSphere) ||
+           (renderStage == RenderStage::Final && programType == GlslProgramType::Font);
+}
+
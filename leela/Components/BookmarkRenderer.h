@@ -23,6 +23,7 @@ public:
 	void init();
 	void advance(float stepMultiplier) {}
 	virtual void render(ViewportType viewportType, RenderStage renderStage, GlslProgram& glslProgram);
+	virtual bool rendersIn(ViewportType viewportType, RenderStage renderStage, GlslProgramType programType);
 
 public:
 	GLuint _bookmarkVao = 0;
@@ -2,6 +2,7 @@
 #include "Utils.h"
 #include "TessellationHelper.h"
 #include "Leela.h"
+#include "GlslUniforms.h"
 
 void LatLonRenderer::init()
 {
@@ -222,7 +223,7 @@ void LatLonRenderer::renderLatitudeAndLongitudes(GlslProgram& glslProgram)
 {
     SphericalBody& s = *_sphere;
 
-    if (!s.bIsCenterOfMass)
+    if (!s.bIsCenterOfMass && !s._bodyCulled)
     {
         if (bShowLatitudesAndLongitudes)
         {
@@ -238,9 +239,9 @@ void LatLonRenderer::renderLatitudeAndLongitudes(GlslProgram& glslProgram)
                 _sphericalBodyRenderer->doShaderConfig(glslProgram);
             }
 
-            glslProgram.setBool("useTexture", false);
+            glslProgram.set(Uniforms::useTexture, false);
 
-            glslProgram.setMat4("model", glm::value_ptr(s.getTransform()));
+            glslProgram.set(Uniforms::model, s.getTransform());
 
             glEnable(GL_BLEND);
 
@@ -278,3 +279,10 @@ void LatLonRenderer::render(ViewportType viewportType, RenderStage renderStage,
     }
 }
 
+bool LatLonRenderer::rendersIn(ViewportType viewportType, RenderStage renderStage, GlslProgramType programType)
+{
+    return renderStage == RenderStage::Post &&
+           programType == GlslProgramType::Planet &&
+           viewportType == ViewportType::Primary;
+}
+
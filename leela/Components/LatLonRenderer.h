@@ -20,6 +20,7 @@ public:
 	void constructSpecialLatitudesAndLongitudeVertices();
 
 	virtual void render(ViewportType viewportType, RenderStage renderStage, GlslProgram& glslProgram);
+	virtual bool rendersIn(ViewportType viewportType, RenderStage renderStage, GlslProgramType programType);
 
 	void renderLatitudeAndLongitudes(GlslProgram& glslProgram);
 
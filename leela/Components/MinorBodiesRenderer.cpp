@@ -0,0 +1,89 @@
+#include "MinorBodiesRenderer.h"
+#include "SceneObject.h"
+#include "Leela.h"
+#include "GlslUniforms.h"
+
+
+MinorBodiesRenderer::MinorBodiesRenderer(MinorBodyCatalog& catalog)
+    : Renderer(),
+      _catalog(catalog)
+{
+}
+
+MinorBodiesRenderer::~MinorBodiesRenderer()
+{
+    if (_vbo)
+        glDeleteBuffers(1, &_vbo);
+    if (_vao)
+        glDeleteVertexArrays(1, &_vao);
+}
+
+void MinorBodiesRenderer::init()
+{
+    _numVertices = _catalog.size();
+
+    glGenVertexArrays(1, &_vao);
+    glBindVertexArray(_vao);
+
+    glGenBuffers(1, &_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+
+    // allocate only; positions are streamed on first render
+    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 3 * _numVertices, nullptr, GL_STREAM_DRAW);
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), nullptr);
+    glEnableVertexAttribArray(0);
+    glDisableVertexAttribArray(1);          // color comes from the constant attribute value set in render()
+
+    glBindVertexArray(0);
+}
+
+void MinorBodiesRenderer::_uploadPositions()
+{
+    const std::vector<float>& positions = _catalog.positions();
+
+    glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+    // orphan the old storage so the driver doesn't stall on a buffer the GPU may still be reading
+    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * positions.size(), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(float) * positions.size(), positions.data());
+
+    _uploadedTime = _catalog.evaluatedTime();
+}
+
+void MinorBodiesRenderer::render(ViewportType viewportType, RenderStage renderStage, GlslProgram& glslProgram)
+{
+    if (renderStage != RenderStage::Main || glslProgram.type() != GlslProgramType::Star)
+        return;
+    if (viewportType != ViewportType::Primary && viewportType != ViewportType::Minimap)
+        return;
+    if (!g_leela->bShowMinorBodies || _numVertices == 0)
+        return;
+
+    if (_catalog.evaluatedTime() != _uploadedTime)
+        _uploadPositions();
+
+    glm::mat4 model = glm::scale(_sceneParent->getPositionTransform(), glm::vec3(_unitsPerAu));
+    glslProgram.set(Uniforms::model, model);
+    glslProgram.set(Uniforms::starPointSize, 1u);
+
+    glEnable(GL_PROGRAM_POINT_SIZE);
+    glBindVertexArray(_vao);
+    glVertexAttrib4f(1, _color.r, _color.g, _color.b, 1.0f);
+    glDrawArrays(GL_POINTS, 0, GLsizei(_numVertices));
+    glBindVertexArray(0);
+    glDisable(GL_PROGRAM_POINT_SIZE);
+}
+
+// The catalog spreads over the whole solar system, far beyond the bounds of the sun it's attached to.  Without this
+// the asteroids would disappear whenever the sun is out of view.
+bool MinorBodiesRenderer::drawsOutsideBounds()
+{
+    return g_leela->bShowMinorBodies && _numVertices > 0;
+}
+
+bool MinorBodiesRenderer::rendersIn(ViewportType viewportType, RenderStage renderStage, GlslProgramType programType)
+{
+    return renderStage == RenderStage::Main &&
+           programType == GlslProgramType::Star &&
+           (viewportType == ViewportType::Primary || viewportType == ViewportType::Minimap);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "GlslProgram.h"
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <limits>
+#include "Renderer.h"
+#include "MinorBodyCatalog.h"
+
+//
+// Draws all bodies of a minor body catalog as single pixel points.
+//  - Component of the body the catalog orbits (the Sun).  Catalog positions are in AU relative to it.
+//  - Positions are evaluated outside (Leela::evaluateScene) and streamed into one VBO when they change.
+//  - Uses the star program.  Color is a constant vertex attribute, so only positions are sent to the GPU.
+//
+class MinorBodiesRenderer : public Renderer
+{
+public:
+    MinorBodiesRenderer(MinorBodyCatalog& catalog);
+    ~MinorBodiesRenderer();
+
+    void init();
+    void advance(float stepMultiplier) {}
+    virtual void render(ViewportType viewportType, RenderStage renderStage, GlslProgram& glslProgram);
+    virtual bool rendersIn(ViewportType viewportType, RenderStage renderStage, GlslProgramType programType);
+    virtual bool drawsOutsideBounds();
+
+    void setScale(float unitsPerAu)                 { _unitsPerAu = unitsPerAu; }
+    void setColor(glm::vec3 color)                  { _color = color; }
+
+private:
+    void _uploadPositions();
+
+private:
+    MinorBodyCatalog& _catalog;
+
+    GLuint _vao = 0;
+    GLuint _vbo = 0;
+    size_t _numVertices = 0;
+    double _uploadedTime = std::numeric_limits<double>::quiet_NaN();     // catalog evaluation time of the positions in the VBO
+
+    float _unitsPerAu = 1.0f;
+    glm::vec3 _color = glm::vec3(0.55f, 0.5f, 0.45f);
+};
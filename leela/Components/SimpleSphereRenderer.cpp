@@ -10,4 +10,9 @@ void SimpleSphereRenderer::render(ViewportType viewportType, RenderStage renderS
 {
 }
 
+bool SimpleSphereRenderer::rendersIn(ViewportType viewportType, RenderStage renderStage, GlslProgramType programType)
+{
+    return false;
+}
+
 
@@ -13,6 +13,7 @@ public:
 	void advance(float stepMultiplier) {}
 
 	virtual void render(ViewportType viewportType, RenderStage renderStage, GlslProgram& glslProgram);
+	virtual bool rendersIn(ViewportType viewportType, RenderStage renderStage, GlslProgramType programType);
 
 	SphericalBody& _sphere;
 
@@ -1,6 +1,7 @@
 #include "SphericalBodyRenderer.h"
 #include "Utils.h"
 #include "Leela.h"
+#include "GlslUniforms.h"
 #include "Elements.h"
 
 #include "glm/ext.hpp"
@@ -13,14 +14,16 @@
 #include "SphericalBody.h"
 #include "Space.h"
 
+#include <algorithm>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <string>
 #include <vector>
 #include <map>
 #include <array>
+#include <limits>
 
-#include "lodepng.h"
 #include "spdlog/spdlog.h"
 
 #include "TessellationHelper.h"
@@ -313,54 +316,6 @@ std::tuple<float, float, float, glm::vec3, float, float> SphericalBodyRenderer::
     return { x, y, z, N, texX, texY };
 }
 
-void SphericalBodyRenderer::_constructMainSphereVertices(int numEquatorVertices, GLuint* pVao, GLuint* pVbo, size_t* pNumSphereVertices)
-{
-    SphericalBody& s = *_sphere;
-
-    std::vector<float>* v = ConstructSphereVertices(s._radius, s._color, numEquatorVertices, true);
-
-    if (*pVbo != 0) {
-        glDeleteBuffers(1, pVbo);
-    }
-    if (*pVao != 0) {
-        glDeleteVertexArrays(1, pVao);
-    }
-
-    glGenVertexArrays(1, pVao);
-    glBindVertexArray(*pVao);
-    glGenBuffers(1, pVbo);
-    glBindBuffer(GL_ARRAY_BUFFER, *pVbo);
-    glBufferData(
-        GL_ARRAY_BUFFER,
-        sizeof(float) * v->size(),
-        v->data(),
-        GL_STATIC_DRAW);
-
-    // x, y & z coordinates of the point
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, PLANET_STRIDE_IN_VBO * sizeof(float), nullptr);
-    glEnableVertexAttribArray(0);
-
-    // r, g, b, a color values of the point
-    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, PLANET_STRIDE_IN_VBO * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-
-    // x, y & z of unit normal vector to the sphere at the point
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, PLANET_STRIDE_IN_VBO * sizeof(float), (void*)(7 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-
-    // texture coordinates of the point
-    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, PLANET_STRIDE_IN_VBO * sizeof(float), (void*)(10 * sizeof(float)));
-    glEnableVertexAttribArray(3);
-
-    *pNumSphereVertices = v->size() / PLANET_STRIDE_IN_VBO;
-    
-    //---------------------------------------------------------
-
-    sendTextureToGpu();
-
-    delete v;
-}
-
 void SphericalBodyRenderer::_constructMainIcoSphereVertices()
 {
     std::vector<float>* v = new std::vector<float>();
@@ -444,9 +399,7 @@ void SphericalBodyRenderer::_constructMainIcoSphereVertices()
 
         //printf("%%%% texture coord: x = %f, y = %f\n", texCoordX, texCoordY);
         
-        // scale vertices with unit radius to the actual radius of sphere.
-        vertex *= s._radius;
-
+        // vertices stay at unit radius.  Scaled to the actual radius of sphere in the model matrix.
         vector_push_back_12(*v, vertex.x, vertex.y, vertex.z, s._r, s._g, s._b, 1.0f, N.x, N.y, N.z, texCoordX, texCoordY);
     }
 
@@ -489,7 +442,6 @@ void SphericalBodyRenderer::_constructMainIcoSphereVertices()
     glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, PLANET_STRIDE_IN_VBO * sizeof(float), (void*)(10 * sizeof(float)));
     glEnableVertexAttribArray(3);
 
-    numMainSphereVertices = v->size() / PLANET_STRIDE_IN_VBO;
     numMainSphereElements = e->size() * 3;
 
     //--------------------------------------------
@@ -501,16 +453,49 @@ void SphericalBodyRenderer::_constructMainIcoSphereVertices()
     delete e;
 }
 
-void SphericalBodyRenderer::constructMainSphereVertices()
+// The sphere hides what's behind it unless it's not drawn or drawn as a wireframe.
+BoundingSphere SphericalBodyRenderer::occluderBounds()
 {
-    int numEquatorVertices = _getNumEquatorVertices();
-    _constructMainSphereVertices(numEquatorVertices, &_mainVao, &_mainVbo, &numMainSphereVertices);
+    if (!bShowBody || _sphere->bIsCenterOfMass || g_leela->bShowWireframeSurfaces)
+        return BoundingSphere();
+
+    return BoundingSphere(_sphere->getCenter(), _sphere->getRadius());
 }
 
-void SphericalBodyRenderer::constructMainSphereVerticesForMinimap()
+//
+// Projected radius of the sphere in pixels, in the viewport being rendered.  Works for both perspective and
+// orthographic projections: clip space w is the distance along the view direction in the former and 1 in the latter.
+//
+float SphericalBodyRenderer::projectedRadiusPixels()
 {
-    int numEquatorVertices = _getNumEquatorVertices(PolygonCountLevel_VeryLow);
-    _constructMainSphereVertices(numEquatorVertices, &_minimapMainVao, &_minimapMainVbo, &numMinimapMainSphereVertices);
+    SphericalBody& s = *_sphere;
+
+    glm::vec4 clip = g_leela->projectionMatrix * g_leela->viewMatrix * glm::vec4(s.getCenter(), 1.0f);
+    float w = fabs(clip.w);
+    if (g_leela->projectionMatrix[3][3] == 0.0f && w <= s.getRadius())
+        return std::numeric_limits<float>::max();       // camera is at or inside the surface
+
+    return s.getRadius() * g_leela->projectionMatrix[1][1] * (g_leela->curViewportHeight / 2.0f) / w;
+}
+
+//
+// Draw the shared unit sphere mesh whose level of detail suits the body's size on screen.  Radius is applied
+// through the model matrix and the body's color through the current value of the color attribute, which the
+// mesh doesn't have.
+//
+void SphericalBodyRenderer::drawSphereMesh(GlslProgram& glslProgram, ViewportType viewportType)
+{
+    SphericalBody& s = *_sphere;
+
+    int& level = _lodLevel[int(viewportType)];
+    level = SphereMesh::selectLod(projectedRadiusPixels(), g_leela->sphereLodPixelError, level);
+    SphereMesh* mesh = SphereMesh::lod(level);
+
+    glslProgram.set(Uniforms::model, glm::scale(s.getTransform(), glm::vec3(s.getRadius())));
+    glVertexAttrib4f(1, s._r, s._g, s._b, 1.0f);
+
+    mesh->draw();
+    g_leela->sphereTrianglesDrawn += unsigned(mesh->numIndices() / 3);
 }
 
 
@@ -532,16 +517,12 @@ void SphericalBodyRenderer::constructOrbit()
     //---------------------------------------------------------------------------------
     for (float alpha = 0; alpha < 2 * M_PI; alpha += alpha_inc)
     {
-        float x1 = s._orbitalRadius * cos(alpha);
-        float y1 = s._orbitalRadius * sin(alpha);
-        float z1 = 0;
+        // alpha is the eccentric anomaly.  Gives a circle if the orbit isn't eccentric.
+        glm::vec3 p1 = s.getOrbitalPlanePosition(alpha);
+        glm::vec3 p2 = s.getOrbitalPlanePosition(alpha + alpha_inc);
 
-        float x2 = s._orbitalRadius * cos(alpha + alpha_inc);
-        float y2 = s._orbitalRadius * sin(alpha + alpha_inc);
-        float z2 = 0;
-
-        vector_push_back_7(*v, x1, y1, z1, color.r, color.g, color.b, 0.8f);
-        vector_push_back_7(*v, x2, y2, z2, color.r, color.g, color.b, 0.8f);
+        vector_push_back_7(*v, p1.x, p1.y, p1.z, color.r, color.g, color.b, 0.8f);
+        vector_push_back_7(*v, p2.x, p2.y, p2.z, color.r, color.g, color.b, 0.8f);
     }
 
     //-----------------------------------
@@ -875,13 +856,42 @@ void SphericalBodyRenderer::constructLongRotationAxis()
 }
 
 
+void SphericalBodyRenderer::setVirtualTexture(std::string textureFilename)
+{
+    _virtualTextureFilename = textureFilename;
+    _virtualTexture = std::make_unique<VirtualTexture>();
+}
+
+void SphericalBodyRenderer::decodeTextures()
+{
+    if (_texture == 0 && !_textureFilename.empty() && _textureImage.empty())
+        g_leela->textureCache.load(_locateTextureFile(_textureFilename.c_str()), _textureImage);
+
+    if (_texture2 == 0 && !_textureFilename2.empty() && _textureImage2.empty())
+        g_leela->textureCache.load(_locateTextureFile(_textureFilename2.c_str()), _textureImage2);
+
+    // once; falls back to the regular texture if the tiles can't be made
+    if (_virtualTexture && !_virtualTexture->isOpen())
+    {
+        std::string path = std::filesystem::exists(_virtualTextureFilename) ? _virtualTextureFilename
+                                                                             : _locateTextureFile(_virtualTextureFilename.c_str());
+        if (!_virtualTexture->open(path, g_leela->cacheFolderPath))
+            _virtualTexture.reset();
+    }
+}
+
 void SphericalBodyRenderer::sendTextureToGpu()
 {
+    decodeTextures();
+
+    if (_virtualTexture && !_virtualTexture->isReady())
+        _virtualTexture->init();
+
     if (_texture == 0)
     {
         //printf("*************** texture setup *******************\n");
         //printf("_textureFilename = %s\n", _textureFilename.c_str());
-        if (!_textureFilename.empty())
+        if (!_textureImage.empty())
         {
             glGenTextures(1, &_texture);
             glBindTexture(GL_TEXTURE_2D, _texture);
@@ -899,25 +909,15 @@ void SphericalBodyRenderer::sendTextureToGpu()
             float color[] = { 1.0f, 0.0f, 0.0f, 1.0f };
             glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, color);
 
-
-            std::vector<unsigned char> image1;
-            unsigned int width, height;
-            std::string textureFilePath = _locateTextureFile(_textureFilename.c_str());
-            spdlog::info("Using texture file " + textureFilePath);
-            unsigned int error = lodepng::decode(image1, width, height, textureFilePath.c_str());
-            if (error)
-            {
-                printf("error %d: %s\n", error, lodepng_error_text(error));
-            }
-
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image1.data());
-            glGenerateMipmap(GL_TEXTURE_2D);
+            // placeholder now, full resolution over the next frames
+            g_leela->textureStreamer.add(_texture, std::move(_textureImage));
+            _textureImage = TextureImage();
         }
     }
 
     if (_texture2 == 0)
     {
-        if (!_textureFilename2.empty())
+        if (!_textureImage2.empty())
         {
             glGenTextures(1, &_texture2);
             glBindTexture(GL_TEXTURE_2D, _texture2);
@@ -935,19 +935,8 @@ void SphericalBodyRenderer::sendTextureToGpu()
             float color[] = { 1.0f, 0.0f, 0.0f, 1.0f };
             glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, color);
 
-
-            std::vector<unsigned char> image1;
-            unsigned int width, height;
-            std::string textureFilePath = _locateTextureFile(_textureFilename2.c_str());
-            spdlog::info("Using texture 2 file " + textureFilePath);
-            unsigned int error = lodepng::decode(image1, width, height, textureFilePath.c_str());
-            if (error)
-            {
-                printf("error %d: %s\n", error, lodepng_error_text(error));
-            }
-
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image1.data());
-            glGenerateMipmap(GL_TEXTURE_2D);
+            g_leela->textureStreamer.add(_texture2, std::move(_textureImage2));
+            _textureImage2 = TextureImage();
         }
     }
 }
@@ -961,11 +950,8 @@ void SphericalBodyRenderer::constructVerticesAndSendToGpu()
 
 #ifndef USE_ICOSPHERE
     //---------------------------------------------------------------------------------------------------
-    // The sphere itself
-    int numEquatorVertices;
-    
-    constructMainSphereVertices();
-    constructMainSphereVerticesForMinimap();
+    // The sphere itself.  Meshes are shared by all bodies; see SphereMesh::buildLodChain().
+    sendTextureToGpu();
 #else
     //---------------------------------------------------------------------------------------------------
     // The sphere itself (Icosphere)
@@ -1060,13 +1046,10 @@ void PlanetRenderer::render(ViewportType viewportType, RenderStage renderStage,
             if (viewportType == ViewportType::Primary || viewportType == ViewportType::Minimap) {
                 doShaderConfig(glslProgram);
 
-                if (bShowBody) {
-                    if (viewportType == ViewportType::Primary)
-                        renderSphere(glslProgram);
-                    else
-                        renderMinimapSphere(glslProgram);
+                if (bShowBody && !_sphere->_bodyCulled) {
+                    renderSphere(glslProgram, viewportType);
                 }
-                if (g_leela->bShowPlanetAxis) {
+                if (g_leela->bShowPlanetAxis && !_sphere->_bodyCulled) {
                     renderRotationAxis(glslProgram);
                 }
             }
@@ -1091,6 +1074,25 @@ void PlanetRenderer::render(ViewportType viewportType, RenderStage renderStage,
     }
 }
 
+bool PlanetRenderer::rendersIn(ViewportType viewportType, RenderStage renderStage, GlslProgramType programType)
+{
+    if (viewportType != ViewportType::Primary && viewportType != ViewportType::Minimap)
+        return false;
+
+    if (renderStage == RenderStage::Main)
+        return programType == GlslProgramType::Planet || programType == GlslProgramType::Simple;
+    if (renderStage == RenderStage::TranslucentMain)
+        return programType == GlslProgramType::Simple && viewportType == ViewportType::Primary;
+    return false;
+}
+
+
+// The long rotation axis reaches far beyond the body and its orbit.
+bool PlanetRenderer::drawsOutsideBounds()
+{
+    return bLongAxis && g_leela->bShowPlanetAxis;
+}
+
 
 void PlanetRenderer::doShaderConfig(GlslProgram& glslProgram)
 {
@@ -1102,104 +1104,96 @@ void PlanetRenderer::doShaderConfig(GlslProgram& glslProgram)
     float sineOfSelfUmbraConeHalfAngle = asin(s.getRadius() / selfUmbraLength);
 
 
-    glslProgram.setMat4("model", glm::value_ptr(s.getTransform()));
-    glslProgram.setVec3("sphereInfo.centerTransformed", glm::value_ptr(s.getCenter()));
-    glslProgram.setFloat("sphereInfo.radius", s.getRadius());
+    glslProgram.set(Uniforms::model, s.getTransform());
+    glslProgram.set(Uniforms::sphereCenterTransformed, s.getCenter());
+    glslProgram.set(Uniforms::sphereRadius, s.getRadius());
     float multiplierAdjust = 1.0f;
     if (g_leela->bShowLowDarknessAtNight)
     {
         multiplierAdjust = 2.0f;
     }
-    //glslProgram.setFloat("nightColorMultiplier", _nightColorMultiplier * multiplierAdjust);
+    //glslProgram.set(Uniforms::nightColorMultiplier, _nightColorMultiplier * multiplierAdjust);
     NightColorDarkness level = nightColorDarknessStrToLevel(g_leela->nightDarknessLevelStr);
     float levelFloatValue = nightColorDarknessLevelToFloat(level);
 
-    glslProgram.setFloat("nightColorMultiplier", levelFloatValue * multiplierAdjust);
+    glslProgram.set(Uniforms::nightColorMultiplier, levelFloatValue * multiplierAdjust);
 
-    glslProgram.setFloat("sphereInfo.sineOfSelfUmbraConeHalfAngle", sineOfSelfUmbraConeHalfAngle);
+    glslProgram.set(Uniforms::sphereSineOfSelfUmbraConeHalfAngle, sineOfSelfUmbraConeHalfAngle);
 
     //glEnable(GL_MULTISAMPLE);
 
-    if (s._relatedSphere != nullptr)
-    {
-        // When drawing earth, other sphere is moon.
-        glslProgram.setFloat("otherSphereRadius", s._relatedSphere->getRadius());
-        glslProgram.setVec3("otherSphereCenterTransformed", glm::value_ptr(s._relatedSphere->getModelTransformedCenter()));
-    }
-    else {
-        glslProgram.setFloat("otherSphereRadius", 0.0f);
-    }
+    _setOccluders(glslProgram);
+
+    bool bVirtualTexture = _virtualTexture && _virtualTexture->isReady();
+    glslProgram.set(Uniforms::useVirtualTexture, bVirtualTexture);
+    if (bVirtualTexture)
+        _virtualTexture->bind(glslProgram, 2);
 
     if (!_textureFilename.empty())
     {
-        glslProgram.setBool("useTexture", g_leela->bRealisticSurfaces);
+        // body color if the texture couldn't be decoded
+        glslProgram.set(Uniforms::useTexture, g_leela->bRealisticSurfaces && (_texture != 0 || bVirtualTexture));
 
         //printf("texture filename not empty. Texture = %d\n", _texture);
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, _texture);
-        glslProgram.setInt("texture1", 0);
+        glslProgram.set(Uniforms::texture1, 0);
 
-        if (!_textureFilename2.empty()) {
-            glslProgram.setBool("useTexture2", true);
+        if (_texture2 != 0) {
+            glslProgram.set(Uniforms::useTexture2, true);
 
             glActiveTexture(GL_TEXTURE1);
             glBindTexture(GL_TEXTURE_2D, _texture2);
-            glslProgram.setInt("texture2", 1);
+            glslProgram.set(Uniforms::texture2, 1);
         }
         else {
-            glslProgram.setBool("useTexture2", false);
+            glslProgram.set(Uniforms::useTexture2, false);
         }
     }
     else {
         // usage of texture was enabled globally earlier. Disable it.
-        glslProgram.setBool("useTexture", false);
+        glslProgram.set(Uniforms::useTexture, false);
     }
 }
 
-/*
- * Render the main sphere.
- * 
- * otherSphere      the sphere that could eclipse the sun for this planet/moon. 
- */
-void PlanetRenderer::renderSphere(GlslProgram& glslProgram)
+//
+// Spheres whose shadow can fall on this one at the moment, e.g. moon when drawing earth.  If there are more than
+// the shader takes, the closest ones are used.
+//
+void PlanetRenderer::_setOccluders(GlslProgram& glslProgram)
 {
     SphericalBody& s = *_sphere;
 
-    if (!_sphere->bIsCenterOfMass) {
-        glBindVertexArray(_mainVao);
+    int numOccluders = std::min(int(s._shadowCasters.size()), MAX_OCCLUDERS);
+    glm::vec4 occluders[MAX_OCCLUDERS];
+    for (int i = 0; i < numOccluders; i++)
+        occluders[i] = glm::vec4(s._shadowCasters[i]->getModelTransformedCenter(), s._shadowCasters[i]->getRadius());
 
-        if (g_leela->bShowWireframeSurfaces)
-            glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-        else
-            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-
-    // Draw vertices
-#ifndef USE_ICOSPHERE
-        glDrawArrays(GL_TRIANGLES, 0, (GLsizei) numMainSphereVertices);
-#else
-        glDrawElements(GL_TRIANGLES, numMinimapMainSphereElements, GL_UNSIGNED_INT, 0);
-#endif
-    }
+    glslProgram.set(Uniforms::numOccluders, numOccluders);
+    if (numOccluders > 0)
+        glslProgram.set(Uniforms::occluders, occluders, numOccluders);
 }
 
-
-void PlanetRenderer::renderMinimapSphere(GlslProgram& glslProgram)
+/*
+ * Render the main sphere.
+ */
+void PlanetRenderer::renderSphere(GlslProgram& glslProgram, ViewportType viewportType)
 {
     SphericalBody& s = *_sphere;
 
     if (!_sphere->bIsCenterOfMass) {
-        glBindVertexArray(_minimapMainVao);
-
         if (g_leela->bShowWireframeSurfaces)
             glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
         else
             glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
-        // Draw vertices
+    // Draw vertices
 #ifndef USE_ICOSPHERE
-        glDrawArrays(GL_TRIANGLES, 0, (GLsizei)numMinimapMainSphereVertices);
+        drawSphereMesh(glslProgram, viewportType);
 #else
-        glDrawElements(GL_TRIANGLES, numMinimapMainSphereElements, GL_UNSIGNED_INT, 0);
+        glslProgram.set(Uniforms::model, glm::scale(s.getTransform(), glm::vec3(s.getRadius())));
+        glBindVertexArray(_mainVao);
+        glDrawElements(GL_TRIANGLES, (GLsizei)numMainSphereElements, GL_UNSIGNED_INT, 0);
 #endif
     }
 }
@@ -1215,7 +1209,7 @@ void PlanetRenderer::renderOrbit(GlslProgram& glslProgram)
         // set the model matrix again.
         if (bShowOrbit)
         {
-            glslProgram.setMat4("model", glm::value_ptr(s.getOrbitalPlaneModelMatrix()));
+            glslProgram.set(Uniforms::model, s.getOrbitalPlaneModelMatrix());
 
             glBindVertexArray(_orbitVao);
             glDrawArrays(GL_LINES, 0, (GLsizei) numOrbitVertices);
@@ -1233,7 +1227,7 @@ void PlanetRenderer::renderOrbitalPlane(GlslProgram& glslProgram)
         // orbital plane has its own model transform different from the sphere itself.
         if (bShowOrbitalPlane)
         {
-            glslProgram.setMat4("model", glm::value_ptr(s.getOrbitalPlaneModelMatrix()));
+            glslProgram.set(Uniforms::model, s.getOrbitalPlaneModelMatrix());
 
             // Draw orbital plane grid
             glBindVertexArray(_orbitalPlaneGridVao);
@@ -1262,7 +1256,7 @@ void PlanetRenderer::renderRotationAxis(GlslProgram& glslProgram)
 
     if (!s.bIsCenterOfMass)
     {
-        //glslProgram.setMat4("model", glm::value_ptr(_sphere.getModelMatrix()));
+        //glslProgram.set(Uniforms::model, _sphere.getModelMatrix());
 
         PNT sphereCenter = PNT(s.getCenter());
         float distSunToThisSphere = (float)PNT(s._sunSphere->getCenter()).distanceTo(sphereCenter);
@@ -1270,23 +1264,18 @@ void PlanetRenderer::renderRotationAxis(GlslProgram& glslProgram)
         float sineOfSelfUmbraConeHalfAngle = asin(s.getRadius() / selfUmbraLength);
 
 
-        glslProgram.setMat4("model", glm::value_ptr(s.getTransform()));
-        glslProgram.setVec3("sphereInfo.centerTransformed", glm::value_ptr(s.getCenter()));
-        glslProgram.setFloat("sphereInfo.radius", s.getRadius());
-        //glslProgram.setFloat("nightColorMultiplier", 0.1);
-        glslProgram.setFloat("nightColorMultiplier", _nightColorMultiplier);
-        glslProgram.setFloat("sphereInfo.sineOfSelfUmbraConeHalfAngle", sineOfSelfUmbraConeHalfAngle);
+        glslProgram.set(Uniforms::model, s.getTransform());
+        glslProgram.set(Uniforms::sphereCenterTransformed, s.getCenter());
+        glslProgram.set(Uniforms::sphereRadius, s.getRadius());
+        //glslProgram.set(Uniforms::nightColorMultiplier, 0.1);
+        glslProgram.set(Uniforms::nightColorMultiplier, _nightColorMultiplier);
+        glslProgram.set(Uniforms::sphereSineOfSelfUmbraConeHalfAngle, sineOfSelfUmbraConeHalfAngle);
 
         //glEnable(GL_MULTISAMPLE);
 
-        if (s._relatedSphere != nullptr)
-        {
-            // When drawing earth, other sphere is moon.
-            glslProgram.setFloat("otherSphereRadius", s._relatedSphere->getRadius());
-            glslProgram.setVec3("otherSphereCenterTransformed", glm::value_ptr(s._relatedSphere->getModelTransformedCenter()));
-        }
+        _setOccluders(glslProgram);
 
-        glslProgram.setBool("useTexture", false);
+        glslProgram.set(Uniforms::useTexture, false);
 
         glBindVertexArray(_rotationAxisVao);
         glDrawArrays(GL_TRIANGLES, 0, (GLsizei) numRotationAxisVertices);
@@ -1301,7 +1290,7 @@ void PlanetRenderer::renderLongRotationAxis(GlslProgram& glslProgram)
     {
         if (bLongAxis)
         {
-            glslProgram.setMat4("model", glm::value_ptr(s.getTransform()));
+            glslProgram.set(Uniforms::model, s.getTransform());
             glBindVertexArray(_longRotationAxisVao);
             glDrawArrays(GL_LINES, 0, (GLsizei)numLongRotationAxisVertices);
         }
@@ -1325,7 +1314,7 @@ SunRenderer::~SunRenderer()
 
 void SunRenderer::doShaderConfig(GlslProgram& glslProgram)
 {
-    if (!_textureFilename.empty())
+    if (_texture != 0)
     {
         //printf("texture filename not empty. Texture = %d\n", _texture);
         glActiveTexture(GL_TEXTURE0);
@@ -1334,7 +1323,7 @@ void SunRenderer::doShaderConfig(GlslProgram& glslProgram)
     else
     {
         // usage of texture was enabled globally earlier. Disable it.
-        glslProgram.setBool("useTexture", false);
+        glslProgram.set(Uniforms::useTexture, false);
     }
 }
 
@@ -1345,44 +1334,30 @@ void SunRenderer::render(ViewportType viewportType, RenderStage renderStage, Gls
             if (viewportType == ViewportType::Primary || viewportType == ViewportType::Minimap) {
                 doShaderConfig(glslProgram);
 
-                if (bShowBody)
-                    if (viewportType == ViewportType::Primary)
-                        _renderSphere(glslProgram);
-                    else
-                        renderMinimapSphere(glslProgram);
+                if (bShowBody && !_sphere->_bodyCulled)
+                    _renderSphere(glslProgram, viewportType);
             }
         }
     }
 }
 
-void SunRenderer::_renderSphere(GlslProgram& glslProgram)
+bool SunRenderer::rendersIn(ViewportType viewportType, RenderStage renderStage, GlslProgramType programType)
 {
-    SphericalBody& s = *_sphere;
-
-    glslProgram.setMat4("model", glm::value_ptr(s.getTransform()));
-
-    glBindVertexArray(_mainVao);
-
-    // Draw vertices
-#ifndef USE_ICOSPHERE
-    glDrawArrays(GL_TRIANGLES, 0, (GLsizei) numMainSphereVertices);
-#else
-    glDrawElements(GL_TRIANGLES, numMainSphereElements, GL_UNSIGNED_INT, 0);
-#endif
+    return renderStage == RenderStage::Main &&
+           programType == GlslProgramType::Sun &&
+           (viewportType == ViewportType::Primary || viewportType == ViewportType::Minimap);
 }
 
-void SunRenderer::renderMinimapSphere(GlslProgram& glslProgram)
+void SunRenderer::_renderSphere(GlslProgram& glslProgram, ViewportType viewportType)
 {
     SphericalBody& s = *_sphere;
 
-    glslProgram.setMat4("model", glm::value_ptr(s.getTransform()));
-
-    glBindVertexArray(_minimapMainVao);
-
     // Draw vertices
 #ifndef USE_ICOSPHERE
-    glDrawArrays(GL_TRIANGLES, 0, (GLsizei)numMinimapMainSphereVertices);
+    drawSphereMesh(glslProgram, viewportType);
 #else
-    glDrawElements(GL_TRIANGLES, numMinimapMainSphereElements, GL_UNSIGNED_INT, 0);
+    glslProgram.set(Uniforms::model, glm::scale(s.getTransform(), glm::vec3(s.getRadius())));
+    glBindVertexArray(_mainVao);
+    glDrawElements(GL_TRIANGLES, (GLsizei)numMainSphereElements, GL_UNSIGNED_INT, 0);
 #endif
 }
\ No newline at end of file
@@ -11,8 +11,14 @@ class Leela;
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <GL/glew.h>
+#include <memory>
+#include <string>
+#include <vector>
 
 #include "GlslProgram.h"
+#include "SphereMesh.h"
+#include "TextureCache.h"
+#include "VirtualTexture.h"
 
 
 struct Triangle
@@ -64,10 +70,7 @@ public:
 	void setPolygonCountLevel(std::string polygonCountLevel);
 
     void constructVerticesAndSendToGpu();
-    void _constructMainSphereVertices(int numEquatorVertices, GLuint* pVao, GLuint* pVbo, size_t* pNumSphereVertices);
     void _constructMainIcoSphereVertices();
-    void constructMainSphereVertices();
-    void constructMainSphereVerticesForMinimap();
     //void constructIcoSphereVertices();
     //void constructIcoSphereVerticesForMinimap();
     void constructRotationAxis();
@@ -76,13 +79,25 @@ public:
     void constructOrbitalPlaneVertices();
     void constructOrbitalPlaneGridVertices();
 
+    // Texture files are loaded through the TextureCache by decodeTextures(), which makes no GL calls and can run on a
+    // worker thread before init().  sendTextureToGpu() loads them itself if that hasn't happened, and hands them to
+    // the TextureStreamer.
+    void decodeTextures();
     void sendTextureToGpu();
 
+    // Draw the surface from a virtual texture of `textureFilename` rather than from the regular texture.  Must be
+    // called before decodeTextures().
+    void setVirtualTexture(std::string textureFilename);
+
     virtual void doShaderConfig(GlslProgram& glslProgram) {}
+    virtual BoundingSphere occluderBounds();
+    void drawSphereMesh(GlslProgram& glslProgram, ViewportType viewportType);
+    float projectedRadiusPixels();
 
     std::string _locateTextureFile(const char * filenName);
 
 
+
 public:
     bool bShowOrbit = false;
     bool bOrbitalPlaneTransparency = false;
@@ -100,21 +115,11 @@ public:
 public:
     SphericalBody * _sphere = nullptr;
 
-    
-    GLuint _minimapMainVao = 0;
-    GLuint _minimapMainVbo = 0;
-    GLuint minimapVbo = 0;     // vertex buffer object
-    GLuint minimapEbo = 0;     // element buffer object
-    
-    size_t numMinimapMainSphereVertices = 0;
-    size_t minimapNumMainSphereVertices = 0;
-    size_t minimapNumMainSphereElements = 0;
-
     //-------------------------------------------
     // Primary scene VAOs, VBOs and vertex counts
 
-    GLuint _mainVao = 0;
-    GLuint _mainVbo = 0;
+    int _lodLevel[NUM_VIEWPORT_TYPES] = { -1, -1, -1 };     // level of the shared sphere mesh last drawn in each viewport
+    GLuint _mainVao = 0;                        // icosphere only
     GLuint vbo = 0;     // vertex buffer object
     GLuint ebo = 0;     // element buffer object
     GLuint _orbitVao = 0;
@@ -130,7 +135,6 @@ public:
     GLuint _orbitalPlaneGridVao = 0;            // grid lines in the orbital plane
     GLuint _orbitalPlaneGridVbo = 0;
 
-    size_t numMainSphereVertices = 0;
     size_t numMainSphereElements = 0;
     size_t numOrbitVertices = 0;
     size_t numRotationAxisVertices = 0;
@@ -148,8 +152,10 @@ public:
     bool _bIsLightSource = false;
     std::string _textureFilename = "";
     std::string _textureFilename2 = "";
-
-    unsigned char* data = nullptr;
+    TextureImage _textureImage;                 // until sent to GPU
+    TextureImage _textureImage2;
+    std::string _virtualTextureFilename = "";
+    std::unique_ptr<VirtualTexture> _virtualTexture;    // none if not set or if it couldn't be opened
 };
 
 
@@ -160,15 +166,18 @@ public:
 	~PlanetRenderer();
 
     virtual void render(ViewportType viewportType, RenderStage renderStage, GlslProgram& glslProgram);
+    virtual bool rendersIn(ViewportType viewportType, RenderStage renderStage, GlslProgramType programType);
     virtual void doShaderConfig(GlslProgram& glslProgram);
+    virtual bool drawsOutsideBounds();
 
-	void renderSphere(GlslProgram& glslProgram);
-    void renderMinimapSphere(GlslProgram& glslProgram);
+	void renderSphere(GlslProgram& glslProgram, ViewportType viewportType);
 	void renderOrbitalPlane(GlslProgram& glslProgram);
 	void renderOrbit(GlslProgram& glslProgram);
     void renderRotationAxis(GlslProgram& glslProgram);
     void renderLongRotationAxis(GlslProgram& glslProgram);
 
+private:
+    void _setOccluders(GlslProgram& glslProgram);
 };
 
 class SunRenderer : public SphericalBodyRenderer
@@ -180,7 +189,7 @@ public:
     virtual void doShaderConfig(GlslProgram& glslProgram);
 
     virtual void render(ViewportType viewportType, RenderStage renderStage, GlslProgram& glslProgram);
+    virtual bool rendersIn(ViewportType viewportType, RenderStage renderStage, GlslProgramType programType);
 
-	void _renderSphere(GlslProgram& glslProgram);
-    void renderMinimapSphere(GlslProgram& glslProgram);
+	void _renderSphere(GlslProgram& glslProgram, ViewportType viewportType);
 };
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include <GL/glew.h>
 #include "SphericalBody.h"
 #include "Leela.h"
+#include "GlslUniforms.h"
 #include "Elements.h"
 
 static inline void vector_push_back_7(std::vector<float>& v, float f1, float f2, float f3, float f4, float f5, float f6, float f7)
@@ -57,6 +58,13 @@ void StarsRenderer::render(ViewportType viewportType, RenderStage renderStage, G
     }
 }
 
+bool StarsRenderer::rendersIn(ViewportType viewportType, RenderStage renderStage, GlslProgramType programType)
+{
+    return renderStage == RenderStage::Main &&
+           programType == GlslProgramType::Star &&
+           (viewportType == ViewportType::Primary || viewportType == ViewportType::Minimap);
+}
+
 
 std::tuple<std::vector<float>*, std::vector<float>*> StarsRenderer::_constructCubeStars()
 {
@@ -188,11 +196,26 @@ std::tuple<std::vector<float>*, std::vector<float>*> StarsRenderer::_constructGa
 
 void StarsRenderer::constructVerticesAndSendToGpu()
 {
-    GLuint vbo;
-    std::vector<float>* v = nullptr;
+    constructVertices();
+    sendVerticesToGpu();
+}
 
+void StarsRenderer::constructVertices()
+{
     auto [singlePixelStars, doublePixelStars] = _constructCubeStars();
 
+    _singlePixelStarVertices = std::move(*singlePixelStars);
+    _doublePixelStarVertices = std::move(*doublePixelStars);
+    delete singlePixelStars;
+    delete doublePixelStars;
+}
+
+void StarsRenderer::sendVerticesToGpu()
+{
+    GLuint vbo;
+    std::vector<float>* singlePixelStars = &_singlePixelStarVertices;
+    std::vector<float>* doublePixelStars = &_doublePixelStarVertices;
+
 
     //---------------------------------------------------------------------------------------------------
     // Cube stars - 1 pixel
@@ -258,7 +281,9 @@ void StarsRenderer::constructVerticesAndSendToGpu()
 
         
     //numGalaxyStarVertices = v->size() / VERTEX_STRIDE_IN_VBO;
-    delete v;
+
+    _singlePixelStarVertices = std::vector<float>();
+    _doublePixelStarVertices = std::vector<float>();
 
 }
 
@@ -270,14 +295,14 @@ void StarsRenderer::renderCubeStars(GlslProgram& glslProgram)
     //----------------------------------------------
     // Cubic stars model transformation
     //----------------------------------------------
-    glslProgram.setMat4("model", glm::value_ptr(glm::mat4(1.0)));
+    glslProgram.set(Uniforms::model, glm::mat4(1.0));
 
-    glslProgram.setUint("starPointSize", 1);
+    glslProgram.set(Uniforms::starPointSize, 1u);
     glBindVertexArray(cubeStarsSinglePixelVao);
     // Draw vertices
     glDrawArrays(GL_POINTS, 0, numCubeStarsSinglePixelVertices);
 
-    glslProgram.setUint("starPointSize", 2);
+    glslProgram.set(Uniforms::starPointSize, 2u);
     glBindVertexArray(cubeStarsDoublePixelVao);
     glDrawArrays(GL_POINTS, 0, numCubeStarsDoublePixelVertices);
 
@@ -291,15 +316,15 @@ void StarsRenderer::renderGalaxyStars(GlslProgram& glslProgram)
     //----------------------------------------------
     // Galaxy stars model transformation
     //----------------------------------------------
-    glslProgram.setMat4("model", glm::value_ptr(glm::mat4(1.0)));
+    glslProgram.set(Uniforms::model, glm::mat4(1.0));
 
-    glslProgram.setUint("starPointSize", 1);
+    glslProgram.set(Uniforms::starPointSize, 1u);
     glBindVertexArray(galaxyStarsSinglePixelVao);
     // Draw vertices
     glDrawArrays(GL_POINTS, 0, numGalaxyStarsSinglePixelVertices);
 
     glBindVertexArray(galaxyStarsDoublePixelVao);
-    glslProgram.setUint("starPointSize", 2);
+    glslProgram.set(Uniforms::starPointSize, 2u);
     glDrawArrays(GL_POINTS, 0, numGalaxyStarsDoublePixelVertices);
 
 
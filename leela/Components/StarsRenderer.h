@@ -15,11 +15,16 @@ public:
     void init();
     void _renderStars(GlslProgram& glslProgram);
     virtual void render(ViewportType viewportType, RenderStage renderStage, GlslProgram& glslProgram);
+    virtual bool rendersIn(ViewportType viewportType, RenderStage renderStage, GlslProgramType programType);
 
     void advance(float stepMultiplier) {}
     
 
+    // constructVerticesAndSendToGpu() in two steps.  constructVertices() makes no GL calls and can run on a worker
+    // thread; sendVerticesToGpu() needs the GL context.
     void constructVerticesAndSendToGpu();
+    void constructVertices();
+    void sendVerticesToGpu();
     void renderCubeStars(GlslProgram& glslProgram);
     void renderGalaxyStars(GlslProgram& glslProgram);
 
@@ -39,6 +44,10 @@ private:
     int numGalaxyStarsSinglePixelVertices = 0;
     int numGalaxyStarsDoublePixelVertices = 0;
 
+    // until sent to GPU
+    std::vector<float> _singlePixelStarVertices;
+    std::vector<float> _doublePixelStarVertices;
+
     Stars& _stars;
 };
 
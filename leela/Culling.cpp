@@ -0,0 +1,117 @@
+#include "Culling.h"
+#include <algorithm>
+#include <cmath>
+
+
+void BoundingSphere::merge(const BoundingSphere& other)
+{
+    if (!bounded() || !other.bounded()) {
+        radius = -1.0f;
+        return;
+    }
+
+    float d = glm::length(other.center - center);
+    if (d + other.radius <= radius)
+        return;                                     // other is already inside
+    if (d + radius <= other.radius) {
+        *this = other;                              // this is inside other
+        return;
+    }
+
+    float newRadius = (d + radius + other.radius) / 2.0f;
+    center += (other.center - center) * ((newRadius - radius) / d);
+    radius = newRadius;
+}
+
+
+Frustum::Frustum(const glm::mat4& projectionView)
+{
+    // Gribb & Hartmann: each plane is the 4th row of the matrix plus or minus one of the other rows.
+    // glm matrices are column major; m[column][row].
+    const glm::mat4& m = projectionView;
+    glm::vec4 row[4];
+    for (int i = 0; i < 4; i++)
+        row[i] = glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+
+    _planes[0] = row[3] + row[0];       // left
+    _planes[1] = row[3] - row[0];       // right
+    _planes[2] = row[3] + row[1];       // bottom
+    _planes[3] = row[3] - row[1];       // top
+    _planes[4] = row[3] + row[2];       // near
+    _planes[5] = row[3] - row[2];       // far
+
+    for (glm::vec4& plane : _planes)
+        plane /= glm::length(glm::vec3(plane));
+}
+
+bool Frustum::intersects(const BoundingSphere& sphere) const
+{
+    if (!sphere.bounded())
+        return true;
+
+    for (const glm::vec4& plane : _planes)
+    {
+        if (glm::dot(glm::vec3(plane), sphere.center) + plane.w < -sphere.radius)
+            return false;
+    }
+    return true;
+}
+
+
+bool isSphereOccluded(const glm::vec3& eye, const BoundingSphere& occluder, const BoundingSphere& occludee)
+{
+    if (!occluder.bounded() || !occludee.bounded())
+        return false;
+
+    glm::vec3 toOccluder = occluder.center - eye;
+    glm::vec3 toOccludee = occludee.center - eye;
+    float occluderDistance = glm::length(toOccluder);
+    float occludeeDistance = glm::length(toOccludee);
+
+    if (occluderDistance <= occluder.radius || occludeeDistance <= occludee.radius)
+        return false;                   // eye is inside one of them
+
+    // distance from the eye to the silhouette (the circle where the cone touches the occluder)
+    float silhouetteDistance = sqrt(occluderDistance * occluderDistance - occluder.radius * occluder.radius);
+    if (occludeeDistance - occludee.radius < silhouetteDistance)
+        return false;
+
+    float occluderHalfAngle = asin(occluder.radius / occluderDistance);
+    float occludeeHalfAngle = asin(occludee.radius / occludeeDistance);
+    float cosAngle = glm::dot(toOccluder, toOccludee) / (occluderDistance * occludeeDistance);
+    float angle = acos(std::clamp(cosAngle, -1.0f, 1.0f));
+
+    return angle + occludeeHalfAngle <= occluderHalfAngle;
+}
+
+
+bool isInShadowCone(const BoundingSphere& sun, const BoundingSphere& occluder, const BoundingSphere& receiver)
+{
+    glm::vec3 sunToOccluder = occluder.center - sun.center;
+    float sunOccluderDistance = glm::length(sunToOccluder);
+
+    if (sunOccluderDistance <= sun.radius + occluder.radius)
+        return true;                    // touching the sun; no well defined cone
+
+    if (glm::distance(sun.center, receiver.center) + receiver.radius < sunOccluderDistance)
+        return false;
+
+    // apex of the penumbra cone, and its half angle
+    glm::vec3 axis = sunToOccluder / sunOccluderDistance;
+    float penumbraLength = occluder.radius * sunOccluderDistance / (sun.radius + occluder.radius);
+    glm::vec3 apex = occluder.center - axis * penumbraLength;
+    float sinHalfAngle = occluder.radius / penumbraLength;
+    float cosHalfAngle = sqrt(1.0f - sinHalfAngle * sinHalfAngle);
+
+    // receiver's center along the axis from the apex, and away from the axis
+    glm::vec3 apexToReceiver = receiver.center - apex;
+    float along = glm::dot(apexToReceiver, axis);
+    float across = glm::length(apexToReceiver - axis * along);
+
+    if (along <= 0.0f)
+        return glm::length(apexToReceiver) <= receiver.radius;
+
+    // distance of the receiver's center from the cone's surface
+    float distanceFromCone = (across - along * sinHalfAngle / cosHalfAngle) * cosHalfAngle;
+    return distanceFromCone <= receiver.radius;
+}
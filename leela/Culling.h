@@ -0,0 +1,56 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+//
+// Bounding sphere in world coordinates.  Negative radius means unbounded: the object can be anywhere and is never
+// culled.
+//
+struct BoundingSphere
+{
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = -1.0f;
+
+    BoundingSphere() {}
+    BoundingSphere(glm::vec3 c, float r) : center(c), radius(r) {}
+
+    bool bounded() const                                    { return radius >= 0.0f; }
+
+    // Grow to enclose `other` as well.  Unbounded if either one is.
+    void merge(const BoundingSphere& other);
+};
+
+
+//
+// View frustum of a camera, as 6 planes extracted from its combined projection and view matrix.  Works for both
+// perspective and orthographic projections.
+//
+class Frustum
+{
+public:
+    explicit Frustum(const glm::mat4& projectionView);
+
+    // False only if the sphere is completely outside.  Unbounded spheres are always inside.
+    bool intersects(const BoundingSphere& sphere) const;
+
+private:
+    glm::vec4 _planes[6];               // xyz: unit normal pointing inside, w: distance
+};
+
+
+//
+// Whether `occludee` is completely hidden from a perspective camera at `eye` behind the opaque sphere `occluder`.
+//  - The occludee must be inside the cone of the occluder's silhouette as seen from the eye, and farther from
+//    the eye than the silhouette.  Anything in that region is either behind or inside the occluder.
+//
+bool isSphereOccluded(const glm::vec3& eye, const BoundingSphere& occluder, const BoundingSphere& occludee);
+
+
+//
+// Whether any part of `receiver` can be in the shadow that `occluder` casts in the light of `sun`.
+//  - The shadow is bounded by the penumbra cone: the cone tangent to both spheres whose apex lies between them.
+//    Umbra and antumbra are inside it.
+//  - Like planet shading, only the part of the receiver farther from the sun than the occluder's center can be
+//    shadowed.
+//
+bool isInShadowCone(const BoundingSphere& sun, const BoundingSphere& occluder, const BoundingSphere& receiver);
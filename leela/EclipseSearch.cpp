@@ -0,0 +1,370 @@
+#include "EclipseSearch.h"
+#include "SceneObject.h"
+#include "SphericalBody.h"
+#include "BodyStore.h"
+#include "KeplerSolver.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+
+
+static const int COARSE_SAMPLES_PER_ORBIT = 36;                 // of the faster body of a shadow pair
+static const size_t SAMPLES_PER_WINDOW = 4096;
+static const int REFINE_ITERATIONS = 40;
+
+
+const char* eclipseEventTypeName(EclipseEventType type)
+{
+    switch (type) {
+    case EclipseEventType_PartialSolarEclipse:      return "Partial solar eclipse";
+    case EclipseEventType_TotalSolarEclipse:        return "Total solar eclipse";
+    case EclipseEventType_AnnularSolarEclipse:      return "Annular solar eclipse";
+    case EclipseEventType_PenumbralLunarEclipse:    return "Penumbral lunar eclipse";
+    case EclipseEventType_PartialLunarEclipse:      return "Partial lunar eclipse";
+    case EclipseEventType_TotalLunarEclipse:        return "Total lunar eclipse";
+    case EclipseEventType_Transit:                  return "Transit";
+    default:                                        return "Unknown";
+    }
+}
+
+bool isSolarEclipse(EclipseEventType type)
+{
+    return type == EclipseEventType_PartialSolarEclipse ||
+           type == EclipseEventType_TotalSolarEclipse ||
+           type == EclipseEventType_AnnularSolarEclipse;
+}
+
+bool isLunarEclipse(EclipseEventType type)
+{
+    return type == EclipseEventType_PenumbralLunarEclipse ||
+           type == EclipseEventType_PartialLunarEclipse ||
+           type == EclipseEventType_TotalLunarEclipse;
+}
+
+
+void EclipseSearch::capture(Scene& scene, BodyStore& store, double simulationTime)
+{
+    _bodies.clear();
+    _pairs.clear();
+    _sun = -1;
+    _captureTime = simulationTime;
+
+    // Parents come before children in the flattened scene, so parent indices are always known
+    std::map<SceneObject*, int> indexOf;
+    std::vector<SphericalBody*> spheres;
+
+    for (const Scene::FlatNode& node : scene.flattened())
+    {
+        SphericalBody* sb = dynamic_cast<SphericalBody*>(node.object);
+        if (sb == nullptr)
+            continue;
+
+        double rate[BodyAngle_Count];
+        store.angleRates(sb->bodyIndex(), rate);
+
+        Body b;
+        b.name = sb->_name;
+        b.parent = indexOf.count(sb->_sceneParent) ? indexOf[sb->_sceneParent] : -1;
+        b.radius = sb->getRadius();
+        b.semiMajorAxis = sb->_orbitalRadius;
+        b.eccentricity = sb->eccentricity();
+        b.argumentOfPeriapsis = sb->_argumentOfPeriapsis;
+        b.orbitalPlaneTilt = sb->_orbitalPlaneTiltAngle;
+        b.orbitalAngle = sb->orbitalAngle();
+        b.orbitalRate = rate[BodyAngle_Orbital];
+        b.nodalPrecessionAngle = sb->nodalPrecessionAngle();
+        b.nodalPrecessionRate = rate[BodyAngle_NodalPrecession];
+
+        indexOf[sb] = int(_bodies.size());
+        _bodies.push_back(b);
+        spheres.push_back(sb);
+    }
+
+    for (SphericalBody* sb : spheres)
+    {
+        if (sb->_sunSphere && indexOf.count(sb->_sunSphere)) {
+            _sun = indexOf[sb->_sunSphere];
+            break;
+        }
+    }
+    if (_sun < 0)
+        return;
+
+    // eclipses between related spheres
+    for (size_t i = 0; i < spheres.size(); i++)
+    {
+        for (SphericalBody* occluder : spheres[i]->_relatedSpheres)
+        {
+            if (!indexOf.count(occluder))
+                continue;
+
+            int o = indexOf[occluder];
+            int t = int(i);
+            if (_bodies[o].parent == t)
+                _addPair(ShadowPair_SolarEclipse, o, t);
+            else if (_bodies[t].parent == o)
+                _addPair(ShadowPair_LunarEclipse, o, t);
+        }
+    }
+
+    // transits across the sun, as seen from bodies that have eclipses
+    std::vector<int> observers;
+    for (const ShadowPair& pair : _pairs)
+        if (pair.kind == ShadowPair_SolarEclipse)
+            observers.push_back(pair.target);
+    std::sort(observers.begin(), observers.end());
+    observers.erase(std::unique(observers.begin(), observers.end()), observers.end());
+
+    for (int observer : observers)
+    {
+        for (int p = 0; p < int(_bodies.size()); p++)
+        {
+            if (_bodies[p].parent == _sun && _bodies[observer].parent == _sun &&
+                _bodies[p].semiMajorAxis < _bodies[observer].semiMajorAxis)
+            {
+                _addPair(ShadowPair_Transit, p, observer);
+            }
+        }
+    }
+}
+
+void EclipseSearch::_addPair(ShadowPairKind kind, int occluder, int target)
+{
+    for (const ShadowPair& pair : _pairs)
+        if (pair.occluder == occluder && pair.target == target)
+            return;                             // same events would be found twice
+
+    double fastestRate = std::max(fabs(_bodies[occluder].orbitalRate), fabs(_bodies[target].orbitalRate));
+    if (fastestRate == 0.0)
+        return;                                 // nothing moves; nothing to find
+
+    ShadowPair pair;
+    pair.kind = kind;
+    pair.occluder = occluder;
+    pair.target = target;
+    pair.coarseStep = 2 * M_PI / fastestRate / COARSE_SAMPLES_PER_ORBIT;
+    _pairs.push_back(pair);
+}
+
+//
+// Center of a body at time t.  Same transform chain as SphericalBody::computePositionTransform():
+// parent's frame, then nodal precession around z, orbital plane tilt around y, then position on the ellipse.
+//
+glm::dvec3 EclipseSearch::_positionAt(int body, double t, glm::dmat3* frame) const
+{
+    const Body& b = _bodies[body];
+
+    glm::dmat3 parentFrame(1.0);
+    glm::dvec3 parentPosition(0.0);
+    if (b.parent >= 0)
+        parentPosition = _positionAt(b.parent, t, &parentFrame);
+
+    double dt = t - _captureTime;
+
+    double nodal = b.nodalPrecessionAngle + b.nodalPrecessionRate * dt;
+    double cn = cos(nodal), sn = sin(nodal);
+    double ct = cos(b.orbitalPlaneTilt), st = sin(b.orbitalPlaneTilt);
+    glm::dmat3 rz(cn, sn, 0.0,   -sn, cn, 0.0,   0.0, 0.0, 1.0);
+    glm::dmat3 ry(ct, 0.0, -st,   0.0, 1.0, 0.0,   st, 0.0, ct);
+    glm::dmat3 bodyFrame = parentFrame * rz * ry;
+
+    double M = fmod(b.orbitalAngle + b.orbitalRate * dt, 2 * M_PI);
+    double E = keplerSolveEccentricAnomaly(float(M), float(b.eccentricity));
+    double x = b.semiMajorAxis * (cos(E) - b.eccentricity);
+    double y = b.semiMajorAxis * sqrt(1.0 - b.eccentricity * b.eccentricity) * sin(E);
+    double cw = cos(b.argumentOfPeriapsis), sw = sin(b.argumentOfPeriapsis);
+    glm::dvec3 p(x * cw - y * sw, x * sw + y * cw, 0.0);
+
+    if (frame)
+        *frame = bodyFrame;
+    return parentPosition + bodyFrame * p;
+}
+
+//
+// Penumbra and umbra of the occluder at the target.  See eclipse_shading.glsl for the diagram.
+//
+EclipseSearch::Shadow EclipseSearch::_shadowAt(const ShadowPair& pair, double t) const
+{
+    glm::dvec3 sun = _positionAt(_sun, t);
+    glm::dvec3 occluder = _positionAt(pair.occluder, t);
+    glm::dvec3 target = _positionAt(pair.target, t);
+    double sunRadius = _bodies[_sun].radius;
+    double occluderRadius = _bodies[pair.occluder].radius;
+    double targetRadius = _bodies[pair.target].radius;
+
+    Shadow s;
+    glm::dvec3 toSun = sun - occluder;
+    double dist_sun_occluder = glm::length(toSun);
+
+    // N: point on the sun-occluder line nearest to the target.  k < 0 on the far side of the occluder.
+    double k = glm::dot(target - occluder, toSun) / (dist_sun_occluder * dist_sun_occluder);
+    glm::dvec3 N = occluder + toSun * k;
+    double dist_N_occluder = -k * dist_sun_occluder;
+
+    s.bBehind = k < 0.0;
+    s.axisDistance = glm::distance(N, target);
+
+    double penumbraLength = (occluderRadius * dist_sun_occluder) / (sunRadius + occluderRadius);
+    s.penumbraRadius = (penumbraLength + dist_N_occluder) * tan(asin(occluderRadius / penumbraLength));
+
+    double umbraLength = (occluderRadius * dist_sun_occluder) / (sunRadius - occluderRadius);
+    s.umbraRadius = (umbraLength - dist_N_occluder) * tan(asin(occluderRadius / umbraLength));
+
+    s.margin = s.bBehind ? s.axisDistance - (s.penumbraRadius + targetRadius) : std::numeric_limits<double>::max();
+    return s;
+}
+
+//
+// Given a bracket [t0, t1] around a local minimum of the penumbra margin, find the time of maximum eclipse and,
+// if the target is touched by the penumbra, the contact times and the type of the event.
+//
+bool EclipseSearch::_refine(const ShadowPair& pair, double t0, double t1, EclipseEvent& event) const
+{
+    // golden section search for the minimum
+    const double invPhi = 0.6180339887498949;
+    double a = t0, b = t1;
+    double c = b - (b - a) * invPhi;
+    double d = a + (b - a) * invPhi;
+    double fc = _shadowAt(pair, c).margin;
+    double fd = _shadowAt(pair, d).margin;
+
+    for (int i = 0; i < REFINE_ITERATIONS; i++)
+    {
+        if (fc < fd) {
+            b = d;  d = c;  fd = fc;
+            c = b - (b - a) * invPhi;
+            fc = _shadowAt(pair, c).margin;
+        }
+        else {
+            a = c;  c = d;  fc = fd;
+            d = a + (b - a) * invPhi;
+            fd = _shadowAt(pair, d).margin;
+        }
+    }
+
+    double tMax = (a + b) / 2;
+    Shadow s = _shadowAt(pair, tMax);
+    if (s.margin >= 0.0)
+        return false;
+
+    // step outwards until out of the penumbra, then bisect for the contact
+    auto findContact = [&](double direction) {
+        double inside = tMax;
+        double outside = tMax + direction * pair.coarseStep;
+        for (int i = 0; i < 100 && _shadowAt(pair, outside).margin < 0.0; i++) {
+            inside = outside;
+            outside += direction * pair.coarseStep;
+        }
+        for (int i = 0; i < REFINE_ITERATIONS; i++) {
+            double mid = (inside + outside) / 2;
+            if (_shadowAt(pair, mid).margin < 0.0)
+                inside = mid;
+            else
+                outside = mid;
+        }
+        return (inside + outside) / 2;
+    };
+
+    event.startTime = findContact(-1.0);
+    event.maximumTime = tMax;
+    event.endTime = findContact(+1.0);
+    event.occluder = _bodies[pair.occluder].name;
+    event.target = _bodies[pair.target].name;
+
+    double targetRadius = _bodies[pair.target].radius;
+
+    if (pair.kind == ShadowPair_Transit)
+    {
+        event.type = EclipseEventType_Transit;
+    }
+    else if (pair.kind == ShadowPair_SolarEclipse)
+    {
+        if (s.umbraRadius >= 0.0 && s.axisDistance < s.umbraRadius + targetRadius)
+            event.type = EclipseEventType_TotalSolarEclipse;
+        else if (s.umbraRadius < 0.0 && s.axisDistance < -s.umbraRadius + targetRadius)
+            event.type = EclipseEventType_AnnularSolarEclipse;                      // antumbra touches the target
+        else
+            event.type = EclipseEventType_PartialSolarEclipse;
+    }
+    else
+    {
+        if (s.axisDistance + targetRadius < s.umbraRadius)
+            event.type = EclipseEventType_TotalLunarEclipse;
+        else if (s.axisDistance - targetRadius < s.umbraRadius)
+            event.type = EclipseEventType_PartialLunarEclipse;
+        else
+            event.type = EclipseEventType_PenumbralLunarEclipse;
+    }
+
+    return true;
+}
+
+// Scan one window of time for local minima of the penumbra margin.
+void EclipseSearch::_searchWindow(const ShadowPair& pair, double fromTime, double toTime, std::vector<EclipseEvent>& events) const
+{
+    double step = pair.coarseStep;
+    double prev = _shadowAt(pair, fromTime - step).margin;
+    double cur = _shadowAt(pair, fromTime).margin;
+
+    for (double t = fromTime; t < toTime; t += step)
+    {
+        double next = _shadowAt(pair, t + step).margin;
+
+        if (cur < prev && cur <= next && cur != std::numeric_limits<double>::max())
+        {
+            EclipseEvent event;
+            if (_refine(pair, t - step, t + step, event))
+                events.push_back(event);
+        }
+
+        prev = cur;
+        cur = next;
+    }
+}
+
+std::vector<EclipseEvent> EclipseSearch::search(double fromTime, double toTime, JobSystem* jobSystem,
+                                                const std::string& occluder, const std::string& target) const
+{
+    // one job per window per pair.  Windows of a pair start on the same sampling grid.
+    struct Window
+    {
+        const ShadowPair* pair;
+        double fromTime;
+        double toTime;
+        std::vector<EclipseEvent> events;
+    };
+    std::vector<Window> windows;
+
+    for (const ShadowPair& pair : _pairs)
+    {
+        if ((!occluder.empty() && _bodies[pair.occluder].name != occluder) ||
+            (!target.empty() && _bodies[pair.target].name != target))
+            continue;
+
+        double windowLength = pair.coarseStep * SAMPLES_PER_WINDOW;
+        for (double t = fromTime; t < toTime; t += windowLength)
+            windows.push_back({ &pair, t, std::min(t + windowLength, toTime), {} });
+    }
+
+    auto searchWindows = [&](size_t begin, size_t end) {
+        for (size_t w = begin; w < end; w++)
+            _searchWindow(*windows[w].pair, windows[w].fromTime, windows[w].toTime, windows[w].events);
+    };
+
+    if (jobSystem)
+        jobSystem->parallelFor(windows.size(), 1, searchWindows);
+    else
+        searchWindows(0, windows.size());
+
+    std::vector<EclipseEvent> events;
+    for (Window& w : windows)
+        for (EclipseEvent& e : w.events)
+            if (e.maximumTime >= fromTime && e.maximumTime < toTime)
+                events.push_back(e);
+
+    std::sort(events.begin(), events.end(),
+              [](const EclipseEvent& a, const EclipseEvent& b) { return a.maximumTime < b.maximumTime; });
+    return events;
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+class Scene;
+class BodyStore;
+class JobSystem;
+
+typedef enum
+{
+    EclipseEventType_PartialSolarEclipse,
+    EclipseEventType_TotalSolarEclipse,
+    EclipseEventType_AnnularSolarEclipse,
+    EclipseEventType_PenumbralLunarEclipse,
+    EclipseEventType_PartialLunarEclipse,
+    EclipseEventType_TotalLunarEclipse,
+    EclipseEventType_Transit,
+    EclipseEventType_Count
+} EclipseEventType;
+
+const char* eclipseEventTypeName(EclipseEventType type);
+bool isSolarEclipse(EclipseEventType type);
+bool isLunarEclipse(EclipseEventType type);
+
+
+struct EclipseEvent
+{
+    EclipseEventType type;
+    std::string occluder;                   // body casting the shadow (moon for a solar eclipse, mercury for a transit)
+    std::string target;                     // body the shadow falls on
+    double startTime;                       // first and last penumbral contact with the target, in simulation time
+    double maximumTime;                     // closest approach of the target to the shadow axis
+    double endTime;
+};
+
+
+//
+// Finds eclipses and transits by scanning simulation time.
+//  - capture() takes a snapshot of the orbits and angular rates of all spherical bodies.  Bodies are assumed to
+//    keep moving at their current rates, which is also what the scene does when it's evaluated at a later time,
+//    so found times can be jumped to directly.
+//  - Shadow pairs come from the scene: each body's related sphere (moon -> earth: solar eclipse, earth -> moon:
+//    lunar eclipse), and each planet inside the orbit of a body with a moon (transit).  Each (occluder, target)
+//    pair is searched once.
+//  - For each pair, the distance of the target from the occluder's shadow axis is sampled at a step that is a
+//    fraction of the faster orbit.  Local minima are refined with a golden section search and contacts with
+//    bisection.  Shadow cones are the same as in eclipse_shading.glsl.
+//  - Time is split into windows that are searched in parallel.
+//
+class EclipseSearch
+{
+public:
+    void capture(Scene& scene, BodyStore& store, double simulationTime);
+
+    // All events whose maximum is in [fromTime, toTime), sorted by time.
+    //  - Only pairs with the given occluder and target, when not empty.  Other pairs aren't searched.
+    std::vector<EclipseEvent> search(double fromTime, double toTime, JobSystem* jobSystem = nullptr,
+                                     const std::string& occluder = "", const std::string& target = "") const;
+
+private:
+    struct Body
+    {
+        std::string name;
+        int parent = -1;
+        double radius = 0.0;
+        double semiMajorAxis = 0.0;
+        double eccentricity = 0.0;
+        double argumentOfPeriapsis = 0.0;
+        double orbitalPlaneTilt = 0.0;
+        double orbitalAngle = 0.0;              // mean anomaly at capture time
+        double orbitalRate = 0.0;
+        double nodalPrecessionAngle = 0.0;
+        double nodalPrecessionRate = 0.0;
+    };
+
+    typedef enum
+    {
+        ShadowPair_SolarEclipse,                // occluder orbits the target
+        ShadowPair_LunarEclipse,                // target orbits the occluder
+        ShadowPair_Transit                      // both orbit the sun
+    } ShadowPairKind;
+
+    struct ShadowPair
+    {
+        ShadowPairKind kind;
+        int occluder;
+        int target;
+        double coarseStep;                      // sampling step of the scan
+    };
+
+    struct Shadow
+    {
+        double margin;                          // distance of target's surface from the penumbra. Negative when in contact.
+        double axisDistance;                    // distance of target's center from the shadow axis
+        double penumbraRadius;                  // shadow cone radii at the target
+        double umbraRadius;                     // negative beyond the tip of the umbra
+        bool bBehind;                           // target is on the far side of the occluder
+    };
+
+    glm::dvec3 _positionAt(int body, double t, glm::dmat3* frame = nullptr) const;
+    Shadow _shadowAt(const ShadowPair& pair, double t) const;
+    void _searchWindow(const ShadowPair& pair, double fromTime, double toTime, std::vector<EclipseEvent>& events) const;
+    bool _refine(const ShadowPair& pair, double t0, double t1, EclipseEvent& event) const;
+    void _addPair(ShadowPairKind kind, int occluder, int target);
+
+private:
+    std::vector<Body> _bodies;
+    std::vector<ShadowPair> _pairs;
+    int _sun = -1;
+    double _captureTime = 0.0;
+};
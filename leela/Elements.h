@@ -20,11 +20,13 @@ struct PlanetInfo
     float axisTiltOrientationAngle;
     float axisTiltAngle;
 
-    float orbitalRadius;
-    float orbitalAngle;
-    float orbitalAngularVelocity;
+    float orbitalRadius;                    // semi-major axis
+    float orbitalAngle;                     // mean anomaly at start
+    float orbitalAngularVelocity;           // mean motion
     float nodalPrecessionInitialAngle;
     float orbitalPlaneTiltAngle;
+    float eccentricity;
+    float argumentOfPeriapsis;
 
     glm::vec3 color;
 
@@ -0,0 +1,19 @@
+#include "FrameUniformBuffer.h"
+
+
+void FrameUniformBuffer::init()
+{
+    glGenBuffers(1, &_ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, _ubo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_UNIFORMS_BINDING, _ubo);
+}
+
+void FrameUniformBuffer::update(const FrameUniforms& frameUniforms)
+{
+    glBindBuffer(GL_UNIFORM_BUFFER, _ubo);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &frameUniforms);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+// Binding point of the FrameUniforms block.  Programs using the block are bound to it when linked.
+constexpr GLuint FRAME_UNIFORMS_BINDING = 0;
+
+//
+// Camera and sun data shared by all programs, in std140 layout.  Must match the FrameUniforms block in the
+// shaders:
+//
+//      layout (std140) uniform FrameUniforms
+//      {
+//          mat4  view;
+//          mat4  proj;
+//          vec3  sunCenterTransformed;
+//          float sunRadius;
+//          bool  realisticShading;
+//      };
+//
+struct FrameUniforms
+{
+    glm::mat4 view;
+    glm::mat4 proj;
+    glm::vec3 sunCenterTransformed;
+    float sunRadius;
+    int realisticShading;                   // GLSL bool is 4 bytes in std140
+    float _padding[3];                      // block size is rounded up to a multiple of 16
+};
+static_assert(sizeof(FrameUniforms) == 160, "FrameUniforms must match the std140 layout of the shader block");
+
+
+//
+// Uniform buffer holding FrameUniforms.  Updated with a single write per viewport; programs read it from
+// FRAME_UNIFORMS_BINDING, so switching programs doesn't need any matrices to be sent again.
+//
+class FrameUniformBuffer
+{
+public:
+    void init();
+    void update(const FrameUniforms& frameUniforms);
+
+private:
+    GLuint _ubo = 0;
+};
@@ -1,8 +1,35 @@
 #include "GlslProgram.h"
+#include "FrameUniformBuffer.h"
+#include <algorithm>
 #include <fstream>
 #include <exception>
+#include <unordered_map>
+#include <glm/gtc/type_ptr.hpp>
 #include "spdlog/spdlog.h"
 
+unsigned int GlslProgram::uniformUploads = 0;
+
+
+// Function local so that handles defined at namespace scope in any translation unit can register safely.
+static std::vector<std::string>& _uniformNames()
+{
+	static std::vector<std::string> names;
+	return names;
+}
+
+int glslRegisterUniform(const char* name)
+{
+	std::vector<std::string>& names = _uniformNames();
+	for (int i = 0; i < int(names.size()); i++)
+	{
+		if (names[i] == name)
+			return i;
+	}
+
+	names.push_back(name);
+	return int(names.size()) - 1;
+}
+
 GlslProgram::GlslProgram(GlslProgramType type)
 	: _type(type)
 {
@@ -35,8 +62,16 @@ void GlslProgram::printShaderCompileStatus(GLuint shader)
 }
 
 // attempt to open files from the list of provided file paths.
-// If a file is successfully opened, read its contents, store them to `fileContents`, and return. 
+// If a file is successfully opened, read its contents, append them to `fileContents`, and return. 
 void GlslProgram::_readFile(const char * fileName, std::string& fileContents)
+{
+	int lastSourceNumber = 0;
+	_readFile(fileName, fileContents, 0, lastSourceNumber);
+}
+
+// `sourceNumber` is the source string number compile errors report for this file: 0 for the shader itself,
+// numbered in order for the files it includes.
+void GlslProgram::_readFile(const char * fileName, std::string& fileContents, int sourceNumber, int& lastSourceNumber)
 {
     std::string line;
 
@@ -55,8 +90,24 @@ void GlslProgram::_readFile(const char * fileName, std::string& fileContents)
 			printf("Failed to open %s\n", filePath.c_str());
 		}
 		else {
-			spdlog::info("Reading shader file {}", filePath.c_str());
+			spdlog::info("Reading shader file {} as source {}", filePath.c_str(), sourceNumber);
+			int lineNumber = 0;
 			while (std::getline(shaderFile, line)) {
+				lineNumber++;
+
+				// #include "file" is replaced by the contents of file, which is looked up in the same directories.
+				// The #line directives around it keep compile errors pointing at the right line of the right file.
+				const std::string includeDirective = "#include \"";
+				if (line.compare(0, includeDirective.size(), includeDirective) == 0) {
+					size_t end = line.find('"', includeDirective.size());
+					int includedSourceNumber = ++lastSourceNumber;
+					fileContents += "#line 1 " + std::to_string(includedSourceNumber) + "\n";
+					_readFile(line.substr(includeDirective.size(), end - includeDirective.size()).c_str(), fileContents,
+					          includedSourceNumber, lastSourceNumber);
+					fileContents += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(sourceNumber) + "\n";
+					continue;
+				}
+
 				fileContents += line + "\n";
 			}
 			return;
@@ -139,9 +190,66 @@ void GlslProgram::link()
 		// Don't leak shaders either.
 		glDeleteShader(vertShaderId);
 		glDeleteShader(fragShaderId);
+
+		_resolveUniformLocations();
+
+		GLuint frameUniformsIndex = glGetUniformBlockIndex(shaderProgramId, "FrameUniforms");
+		if (frameUniformsIndex != GL_INVALID_INDEX)
+			glUniformBlockBinding(shaderProgramId, frameUniformsIndex, FRAME_UNIFORMS_BINDING);
+	}
+}
+
+//
+// Enumerate the active uniforms of the linked program and record the location of each registered uniform.
+//
+void GlslProgram::_resolveUniformLocations()
+{
+	GLint numActiveUniforms = 0;
+	GLint maxNameLength = 0;
+	glGetProgramiv(shaderProgramId, GL_ACTIVE_UNIFORMS, &numActiveUniforms);
+	glGetProgramiv(shaderProgramId, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+	std::unordered_map<std::string, GLint> activeUniforms;
+	std::vector<GLchar> nameBuffer(std::max(maxNameLength, 1));
+
+	for (GLint i = 0; i < numActiveUniforms; i++)
+	{
+		GLint size;
+		GLenum type;
+		glGetActiveUniform(shaderProgramId, GLuint(i), GLsizei(nameBuffer.size()), nullptr, &size, &type, nameBuffer.data());
+
+		std::string name = nameBuffer.data();
+		GLint location = glGetUniformLocation(shaderProgramId, name.c_str());
+
+		// arrays are reported as "name[0]"
+		if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+			name.resize(name.size() - 3);
+
+		activeUniforms[name] = location;
+	}
+
+	const std::vector<std::string>& names = _uniformNames();
+	_uniformLocations.assign(names.size(), -1);
+	for (size_t i = 0; i < names.size(); i++)
+	{
+		auto it = activeUniforms.find(names[i]);
+		if (it != activeUniforms.end())
+			_uniformLocations[i] = it->second;
 	}
 }
 
+// -1 if the program doesn't use the uniform; glUniform* ignores it then, so it isn't counted as an upload.
+GLint GlslProgram::_location(int uniformIndex)
+{
+	GLint location = -1;
+	if (uniformIndex < int(_uniformLocations.size()))
+		location = _uniformLocations[uniformIndex];
+
+	if (location != -1)
+		uniformUploads++;
+	return location;
+}
+
 void GlslProgram::use()
 {
 	glUseProgram(shaderProgramId);
@@ -152,54 +260,37 @@ void GlslProgram::unuse()
 	glUseProgram(0);
 }
 
-void GlslProgram::setBool(const std::string& uniformName, bool value)
+void GlslProgram::set(GlslUniform<bool> uniform, bool value)
 {
-	glUniform1i(
-		glGetUniformLocation(shaderProgramId, uniformName.c_str()),
-		(int)value
-	);
+	glUniform1i(_location(uniform.index), (int)value);
 }
 
-void GlslProgram::setInt(const std::string& uniformName, int value)
+void GlslProgram::set(GlslUniform<int> uniform, int value)
 {
-	glUniform1i(
-		glGetUniformLocation(shaderProgramId, uniformName.c_str()),
-		value
-	);
+	glUniform1i(_location(uniform.index), value);
 }
 
-void GlslProgram::setUint(const std::string& uniformName, unsigned int value)
+void GlslProgram::set(GlslUniform<unsigned int> uniform, unsigned int value)
 {
-	glUniform1ui(
-		glGetUniformLocation(shaderProgramId, uniformName.c_str()),
-		value
-	);
+	glUniform1ui(_location(uniform.index), value);
 }
 
-void GlslProgram::setFloat(const std::string& uniformName, float value)
+void GlslProgram::set(GlslUniform<float> uniform, float value)
 {
-	glUniform1f(
-		glGetUniformLocation(shaderProgramId, uniformName.c_str()),
-		value
-	);
+	glUniform1f(_location(uniform.index), value);
 }
 
-void GlslProgram::setVec3(const std::string& uniformName, const float* value)
+void GlslProgram::set(GlslUniform<glm::vec3> uniform, const glm::vec3& value)
 {
-	glUniform3fv(
-		glGetUniformLocation(shaderProgramId, uniformName.c_str()),
-		1,
-		value
-	);
+	glUniform3fv(_location(uniform.index), 1, glm::value_ptr(value));
 }
 
+void GlslProgram::set(GlslUniform<glm::vec4> uniform, const glm::vec4* values, int count)
+{
+	glUniform4fv(_location(uniform.index), count, glm::value_ptr(values[0]));
+}
 
-void GlslProgram::setMat4(const std::string& uniformName, const float* value)
+void GlslProgram::set(GlslUniform<glm::mat4> uniform, const glm::mat4& value)
 {
-	glUniformMatrix4fv(
-		glGetUniformLocation(shaderProgramId, uniformName.c_str()),
-		1,
-		GL_FALSE,
-		value
-	);
+	glUniformMatrix4fv(_location(uniform.index), 1, GL_FALSE, glm::value_ptr(value));
 }
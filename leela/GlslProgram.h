@@ -1,6 +1,7 @@
 #pragma once
 
 #include <GL/glew.h>
+#include <glm/glm.hpp>
 #include <string>
 #include <vector>
 
@@ -20,6 +21,26 @@ enum class GlslProgramType
 };
 
 
+// Registry of uniform names used by the application.  Returns the index of `name`, adding it if necessary.
+int glslRegisterUniform(const char* name);
+
+
+//
+// Handle to a uniform, typed by the value it takes.
+//  - Created once (see GlslUniforms.h).  The name is registered at construction and never looked at again.
+//  - The same handle works with any program.  Each program maps handle indices to its own locations when linked.
+//
+template <typename T>
+struct GlslUniform
+{
+	explicit GlslUniform(const char* name)
+		: index(glslRegisterUniform(name))
+	{}
+
+	int index;
+};
+
+
 class GlslProgram
 {
 public:
@@ -32,18 +53,27 @@ public:
     void use();
 	void unuse();
 
-	void setBool(const std::string& uniformName, bool value);
-	void setInt(const std::string& uniformName, int value);
-	void setUint(const std::string& uniformName, unsigned int value);
-	void setFloat(const std::string& uniformName, float value);
-	void setVec3(const std::string& uniformName, const float* value);
-	void setMat4(const std::string& uniformName, const float* value);
+	// Upload a uniform of this program.  Program must be in use.  Uniforms not used by the program are ignored.
+	void set(GlslUniform<bool> uniform, bool value);
+	void set(GlslUniform<int> uniform, int value);
+	void set(GlslUniform<unsigned int> uniform, unsigned int value);
+	void set(GlslUniform<float> uniform, float value);
+	void set(GlslUniform<glm::vec3> uniform, const glm::vec3& value);
+	void set(GlslUniform<glm::vec4> uniform, const glm::vec4* values, int count);		// array; first `count` elements
+	void set(GlslUniform<glm::mat4> uniform, const glm::mat4& value);
 
 	GlslProgramType type() { return _type;  }
 
+	// Number of uniforms uploaded through set() by all programs, not counting uniforms a program doesn't use.
+	// Reset by the application every frame.
+	static unsigned int uniformUploads;
+
 private:
     void _readFile(const char * fileName, std::string& fileContents);
+    void _readFile(const char * fileName, std::string& fileContents, int sourceNumber, int& lastSourceNumber);
     void _compileShader(const char* shaderText, GLuint& shaderId);
+    void _resolveUniformLocations();
+    GLint _location(int uniformIndex);
 
     const char* _vertShaderText = nullptr;
     const char* _fragShaderText = nullptr;
@@ -54,5 +84,7 @@ private:
 	GLuint shaderProgramId	= 0;
 
 	GlslProgramType _type;
+
+	std::vector<GLint> _uniformLocations;		// indexed by GlslUniform::index.  -1 if the program doesn't use it.
 };
 
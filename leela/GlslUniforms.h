@@ -0,0 +1,43 @@
+#pragma once
+
+#include "GlslProgram.h"
+
+// Size of the `occluders` array of eclipse_shading.glsl
+constexpr int MAX_OCCLUDERS = 4;
+
+//
+// Handles of all uniforms set by the application, shared by all programs.
+//  - Defined at namespace scope so that they are registered before any program is linked.  Add new uniforms here.
+//
+namespace Uniforms
+{
+    // transforms
+    inline const GlslUniform<glm::mat4>     model                               { "model" };
+    inline const GlslUniform<glm::mat4>     proj                                { "proj" };             // simple_ortho only.  Others get it from FrameUniforms.
+    inline const GlslUniform<glm::mat4>     projection                          { "projection" };       // orthographic screen projection
+
+    // spheres and shadows
+    inline const GlslUniform<glm::vec3>     sphereCenterTransformed             { "sphereInfo.centerTransformed" };
+    inline const GlslUniform<float>         sphereRadius                        { "sphereInfo.radius" };
+    inline const GlslUniform<float>         sphereSineOfSelfUmbraConeHalfAngle  { "sphereInfo.sineOfSelfUmbraConeHalfAngle" };
+    inline const GlslUniform<int>           numOccluders                        { "numOccluders" };
+    inline const GlslUniform<glm::vec4>     occluders                           { "occluders" };       // array of MAX_OCCLUDERS; xyz center, w radius
+    inline const GlslUniform<float>         nightColorMultiplier                { "nightColorMultiplier" };
+    inline const GlslUniform<bool>          perFragmentShading                  { "perFragmentShading" };
+
+    // textures
+    inline const GlslUniform<bool>          useTexture                          { "useTexture" };
+    inline const GlslUniform<bool>          useTexture2                         { "useTexture2" };
+    inline const GlslUniform<int>           texture1                            { "texture1" };
+    inline const GlslUniform<int>           texture2                            { "texture2" };
+
+    // virtual texture; see VirtualTexture.h
+    inline const GlslUniform<bool>          useVirtualTexture                   { "useVirtualTexture" };
+    inline const GlslUniform<int>           vtAtlas                             { "vtAtlas" };
+    inline const GlslUniform<int>           vtNumLevels                         { "vtNumLevels" };
+    inline const GlslUniform<int>           vtFeedbackPhase                     { "vtFeedbackPhase" };
+
+    // stars and bookmarks
+    inline const GlslUniform<unsigned int>  starPointSize                       { "starPointSize" };
+    inline const GlslUniform<glm::vec3>     offset                              { "offset" };
+}
@@ -0,0 +1,261 @@
+#include "GlyphAtlas.h"
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_MODULE_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include "spdlog/spdlog.h"
+
+
+// Width of the atlas texture.  Height is whatever the rows of glyphs need.
+static constexpr int ATLAS_WIDTH = 512;
+static constexpr int GLYPH_PADDING = 1;
+
+// Bump when the layout of the cache file or the way the atlas is generated changes.
+static constexpr uint32_t CACHE_VERSION = 1;
+static const char CACHE_MAGIC[4] = { 'L', 'S', 'D', 'F' };
+
+struct GlyphAtlasCacheHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t pixelSize;
+    uint32_t spread;
+    uint32_t width;
+    uint32_t height;
+    uint64_t fontSize;
+    int64_t fontWriteTime;
+};
+
+
+bool GlyphAtlas::init(const std::string& fontPath, const std::string& cacheFolder, int pixelSize, int spread)
+{
+    if (!load(fontPath, cacheFolder, pixelSize, spread))
+        return false;
+
+    upload();
+    return true;
+}
+
+bool GlyphAtlas::load(const std::string& fontPath, const std::string& cacheFolder, int pixelSize, int spread)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    _pixelSize = pixelSize;
+    _spread = spread;
+
+    std::error_code ec;
+    FontStamp fontStamp;
+    fontStamp.size = std::filesystem::file_size(fontPath, ec);
+    fontStamp.writeTime = (long long)std::filesystem::last_write_time(fontPath, ec).time_since_epoch().count();
+
+    // e.g. Roboto-Medium.sdf32.cache
+    std::string cachePath;
+    if (!cacheFolder.empty())
+    {
+        std::filesystem::create_directories(cacheFolder, ec);
+        std::string fontName = std::filesystem::path(fontPath).stem().string();
+        cachePath = (std::filesystem::path(cacheFolder) / (fontName + ".sdf" + std::to_string(pixelSize) + ".cache")).string();
+    }
+
+    bool bFromCache = !cachePath.empty() && _loadCache(cachePath, fontStamp);
+    if (!bFromCache)
+    {
+        if (!_generate(fontPath))
+            return false;
+        if (!cachePath.empty())
+            _saveCache(cachePath, fontStamp);
+    }
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    spdlog::info("Glyph atlas {} px: {}x{}, {} in {:.1f} ms",
+                 pixelSize, _width, _height, bFromCache ? "loaded from cache" : "generated", ms);
+    return true;
+}
+
+bool GlyphAtlas::_generate(const std::string& fontPath)
+{
+    FT_Library ft;
+    FT_Face face;
+
+    if (FT_Init_FreeType(&ft)) {
+        spdlog::error("ERROR:FREETYPE Could not init FreeType library");
+        return false;
+    }
+
+    if (FT_New_Face(ft, fontPath.c_str(), 0, &face)) {
+        spdlog::error("ERROR:FREETYPE Failed to load font {}", fontPath);
+        FT_Done_FreeType(ft);
+        return false;
+    }
+
+    FT_Int spread = _spread;
+    FT_Property_Set(ft, "sdf", "spread", &spread);
+    FT_Set_Pixel_Sizes(face, 0, _pixelSize);
+
+    //---------------------------------------------------------------
+    // Rasterize all glyphs and find their place in the atlas
+    std::vector<unsigned char> bitmaps[NUM_GLYPHS];
+    glm::ivec2 positions[NUM_GLYPHS];
+
+    int x = GLYPH_PADDING;
+    int y = GLYPH_PADDING;
+    int rowHeight = 0;
+
+    for (int c = 0; c < NUM_GLYPHS; c++)
+    {
+        _glyphs[c] = Glyph();
+        positions[c] = glm::ivec2(0);
+
+        if (FT_Load_Glyph(face, FT_Get_Char_Index(face, c), FT_LOAD_DEFAULT)) {
+            spdlog::error("ERROR:FREETYPE Failed to load Glyph");
+            continue;
+        }
+
+        FT_GlyphSlot slot = face->glyph;
+        Glyph& g = _glyphs[c];
+        g.advance = (unsigned int)slot->advance.x;
+
+        // glyphs without an outline, e.g. space, have nothing to render
+        if (slot->outline.n_points == 0 || FT_Render_Glyph(slot, FT_RENDER_MODE_SDF))
+            continue;
+
+        g.size = glm::ivec2(slot->bitmap.width, slot->bitmap.rows);
+        g.bearing = glm::ivec2(slot->bitmap_left, slot->bitmap_top);
+
+        // bitmap rows can be padded; copy them tightly packed
+        bitmaps[c].resize(size_t(g.size.x) * g.size.y);
+        for (int row = 0; row < g.size.y; row++)
+            std::copy_n(slot->bitmap.buffer + row * slot->bitmap.pitch, g.size.x, bitmaps[c].data() + size_t(row) * g.size.x);
+
+        if (x + g.size.x + GLYPH_PADDING > ATLAS_WIDTH)
+        {
+            x = GLYPH_PADDING;
+            y += rowHeight + GLYPH_PADDING;
+            rowHeight = 0;
+        }
+        positions[c] = glm::ivec2(x, y);
+        x += g.size.x + GLYPH_PADDING;
+        rowHeight = std::max(rowHeight, g.size.y);
+    }
+
+    FT_Done_Face(face);
+    FT_Done_FreeType(ft);
+
+    _width = ATLAS_WIDTH;
+    _height = y + rowHeight + GLYPH_PADDING;
+
+    //---------------------------------------------------------------
+    // Copy glyphs into the atlas image
+    _image.assign(size_t(_width) * _height, 0);
+    for (int c = 0; c < NUM_GLYPHS; c++)
+    {
+        Glyph& g = _glyphs[c];
+        for (int row = 0; row < g.size.y; row++)
+            std::copy_n(bitmaps[c].data() + size_t(row) * g.size.x, g.size.x,
+                        _image.data() + size_t(positions[c].y + row) * _width + positions[c].x);
+
+        g.uvMin = glm::vec2(positions[c]) / glm::vec2(_width, _height);
+        g.uvMax = glm::vec2(positions[c] + g.size) / glm::vec2(_width, _height);
+    }
+
+    return true;
+}
+
+bool GlyphAtlas::_loadCache(const std::string& cachePath, const FontStamp& fontStamp)
+{
+    std::ifstream f(cachePath, std::ios::binary);
+    if (!f)
+        return false;
+
+    GlyphAtlasCacheHeader header;
+    if (!f.read((char*)&header, sizeof(header)))
+        return false;
+
+    if (memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+        header.version != CACHE_VERSION ||
+        header.pixelSize != uint32_t(_pixelSize) ||
+        header.spread != uint32_t(_spread) ||
+        header.fontSize != fontStamp.size ||
+        header.fontWriteTime != fontStamp.writeTime)
+    {
+        spdlog::info("Glyph atlas cache {} is out of date", cachePath);
+        return false;
+    }
+
+    _width = int(header.width);
+    _height = int(header.height);
+    _image.resize(size_t(_width) * _height);
+
+    if (!f.read((char*)_glyphs, sizeof(_glyphs)) || !f.read((char*)_image.data(), _image.size()))
+    {
+        spdlog::warn("Glyph atlas cache {} is truncated", cachePath);
+        return false;
+    }
+
+    return true;
+}
+
+void GlyphAtlas::_saveCache(const std::string& cachePath, const FontStamp& fontStamp)
+{
+    GlyphAtlasCacheHeader header;
+    memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = CACHE_VERSION;
+    header.pixelSize = uint32_t(_pixelSize);
+    header.spread = uint32_t(_spread);
+    header.width = uint32_t(_width);
+    header.height = uint32_t(_height);
+    header.fontSize = fontStamp.size;
+    header.fontWriteTime = fontStamp.writeTime;
+
+    // Write to a temporary file first, so that an interrupted write doesn't leave a broken cache behind.
+    std::string tempPath = cachePath + ".tmp";
+    bool bWritten = false;
+    {
+        std::ofstream f(tempPath, std::ios::binary | std::ios::trunc);
+        f.write((const char*)&header, sizeof(header));
+        f.write((const char*)_glyphs, sizeof(_glyphs));
+        f.write((const char*)_image.data(), _image.size());
+        f.close();
+        bWritten = bool(f);
+    }
+
+    std::error_code ec;
+    if (!bWritten) {
+        spdlog::warn("Couldn't write glyph atlas cache {}", tempPath);
+        std::filesystem::remove(tempPath, ec);
+        return;
+    }
+
+    std::filesystem::rename(tempPath, cachePath, ec);
+    if (ec)
+        spdlog::warn("Couldn't write glyph atlas cache {}: {}", cachePath, ec.message());
+}
+
+void GlyphAtlas::upload()
+{
+    if (_image.empty())         // load() failed
+        return;
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);      // no byte alignment restriction
+
+    glGenTextures(1, &_texture);
+    glBindTexture(GL_TEXTURE_2D, _texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, _width, _height, 0, GL_RED, GL_UNSIGNED_BYTE, _image.data());
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    _image.clear();
+    _image.shrink_to_fit();
+}
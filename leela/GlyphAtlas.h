@@ -0,0 +1,67 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+//
+// Glyphs of one font as signed distance fields, packed into a single texture.
+//  - Each texel holds the distance to the glyph's outline: 0.5 on the outline, larger inside.  The Font program
+//    thresholds it at 0.5, so edges stay sharp when glyphs are drawn larger or smaller than pixelSize(), and a
+//    single atlas serves all label sizes.
+//  - FreeType's SDF rasterizer is slow, so the atlas is generated once and cached in a file.  The cache is
+//    regenerated when the font file changes.
+//  - ASCII only (0 to 127), which is what labels use.
+//  - Glyphs are packed into rows with a pixel of padding around each, so that linear filtering doesn't pick up
+//    the neighbours.
+//
+class GlyphAtlas
+{
+public:
+    struct Glyph
+    {
+        glm::ivec2 size = glm::ivec2(0);        // size of glyph's bitmap, including `spread` on all sides
+        glm::ivec2 bearing = glm::ivec2(0);     // offset from baseline to top/left of glyph's bitmap
+        unsigned int advance = 0;               // offset to advance to next glyph, in 1/64 pixels
+        glm::vec2 uvMin = glm::vec2(0.0f);      // texture coordinates of the top left and bottom right corners
+        glm::vec2 uvMax = glm::vec2(0.0f);
+    };
+
+    static constexpr int NUM_GLYPHS = 128;
+
+    // Load the atlas of `fontPath` from its cache in `cacheFolder`, or generate it and write the cache.  No caching
+    // if `cacheFolder` is empty.  Metrics are in pixels of a font of `pixelSize`.  Needs a current GL context.
+    bool init(const std::string& fontPath, const std::string& cacheFolder, int pixelSize, int spread);
+
+    // init() in two steps.  load() makes no GL calls and can run on any thread; upload() needs the GL context.
+    bool load(const std::string& fontPath, const std::string& cacheFolder, int pixelSize, int spread);
+    void upload();
+
+    const Glyph& glyph(char c) const                { return _glyphs[(unsigned char)c < NUM_GLYPHS ? (unsigned char)c : '?']; }
+    GLuint texture() const                          { return _texture; }
+    glm::ivec2 textureSize() const                  { return glm::ivec2(_width, _height); }
+    int pixelSize() const                           { return _pixelSize; }
+    int spread() const                              { return _spread; }        // distance range of the field, in pixels
+
+private:
+    // Identifies the version of the font file a cache was generated from
+    struct FontStamp
+    {
+        unsigned long long size = 0;
+        long long writeTime = 0;
+    };
+
+    bool _generate(const std::string& fontPath);
+    bool _loadCache(const std::string& cachePath, const FontStamp& fontStamp);
+    void _saveCache(const std::string& cachePath, const FontStamp& fontStamp);
+
+private:
+    Glyph _glyphs[NUM_GLYPHS];
+    std::vector<unsigned char> _image;      // until uploaded
+    GLuint _texture = 0;
+    int _width = 0;
+    int _height = 0;
+    int _pixelSize = 0;
+    int _spread = 0;
+};
@@ -0,0 +1,211 @@
+#include "JobSystem.h"
+#include <algorithm>
+
+
+JobSystem::JobSystem(int numThreads)
+{
+    numThreads = std::max(numThreads, 1);
+
+    for (int i = 0; i < numThreads; i++)
+        _queues.push_back(std::make_unique<WorkQueue>());
+
+    // thread 0 is the caller of run()
+    for (int i = 1; i < numThreads; i++)
+        _workers.emplace_back(&JobSystem::_workerMain, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(_wakeMutex);
+        _bQuit = true;
+    }
+    _wakeCondition.notify_all();
+
+    for (std::thread& t : _workers)
+        t.join();
+}
+
+int JobSystem::defaultThreadCount()
+{
+    return std::max(int(std::thread::hardware_concurrency()), 1);
+}
+
+JobId JobSystem::add(std::function<void()> work, const std::vector<JobId>& dependencies)
+{
+    JobId id = JobId(_jobs.size());
+
+    auto job = std::make_unique<Job>();
+    job->work = std::move(work);
+    job->numDependencies = int(dependencies.size());
+    _jobs.push_back(std::move(job));
+
+    for (JobId dependency : dependencies)
+        _jobs[dependency]->dependents.push_back(id);
+
+    return id;
+}
+
+JobId JobSystem::addOnCallingThread(std::function<void()> work, const std::vector<JobId>& dependencies)
+{
+    JobId id = add(std::move(work), dependencies);
+    _jobs[id]->bCallingThread = true;
+    return id;
+}
+
+void JobSystem::run()
+{
+    if (_jobs.empty())
+        return;
+
+    // all counters must be set before the first job can start and decrement them
+    for (auto& job : _jobs)
+        job->pendingDependencies = job->numDependencies;
+    _remainingJobs = int(_jobs.size());
+
+    // Spread the initially ready jobs over all queues so that workers start without having to steal
+    int nextQueue = 0;
+    for (JobId id = 0; id < JobId(_jobs.size()); id++)
+    {
+        if (_jobs[id]->numDependencies == 0) {
+            _push(nextQueue, id);
+            if (!_jobs[id]->bCallingThread)
+                nextQueue = (nextQueue + 1) % numThreads();
+        }
+    }
+
+    if (!_workers.empty())
+    {
+        {
+            std::lock_guard<std::mutex> lock(_wakeMutex);
+            _runGeneration++;
+        }
+        _wakeCondition.notify_all();
+    }
+
+    _work(0);
+
+    // workers may still be on their way out of _work().  Don't touch the graph until they are.
+    while (_busyWorkers != 0)
+        std::this_thread::yield();
+
+    _jobs.clear();
+
+    if (_exception) {
+        std::exception_ptr e = _exception;
+        _exception = nullptr;
+        std::rethrow_exception(e);
+    }
+}
+
+void JobSystem::parallelFor(size_t count, size_t chunkSize, const std::function<void(size_t, size_t)>& work)
+{
+    chunkSize = std::max(chunkSize, size_t(1));
+
+    for (size_t begin = 0; begin < count; begin += chunkSize)
+    {
+        size_t end = std::min(begin + chunkSize, count);
+        add([&work, begin, end]() { work(begin, end); });
+    }
+    run();
+}
+
+void JobSystem::_workerMain(int threadIndex)
+{
+    unsigned seenGeneration = 0;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_wakeMutex);
+            _wakeCondition.wait(lock, [&]() { return _bQuit || _runGeneration != seenGeneration; });
+            if (_bQuit)
+                return;
+            seenGeneration = _runGeneration;
+            _busyWorkers++;
+        }
+
+        _work(threadIndex);
+        _busyWorkers--;
+    }
+}
+
+// Execute jobs until the whole graph is done.
+void JobSystem::_work(int threadIndex)
+{
+    while (_remainingJobs > 0)
+    {
+        JobId job;
+        if (_pop(threadIndex, job))
+            _execute(threadIndex, job);
+        else
+            std::this_thread::yield();              // remaining jobs are running elsewhere or waiting on dependencies
+    }
+}
+
+bool JobSystem::_pop(int threadIndex, JobId& job)
+{
+    // jobs pinned to the calling thread, oldest first
+    if (threadIndex == 0)
+    {
+        std::lock_guard<std::mutex> lock(_callingThreadQueue.mutex);
+        if (!_callingThreadQueue.jobs.empty()) {
+            job = _callingThreadQueue.jobs.front();
+            _callingThreadQueue.jobs.pop_front();
+            return true;
+        }
+    }
+
+    // own queue first, newest job
+    {
+        WorkQueue& q = *_queues[threadIndex];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (!q.jobs.empty()) {
+            job = q.jobs.back();
+            q.jobs.pop_back();
+            return true;
+        }
+    }
+
+    // steal the oldest job of another thread
+    for (int i = 1; i < numThreads(); i++)
+    {
+        WorkQueue& q = *_queues[(threadIndex + i) % numThreads()];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (!q.jobs.empty()) {
+            job = q.jobs.front();
+            q.jobs.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void JobSystem::_push(int threadIndex, JobId job)
+{
+    WorkQueue& q = _jobs[job]->bCallingThread ? _callingThreadQueue : *_queues[threadIndex];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    q.jobs.push_back(job);
+}
+
+void JobSystem::_execute(int threadIndex, JobId id)
+{
+    Job& job = *_jobs[id];
+    try {
+        job.work();
+    }
+    catch (...) {
+        std::lock_guard<std::mutex> lock(_exceptionMutex);
+        if (!_exception)
+            _exception = std::current_exception();
+    }
+
+    for (JobId dependent : job.dependents)
+    {
+        if (--_jobs[dependent]->pendingDependencies == 0)
+            _push(threadIndex, dependent);
+    }
+
+    _remainingJobs--;
+}
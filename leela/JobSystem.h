@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+typedef int JobId;
+
+//
+// Small work-stealing job system.
+//  - Jobs are added to a graph with add(), optionally depending on jobs added earlier, and all of them are
+//    executed by run().  A job becomes ready when all its dependencies have finished.
+//  - Each thread has its own queue.  Ready jobs are pushed to the queue of the thread that made them ready and
+//    popped from the back (most recent first, cache friendly).  Threads that run dry steal from the front of
+//    other threads' queues.
+//  - The thread calling run() works as thread 0, so JobSystem(1) runs everything on the calling thread.
+//  - Jobs added with addOnCallingThread() only ever run on thread 0, e.g. ones making OpenGL calls.  Thread 0
+//    runs them in the order they become ready, before any other job.
+//  - An exception thrown by a job doesn't stop the graph.  run() rethrows the first one after all jobs are done.
+//  - Not reentrant: jobs must not call add() or run().
+//
+class JobSystem
+{
+public:
+    explicit JobSystem(int numThreads = defaultThreadCount());
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    JobId add(std::function<void()> work, const std::vector<JobId>& dependencies = {});
+    JobId addOnCallingThread(std::function<void()> work, const std::vector<JobId>& dependencies = {});
+    void run();
+
+    // Split [0, count) into chunks of `chunkSize` and run `work(begin, end)` for all of them.
+    void parallelFor(size_t count, size_t chunkSize, const std::function<void(size_t, size_t)>& work);
+
+    int numThreads() const                          { return int(_queues.size()); }
+
+    static int defaultThreadCount();
+
+private:
+    struct Job
+    {
+        std::function<void()> work;
+        std::vector<JobId> dependents;
+        int numDependencies = 0;
+        bool bCallingThread = false;
+        std::atomic<int> pendingDependencies = 0;
+    };
+
+    struct WorkQueue
+    {
+        std::mutex mutex;
+        std::deque<JobId> jobs;
+    };
+
+    void _workerMain(int threadIndex);
+    void _work(int threadIndex);
+    bool _pop(int threadIndex, JobId& job);
+    void _push(int threadIndex, JobId job);
+    void _execute(int threadIndex, JobId job);
+
+private:
+    std::vector<std::unique_ptr<Job>> _jobs;
+    std::vector<std::unique_ptr<WorkQueue>> _queues;          // one per thread, including the calling thread
+    WorkQueue _callingThreadQueue;                            // jobs only thread 0 may run; never stolen
+    std::vector<std::thread> _workers;
+
+    std::mutex _wakeMutex;
+    std::condition_variable _wakeCondition;
+    unsigned _runGeneration = 0;                              // bumped by run() to wake workers
+    bool _bQuit = false;
+
+    std::mutex _exceptionMutex;
+    std::exception_ptr _exception;                            // first exception thrown by a job of this run
+
+    std::atomic<int> _remainingJobs = 0;
+    std::atomic<int> _busyWorkers = 0;
+};
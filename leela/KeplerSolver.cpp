@@ -0,0 +1,221 @@
+#include "KeplerSolver.h"
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+#include "spdlog/spdlog.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define KEPLER_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+
+// Wrap angle to [-pi, pi]
+static inline float _wrapAngle(float angle)
+{
+    return angle - float(2 * M_PI) * nearbyintf(angle / float(2 * M_PI));
+}
+
+float keplerSolveEccentricAnomaly(float meanAnomaly, float eccentricity)
+{
+    if (eccentricity == 0.0f)
+        return meanAnomaly;
+
+    float M = _wrapAngle(meanAnomaly);
+
+    // Danby's starting value converges for all eccentricities below 1
+    float E = M + 0.85f * eccentricity * (M < 0.0f ? -1.0f : 1.0f);
+
+    for (int i = 0; i < KEPLER_NEWTON_ITERATIONS; i++)
+    {
+        float f = E - eccentricity * sinf(E) - M;
+        float fp = 1.0f - eccentricity * cosf(E);
+        E -= f / fp;
+    }
+
+    // return in the same revolution as the given mean anomaly
+    return E + (meanAnomaly - M);
+}
+
+void keplerSolveScalar(const float* meanAnomaly, const float* eccentricity, float* eccentricAnomaly, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        eccentricAnomaly[i] = keplerSolveEccentricAnomaly(meanAnomaly[i], eccentricity[i]);
+}
+
+
+#ifdef KEPLER_USE_SSE2
+
+//----------------------------------------------------------------------------------------------
+// SSE2 helpers
+//----------------------------------------------------------------------------------------------
+
+static inline __m128 _select_ps(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline __m128 _wrapAngle_ps(__m128 angle)
+{
+    const __m128 twoPi = _mm_set1_ps(float(2 * M_PI));
+    const __m128 invTwoPi = _mm_set1_ps(float(1.0 / (2 * M_PI)));
+    __m128 k = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(angle, invTwoPi)));      // round to nearest
+    return _mm_sub_ps(angle, _mm_mul_ps(k, twoPi));
+}
+
+//
+// sin and cos of 4 angles at once.
+//  - Reduce to [-pi/4, pi/4] around the nearest multiple of pi/2 (3 part Cody-Waite reduction), evaluate
+//    minimax polynomials (same coefficients as cephes sinf/cosf) and fix up by quadrant.
+//  - Accurate to a few ulp for |x| up to a few thousand radians, which covers wrapped anomalies.
+//
+static inline void _sincos_ps(__m128 x, __m128* s, __m128* c)
+{
+    const __m128 twoOverPi = _mm_set1_ps(float(2.0 / M_PI));
+    const __m128 dp1 = _mm_set1_ps(2 * 0.78515625f);
+    const __m128 dp2 = _mm_set1_ps(2 * 2.4187564849853515625e-4f);
+    const __m128 dp3 = _mm_set1_ps(2 * 3.77489497744594108e-8f);
+
+    __m128i qi = _mm_cvtps_epi32(_mm_mul_ps(x, twoOverPi));
+    __m128 q = _mm_cvtepi32_ps(qi);
+
+    __m128 r = _mm_sub_ps(x, _mm_mul_ps(q, dp1));
+    r = _mm_sub_ps(r, _mm_mul_ps(q, dp2));
+    r = _mm_sub_ps(r, _mm_mul_ps(q, dp3));
+    __m128 z = _mm_mul_ps(r, r);
+
+    // sin(r) = r + r * z * (s3 + z * (s2 + z * s1))
+    __m128 sr = _mm_set1_ps(-1.9515295891e-4f);
+    sr = _mm_add_ps(_mm_mul_ps(sr, z), _mm_set1_ps(8.3321608736e-3f));
+    sr = _mm_add_ps(_mm_mul_ps(sr, z), _mm_set1_ps(-1.6666654611e-1f));
+    sr = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(sr, z), r), r);
+
+    // cos(r) = 1 - z/2 + z * z * (c3 + z * (c2 + z * c1))
+    __m128 cr = _mm_set1_ps(2.443315711809948e-5f);
+    cr = _mm_add_ps(_mm_mul_ps(cr, z), _mm_set1_ps(-1.388731625493765e-3f));
+    cr = _mm_add_ps(_mm_mul_ps(cr, z), _mm_set1_ps(4.166664568298827e-2f));
+    cr = _mm_mul_ps(_mm_mul_ps(cr, z), z);
+    cr = _mm_add_ps(_mm_sub_ps(cr, _mm_mul_ps(z, _mm_set1_ps(0.5f))), _mm_set1_ps(1.0f));
+
+    // quadrant q (mod 4):   0: ( sin r,  cos r)   1: ( cos r, -sin r)   2: (-sin r, -cos r)   3: (-cos r,  sin r)
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i two = _mm_set1_epi32(2);
+    __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(qi, one), one));
+    __m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(qi, two), 30));
+    __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(qi, one), two), 30));
+
+    *s = _mm_xor_ps(_select_ps(swap, cr, sr), sinSign);
+    *c = _mm_xor_ps(_select_ps(swap, sr, cr), cosSign);
+}
+
+// Solve 4 bodies.  Returns E in the same revolution as the given mean anomaly.
+static inline __m128 _solve_ps(__m128 meanAnomaly, __m128 e)
+{
+    const __m128 signBit = _mm_set1_ps(-0.0f);
+
+    __m128 M = _wrapAngle_ps(meanAnomaly);
+
+    // E0 = M + 0.85 * e * sign(M)
+    __m128 signM = _mm_or_ps(_mm_and_ps(M, signBit), _mm_set1_ps(1.0f));
+    __m128 E = _mm_add_ps(M, _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.85f), e), signM));
+
+    for (int i = 0; i < KEPLER_NEWTON_ITERATIONS; i++)
+    {
+        __m128 s, c;
+        _sincos_ps(E, &s, &c);
+        __m128 f = _mm_sub_ps(_mm_sub_ps(E, _mm_mul_ps(e, s)), M);
+        __m128 fp = _mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(e, c));
+        E = _mm_sub_ps(E, _mm_div_ps(f, fp));
+    }
+
+    return _mm_add_ps(E, _mm_sub_ps(meanAnomaly, M));
+}
+
+#endif
+
+
+void keplerSolveBatch(const float* meanAnomaly, const float* eccentricity, float* eccentricAnomaly, size_t count)
+{
+    size_t i = 0;
+
+#ifdef KEPLER_USE_SSE2
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 E = _solve_ps(_mm_loadu_ps(meanAnomaly + i), _mm_loadu_ps(eccentricity + i));
+        _mm_storeu_ps(eccentricAnomaly + i, E);
+    }
+#endif
+
+    // remainder (or everything, without SSE2)
+    keplerSolveScalar(meanAnomaly + i, eccentricity + i, eccentricAnomaly + i, count - i);
+}
+
+void keplerOrbitalPlanePositionsBatch(const float* meanAnomaly, const float* eccentricity, const float* semiMajorAxis,
+                                      float* x, float* y, size_t count)
+{
+    size_t i = 0;
+
+#ifdef KEPLER_USE_SSE2
+    const __m128 one = _mm_set1_ps(1.0f);
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 e = _mm_loadu_ps(eccentricity + i);
+        __m128 a = _mm_loadu_ps(semiMajorAxis + i);
+        __m128 E = _solve_ps(_mm_loadu_ps(meanAnomaly + i), e);
+
+        __m128 s, c;
+        _sincos_ps(E, &s, &c);
+        __m128 b = _mm_mul_ps(a, _mm_sqrt_ps(_mm_sub_ps(one, _mm_mul_ps(e, e))));
+        _mm_storeu_ps(x + i, _mm_mul_ps(a, _mm_sub_ps(c, e)));
+        _mm_storeu_ps(y + i, _mm_mul_ps(b, s));
+    }
+#endif
+
+    for (; i < count; i++)
+    {
+        float E = keplerSolveEccentricAnomaly(meanAnomaly[i], eccentricity[i]);
+        x[i] = semiMajorAxis[i] * (cosf(E) - eccentricity[i]);
+        y[i] = semiMajorAxis[i] * sqrtf(1.0f - eccentricity[i] * eccentricity[i]) * sinf(E);
+    }
+}
+
+
+void keplerRunBenchmark(size_t numBodies, int numRepetitions)
+{
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> anomalyDist(float(-4 * M_PI), float(4 * M_PI));
+    std::uniform_real_distribution<float> eccentricityDist(0.0f, 0.95f);
+
+    std::vector<float> M(numBodies), e(numBodies), scalarE(numBodies), batchE(numBodies);
+    for (size_t i = 0; i < numBodies; i++) {
+        M[i] = anomalyDist(rng);
+        e[i] = eccentricityDist(rng);
+    }
+
+    auto timeIt = [&](auto solve, std::vector<float>& out) {
+        solve(M.data(), e.data(), out.data(), numBodies);                    // warm up
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int r = 0; r < numRepetitions; r++)
+            solve(M.data(), e.data(), out.data(), numBodies);
+        std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+        return double(numBodies) * numRepetitions / elapsed.count();
+    };
+
+    double scalarRate = timeIt(keplerSolveScalar, scalarE);
+    double batchRate = timeIt(keplerSolveBatch, batchE);
+
+    // largest residual of Kepler's equation in the vector path
+    float maxResidual = 0.0f;
+    for (size_t i = 0; i < numBodies; i++)
+        maxResidual = std::max(maxResidual, fabsf(batchE[i] - e[i] * sinf(batchE[i]) - M[i]));
+
+    spdlog::info("Kepler solver benchmark: {} bodies x {} repetitions, {} Newton iterations",
+                 numBodies, numRepetitions, KEPLER_NEWTON_ITERATIONS);
+    spdlog::info("    scalar: {:.1f} M bodies/s", scalarRate / 1e6);
+    spdlog::info("    vector: {:.1f} M bodies/s  ({:.2f}x), max residual {:.2e}",
+                 batchRate / 1e6, batchRate / scalarRate, maxResidual);
+}
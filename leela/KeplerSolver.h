@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+
+//
+// Solves Kepler's equation  M = E - e * sin(E)  for eccentric anomaly E.
+//  - Angles are in radians.  Eccentricity must be in [0, 1).
+//  - All paths run the same fixed number of Newton iterations from Danby's starting value, so that
+//    every body costs the same and the batched path has no per-lane branches.
+//
+#define KEPLER_NEWTON_ITERATIONS        6
+
+// Single body
+float keplerSolveEccentricAnomaly(float meanAnomaly, float eccentricity);
+
+// Contiguous arrays of `count` bodies.  Scalar reference path (uses sinf/cosf).
+void keplerSolveScalar(const float* meanAnomaly, const float* eccentricity, float* eccentricAnomaly, size_t count);
+
+// Contiguous arrays of `count` bodies.  Vector path: SSE2 on x86/x64, 4 bodies per iteration.
+// Falls back to the scalar path on other architectures.
+void keplerSolveBatch(const float* meanAnomaly, const float* eccentricity, float* eccentricAnomaly, size_t count);
+
+// Solve and return positions in the orbital plane (periapsis along +x) for `count` bodies.
+//  - x = a * (cos(E) - e),  y = a * sqrt(1 - e^2) * sin(E)
+void keplerOrbitalPlanePositionsBatch(const float* meanAnomaly, const float* eccentricity, const float* semiMajorAxis,
+                                      float* x, float* y, size_t count);
+
+// Times scalar and vector paths over `numBodies` random orbits and logs bodies/second for each.
+void keplerRunBenchmark(size_t numBodies = 50000, int numRepetitions = 20);
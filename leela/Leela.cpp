@@ -17,6 +17,9 @@
 #include "ViewportBorderRenderer.h"
 
 #include <spdlog/spdlog.h>
+#include <chrono>
+#include <ctime>
+#include <filesystem>
 
 #define _USE_MATH_DEFINES
 #include <math.h>
@@ -116,6 +119,8 @@ void Leela::compileShaders()
 /*************************************************************************************************
  Initialize various parameters of planets, stars, etc.  Parameters include radius of objects,
  time periods of rotation and revolution, colors, etc.
+ Texture decoding, star generation and loading the minor body catalog are added to jobSystem along
+ with the uploads that need them.  The caller runs the jobs.
 **************************************************************************************************/
 void Leela::initSceneObjectsAndComponents()
 {
@@ -152,12 +157,14 @@ void Leela::initSceneObjectsAndComponents()
     }
 
 
+    std::vector<JobId> sphericalBodyJobs;
+
     //for (PlanetInfo pi : planetInfo)
     for (int i = 0; i < _numPlanetInfo; i++)
     {
         PlanetInfo &pi = _planetInfo[i];
 
-        SphericalBody * sb = new SphericalBody(pi.name);
+        SphericalBody * sb = new SphericalBody(pi.name, bodyStore);
         sb->setRotationParameters(pi.radius,
                                   glm::radians(pi.rotationAngle),
                                   pi.rotationAngularVelocity,
@@ -170,6 +177,7 @@ void Leela::initSceneObjectsAndComponents()
                                  glm::radians(pi.nodalPrecessionInitialAngle),
                                  glm::radians(pi.orbitalPlaneTiltAngle)
         );
+        sb->setOrbitShape(pi.eccentricity, glm::radians(pi.argumentOfPeriapsis));
         sb->setColor(pi.color);
 
         //------------------------------
@@ -203,6 +211,8 @@ void Leela::initSceneObjectsAndComponents()
             earth = sb;
             earthRenderer = planetRenderer;
             sphericalBodyRenderer->bShowOrbit = true;
+            if (!earthVirtualTextureFilename.empty())
+                earthRenderer->setVirtualTexture(earthVirtualTextureFilename);
 
             // TODO: We would rather create the lat-lon renderer here.  But if done so, its rotation angle isn't correct.
             //       It somehow seems to be dependent on some calculated variable in the sphere which gets updated
@@ -236,7 +246,10 @@ void Leela::initSceneObjectsAndComponents()
             sb->setSunSphere(sun);
 
         sb->addComponent(renderer);         // Spherical body now owns the renderer.
-        renderer->init();                   // construct spheres and send data to GPU
+
+        // decode textures on a worker, then construct vertices and send everything to GPU on this thread
+        JobId decode = jobSystem.add([sphericalBodyRenderer]() { sphericalBodyRenderer->decodeTextures(); });
+        sphericalBodyJobs.push_back(jobSystem.addOnCallingThread([renderer]() { renderer->init(); }, { decode }));
 
 
         // TODO: See todo above commented code that creates lat-lon renderer.
@@ -258,6 +271,8 @@ void Leela::initSceneObjectsAndComponents()
 
     }
 
+    jobSystem.addOnCallingThread([this]() { logStartupPhase("Spherical bodies sent to GPU"); }, sphericalBodyJobs);
+
     //----------------------------------------------------------------------
     
     // Set "related" sphere.  This can only be done after creating all spheres to ensure "related" sphere
@@ -272,20 +287,17 @@ void Leela::initSceneObjectsAndComponents()
                             );
         if (sb)
         {
-            // set related object.  Only 1 related object is supported at the moment.
+            // set related objects.  The ones whose shadow can reach this sphere are picked every frame.
             for (std::string relatedObjName : pi.relatedObjectNames)
             {
                 SphericalBody* relatedSphere =  dynamic_cast<SphericalBody*>(
                                                     SceneObject::getSceneObjectByName(&scene, relatedObjName)
                                                 );
                 
-                sb->setRelatedSphere(relatedSphere);
-
-                if (relatedSphere)
-                    printf("Setting %s as other sphere for %s", relatedSphere->_name.c_str(), sb->_name.c_str());
-                //spdlog::info("Setting {} as other sphere for {}", fmt::ptr(relatedSphere->_name.c_str()), fmt::ptr(sb->_name.c_str()));
-
-                break;      // shader supports only 1 related scene object
+                if (relatedSphere) {
+                    sb->addRelatedSphere(relatedSphere);
+                    spdlog::info("Setting {} as other sphere for {}", relatedSphere->_name, sb->_name);
+                }
             }
         }
         else {
@@ -341,7 +353,13 @@ void Leela::initSceneObjectsAndComponents()
     //---------------------------------------------------------------------------------------------------
     
     scene.addComponent(&starsRenderer);
-    starsRenderer.init();
+    JobId stars = jobSystem.add([this]() { starsRenderer.constructVertices(); });
+    jobSystem.addOnCallingThread([this]() {
+        starsRenderer.sendVerticesToGpu();
+        logStartupPhase("Stars sent to GPU");
+    }, { stars });
+
+    loadMinorBodyCatalog();
 
     //------------------------------------------------------------------------
     // Viewport-related
@@ -366,6 +384,45 @@ void Leela::initSceneObjectsAndComponents()
     SceneObject::printTree(&scene);
 }
 
+//
+// Load the asteroid catalog, if present, and draw it around the sun.
+//  - MPCORB.DAT can be downloaded from the Minor Planet Center.  It is converted to a binary cache on first load.
+//  - Distances are scaled so that 1 AU is earth's orbital radius in this scene.
+//  - Adds jobs to jobSystem: loading runs on a worker, the renderer is created on this thread afterwards.
+//
+void Leela::loadMinorBodyCatalog()
+{
+    JobId load = jobSystem.add([this]() {
+        std::vector<std::string> catalogDirs = {
+            "../../leela/catalogs",
+            "catalogs",
+        };
+
+        for (std::string catalogDir : catalogDirs)
+        {
+            if (minorBodyCatalog.load(catalogDir + "/MPCORB.DAT"))
+                break;
+        }
+    });
+
+    jobSystem.addOnCallingThread([this]() {
+        if (!minorBodyCatalog.isLoaded())
+            return;
+
+        minorBodiesRenderer = new MinorBodiesRenderer(minorBodyCatalog);
+        minorBodiesRenderer->setScale(earth->_orbitalRadius);
+        sun->addComponent(minorBodiesRenderer);
+        minorBodiesRenderer->init();
+        logStartupPhase("Minor bodies sent to GPU");
+    }, { load });
+}
+
+void Leela::logStartupPhase(const char* phase)
+{
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startupTime).count();
+    spdlog::info("Startup: {} at {:.1f} ms", phase, ms);
+}
+
 
 void Leela::printGlError()
 {
@@ -389,33 +446,101 @@ void Leela::printGlError()
     }
 }
 
-void Leela::_advanceSceneObject(SceneObject* sceneObject, float stepMultiplier)
+//
+// Bring the whole scene to the given absolute simulation time.
+//  - Can be used to jump to any time. Cost doesn't depend on how far the jump is.
+//
+void Leela::evaluateScene(double simulationTime)
 {
-    //----------------------------------------
-    // todo - eventually implement this without recursion
-    //----------------------------------------
+    float stepMultiplier = float(simulationTime - _simulationTime);
+    _simulationTime = simulationTime;
 
-    // Advance just the given scene object
-    sceneObject->advance(stepMultiplier);
+    // All body angles in one pass, then positions in parent-before-child order.
+    bodyStore.evaluateAt(_simulationTime, &jobSystem);
+    scene.invalidateTransforms();
 
-    // advance all compnents of this scene object
-    for (Component *c : sceneObject->_components)
+    for (const Scene::FlatNode& node : scene.flattened())
     {
-        c->advance(stepMultiplier);
+        SceneObject* sceneObject = node.object;
+        sceneObject->evaluateAt(_simulationTime);
+
+        for (Component* c : sceneObject->_components)
+        {
+            c->advance(stepMultiplier);
+        }
     }
 
-    // finally, advance each child scene object (recursively)
-    //  - advancing `this` (i.e. given scene object) first ensures children are advanced after parent.
-    for (SceneObject* obj : sceneObject->_childSceneObjects)
+    // Minor bodies only move when visible and when time has changed.  One earth revolution is a year.
+    if (bShowMinorBodies && minorBodyCatalog.isLoaded())
+    {
+        double days = _simulationTime * earth->orbitalAngularVelocity() * 365.25 / (2 * M_PI);
+        if (days != minorBodyCatalog.evaluatedTime())
+            minorBodyCatalog.evaluateAt(days, &jobSystem);
+    }
+}
+
+//
+// Move the simulation clock to the given time, e.g. to an eclipse.  Ticks continue from there.
+//
+void Leela::jumpToSimulationTime(double simulationTime)
+{
+    evaluateScene(simulationTime);
+    _bSimulationTimeJumped = true;
+}
+
+// Simulation steps in one revolution of the earth
+double Leela::stepsPerYear()
+{
+    return 2 * M_PI / earth->orbitalAngularVelocity();
+}
+
+//
+// Find all eclipses and transits in the next `years`, assuming bodies keep their current motions.
+//
+void Leela::searchEclipseEvents(double years)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+
+    EclipseSearch eclipseSearch;
+    eclipseSearch.capture(scene, bodyStore, _simulationTime);
+    eclipseEvents = eclipseSearch.search(_simulationTime, _simulationTime + years * stepsPerYear(), &jobSystem);
+
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+    eclipseSearchSeconds = elapsed.count();
+    spdlog::info("Found {} eclipses and transits in {} years in {:.2f} s", eclipseEvents.size(), years, eclipseSearchSeconds);
+}
+
+//
+// Jump the simulation to `leadSteps` before the first contact of the next event of the given type.
+//  - `occluder` and `target` restrict it to events between those bodies when not empty, e.g. transits of Mercury.
+//  - Returns false if there is none in the next 50 years.
+//
+bool Leela::jumpToNextEclipseEvent(EclipseEventType type, double leadSteps, const std::string& occluder, const std::string& target)
+{
+    EclipseSearch eclipseSearch;
+    eclipseSearch.capture(scene, bodyStore, _simulationTime);
+
+    for (const EclipseEvent& event : eclipseSearch.search(_simulationTime, _simulationTime + 50 * stepsPerYear(), &jobSystem,
+                                                          occluder, target))
     {
-        _advanceSceneObject(obj, stepMultiplier);
+        if (event.type == type && event.startTime - leadSteps > _simulationTime)
+        {
+            jumpToSimulationTime(event.startTime - leadSteps);
+            return true;
+        }
     }
 
+    spdlog::info("No {} found in the next 50 years", eclipseEventTypeName(type));
+    return false;
 }
 
-void Leela::advanceScene(float stepMultiplier)
+// Rotate a point around the sun (z axis) by how far the earth is from the given angle.  Used to keep demo camera
+// positions, written for one earth position, in the same place relative to the earth at another position.
+glm::vec3 Leela::rotatedWithEarth(glm::vec3 p, float referenceEarthAngle)
 {
-    _advanceSceneObject(&scene, stepMultiplier);
+    glm::vec3 e = earth->getCenter();
+    float angle = atan2f(e.y, e.x) - referenceEarthAngle;
+    return glm::rotate(glm::mat4(1.0f), angle, glm::vec3(0.0f, 0.0f, 1.0f)) * glm::vec4(p, 1.0f);
 }
 
 
@@ -453,7 +578,7 @@ void Leela::SetApplicationStartView()
 
     // Adjust navigation view locks on earth and sun
     SetLockTargetAndMode(earth, TargetLockMode_ViewTarget);
-    earth->bRevolutionMotion = true;
+    earth->motionFlags().bRevolutionMotion = true;
 }
 
 
@@ -781,12 +906,12 @@ void Leela::SimulationPause(int nParam)
 
 void Leela::Earth_RotationMotion(int nParam)
 {
-    ChangeBoolean(&earth->bRotationMotion, nParam);
+    ChangeBoolean(&earth->motionFlags().bRotationMotion, nParam);
 }
 
 void Leela::Earth_RevolutionMotion(int nParam)
 {
-    ChangeBoolean(&earth->bRevolutionMotion, nParam);
+    ChangeBoolean(&earth->motionFlags().bRevolutionMotion, nParam);
     //F_REFERENCE_VECTOR_ALONG_Z = 0;
     //bLockOntoEarth = false;
 }
@@ -796,12 +921,12 @@ void Leela::Earth_PrecessionMotion(int nParam)
 {
     if (nParam == UCmdParam_Reset)
     {
-        earth->bPrecessionMotion = false;
-        earth->_axisTiltOrientationAngle = glm::radians(0.0f);
+        earth->motionFlags().bPrecessionMotion = false;
+        earth->axisTiltOrientationAngle() = glm::radians(0.0f);
     }
     else
     {
-        ChangeBoolean(&earth->bPrecessionMotion, nParam);
+        ChangeBoolean(&earth->motionFlags().bPrecessionMotion, nParam);
     }
 }
 
@@ -828,7 +953,7 @@ void Leela::Moon_Orbit(int nParam)
 
 void Leela::Moon_ResetNodalPrecession()
 {
-    moon->_nodalPrecessionAngle = 0.0f;
+    moon->nodalPrecessionAngle() = 0.0f;
 }
 
 bool Leela::IsAnyOrbitVisible()
@@ -929,18 +1054,18 @@ void Leela::Moon_OrbitalPlaneRotation(int nParam)
 
     if (nParam == UCmdParam_Reset)
     {
-        moon->bOrbitalPlaneRotation = false;
-        moon->_nodalPrecessionAngle = glm::radians(0.0f);
+        moon->motionFlags().bOrbitalPlaneRotation = false;
+        moon->nodalPrecessionAngle() = glm::radians(0.0f);
     }
     else
     {
-        ChangeBoolean(&moon->bOrbitalPlaneRotation, nParam);
+        ChangeBoolean(&moon->motionFlags().bOrbitalPlaneRotation, nParam);
     }
 }
 
 void Leela::Moon_RevolutionMotion(int nParam)
 {
-    ChangeBoolean(&moon->bRevolutionMotion, nParam);
+    ChangeBoolean(&moon->motionFlags().bRevolutionMotion, nParam);
 }
 
 void Leela::SetDotDensity(int nParam)
@@ -1019,8 +1144,149 @@ void Leela::resetWidgetControlMode()
 // - Process flags set in response to key presses.
 // - Process mouse movements.
 //
+//
+// Advance the simulation clock by the wall clock time of the last frame.
+//  - Time is consumed in fixed ticks of 1/REFERENCE_FRAME_RATE seconds, so the simulation does the same thing
+//    at 30, 60 or 240 frames per second and a frame hitch doesn't change it.
+//  - At most MAX_SIMULATION_TICKS_PER_FRAME ticks run in one frame.  Time beyond that is dropped so that a long
+//    stall (e.g. dragging the window) doesn't make the simulation race to catch up.
+//  - The scene is evaluated once per frame at a time interpolated between the last two ticks.  State is a
+//    function of absolute time, so evaluating at the interpolated time is exact.
+//
+void Leela::advanceSimulation(double frameSeconds)
+{
+    ProfileScope profileScope(profiler, "advanceSimulation");
+
+    const double tickSeconds = 1.0 / REFERENCE_FRAME_RATE;
+
+    // Time was changed by a jump (demo, eclipse list, etc.).  Restart the tick clock from there.
+    if (_bSimulationTimeJumped)
+    {
+        _previousTickTime = _simulationTime;
+        _tickTime = _simulationTime;
+        _bSimulationTimeJumped = false;
+    }
+
+    _tickAccumulator += frameSeconds;
+
+    int ticks = 0;
+    while (_tickAccumulator >= tickSeconds)
+    {
+        if (ticks == MAX_SIMULATION_TICKS_PER_FRAME)
+        {
+            droppedSimulationTicks += unsigned(_tickAccumulator / tickSeconds);
+            _tickAccumulator = fmod(_tickAccumulator, tickSeconds);
+            break;
+        }
+
+        _previousTickTime = _tickTime;
+        simulationTick();
+        _tickAccumulator -= tickSeconds;
+        ticks++;
+    }
+    lastFrameSimulationTicks = ticks;
+
+    // - scene is evaluated even if paused.
+    //      - _filteredStepMultiplier will eventually become zero if simulation is paused.
+    // - positions/orientations etc. are calculated as part of evaluation (even if the time didn't change).
+    //      - This is necessary to draw updated objects if their are manipulated through ImGui widgets.
+    evaluateScene(glm::mix(_previousTickTime, _tickTime, _tickAccumulator / tickSeconds));
+}
+
+//
+// One fixed step of the simulation clock.  Time controls are filtered here, not per frame.
+//
+void Leela::simulationTick()
+{
+    float step_multiplier_input = 0.0f;
+
+    if (bSimulationPause) {
+        // When simulation is paused, allow for manual time forward and reverse using key/buttons.
+        // Filter the input for smooth start/stop.
+
+        step_multiplier_input = 0.0f;
+
+        if (bMinus) {
+            step_multiplier_input = -3 * _stepMultiplier / FIR_WIDTH;
+            if (bShiftModifier)
+                step_multiplier_input *= 5;
+        }
+        else {
+            if (bEquals) {
+                step_multiplier_input = 3 * _stepMultiplier / FIR_WIDTH;
+                if (bShiftModifier)
+                    step_multiplier_input *= 5;
+            }
+        }
+
+
+        if (bCtrlModifier)
+            step_multiplier_input /= 5;
+
+        _filteredStepMultiplier = stepMultiplierFilterWhenPaused.filter(step_multiplier_input);
+        stepMultiplierFilter.filter(0.0f);                  // feed zeros to filter that isn't being used.
+
+    } else {
+        // simulation is not paused.
+        // process time speed-up and slow-down flags.
+
+        stepMultiplierFilterWhenPaused.filter(0.0f);        // feed zeros to filter that isn't being used.
+
+        if (bEquals) {
+            step_multiplier_input = _stepMultiplier / 10.0f;
+            if (bShiftModifier)
+                step_multiplier_input *= 5;
+            if (bCtrlModifier)
+                step_multiplier_input /= 5;
+        }
+        else {
+            if (bMinus) {
+                step_multiplier_input = -_stepMultiplier / 10.0f;
+                if (bShiftModifier)
+                    step_multiplier_input *= 5;
+                if (bCtrlModifier)
+                    step_multiplier_input /= 5;
+            }
+            else {
+                step_multiplier_input = _stepMultiplier / 30.0;
+                // Don't use Shift modifier here or else using sideways shift movement using mouse would be impossible.
+                if (bCtrlModifier)
+                    step_multiplier_input /= 5;
+            }
+        }
+
+
+        _filteredStepMultiplier = stepMultiplierFilter.filter(step_multiplier_input);
+    }
+
+    //-------------------------------------
+    // Manual movement of earth and moon in their orbit.
+    // Intended to be used when simulation is paused or the earth/moon revolution is paused.
+    // Applied to the body angles once per tick.  The scene is evaluated after this frame's ticks, so the
+    // movement shows in this frame.
+    float inc = 0.003f;
+    if (bShiftModifier)
+        inc *= 10;
+
+    if (bAdvanceEarthInOrbit)
+        earth->orbitalAngle() += inc;
+    if (bRetardEarthInOrbit)
+        earth->orbitalAngle() -= inc;
+    if (bAdvanceMoonInOrbit)
+        moon->orbitalAngle() += inc;
+    if (bRetardMoonInOrbit)
+        moon->orbitalAngle() -= inc;
+    //-------------------------------------
+
+    // The filtered step multiplier only drives the rate of the simulation clock.  Scene state is
+    // evaluated from the absolute clock value.
+    _tickTime += _filteredStepMultiplier;
+}
+
 void Leela::processFlags()
 {
+    ProfileScope profileScope(profiler, "processFlags");
+
     //----------------------------------------------
     // First half of this method applies FIR filtering to various motion inputs.
     //----------------------------------------------
@@ -1033,10 +1299,10 @@ void Leela::processFlags()
     float yaw = 0.0f;
     float pitch = 0.0f;
     float roll = 0.0f;
-    float step_multiplier_input = 0.0f;
 
 
     // adjust gain w.r.t. current frame rate. Slower framerate result in higher gain to keep real-time behaviour same.
+    // Only navigation works per frame.  Simulation time is advanced in fixed ticks by simulationTick().
     float gain = 1.0f;
     float frameRate = ImGui::GetIO().Framerate;
     if (frameRate > 5)
@@ -1139,87 +1405,16 @@ void Leela::processFlags()
     new_mouse_wheel_throttle = 0.0f;
 
 
-    if (bSimulationPause) {
-        // When simulation is paused, allow for manual time forward and reverse using key/buttons.
-        // Filter the input for smooth start/stop.
-
-        step_multiplier_input = 0.0f;
-
-        if (bMinus) {
-            step_multiplier_input = -3 * _stepMultiplier / FIR_WIDTH;
-            if (bShiftModifier)
-                step_multiplier_input *= 5;
-        }
-        else {
-            if (bEquals) {
-                step_multiplier_input = 3 * _stepMultiplier / FIR_WIDTH;
-                if (bShiftModifier)
-                    step_multiplier_input *= 5;
-            }
-        }
-
-
-        if (bCtrlModifier)
-            step_multiplier_input /= 5;
-
-        _filteredStepMultiplier = stepMultiplierFilterWhenPaused.filter(step_multiplier_input);
-        stepMultiplierFilter.filter(0.0f);                  // feed zeros to filter that isn't being used.
-
-    } else {
-        // simulation is not paused.
-        // process time speed-up and slow-down flags.
-
-        stepMultiplierFilterWhenPaused.filter(0.0f);        // feed zeros to filter that isn't being used.
-
-        if (bEquals) {
-            step_multiplier_input = _stepMultiplier / 10.0f;
-            if (bShiftModifier)
-                step_multiplier_input *= 5;
-            if (bCtrlModifier)
-                step_multiplier_input /= 5;
-        }
-        else {
-            if (bMinus) {
-                step_multiplier_input = -_stepMultiplier / 10.0f;
-                if (bShiftModifier)
-                    step_multiplier_input *= 5;
-                if (bCtrlModifier)
-                    step_multiplier_input /= 5;
-            }
-            else {
-                step_multiplier_input = _stepMultiplier / 30.0;
-                // Don't use Shift modifier here or else using sideways shift movement using mouse would be impossible.
-                if (bCtrlModifier)
-                    step_multiplier_input /= 5;
-            }
-        }
-
-
-        _filteredStepMultiplier = stepMultiplierFilter.filter(step_multiplier_input);
-    }
-
-    // - advance is called even if scene is paused.
-    //      - _filteredStepMultiplier will eventually become zero if simulation is paused.
-    // - positions/orientations etc. are calculated as part of advancing (even if the increment is zero).
-    //      - This is necessary to draw updated objects if their are manipulated through ImGui widgets.
-    advanceScene(_filteredStepMultiplier * _stepMultiplierFrameRateAdjustment);
-
     //-------------------------------------
-    // Manual movement of earth and moon in their orbit.
-    // Intended to be used when simulation is paused or the earth/moon revolution is paused.
-    float inc = 0.003f;
-    if (bShiftModifier)
-        inc *= 10;
-
-    if (bAdvanceEarthInOrbit)
-        earth->_orbitalAngle += inc;
-    if (bRetardEarthInOrbit)
-        earth->_orbitalAngle -= inc;
-    if (bAdvanceMoonInOrbit)
-        moon->_orbitalAngle += inc;
-    if (bRetardMoonInOrbit)
-        moon->_orbitalAngle -= inc;
+    // Advance the simulation clock in fixed ticks.
     //-------------------------------------
+    Uint64 frameCounter = SDL_GetPerformanceCounter();
+    double frameSeconds = 0.0;
+    if (_lastFrameCounter != 0)
+        frameSeconds = double(frameCounter - _lastFrameCounter) / SDL_GetPerformanceFrequency();
+    _lastFrameCounter = frameCounter;
+
+    advanceSimulation(frameSeconds);
 
     if (bEarthSurfaceLockMode)
     {
@@ -1380,6 +1575,9 @@ int Leela::runMainLoop()
 
     while (1)
     {
+        profiler.beginFrame();
+        profiler.begin("Events");
+
         while (SDL_PollEvent(&event))
         {
             // Always send mouse & keyboard events to ImGui
@@ -1463,39 +1661,84 @@ int Leela::runMainLoop()
 
         } // while SDL event poll
 
+        lastFrameTransformCacheStats = SceneObject::takeTransformCacheStats();
+        lastFrameRenderListStats = renderListStats;
+        renderListStats = RenderListStats();
+        lastFrameUniformUploads = GlslProgram::uniformUploads;
+        GlslProgram::uniformUploads = 0;
+        lastFrameSphereTrianglesDrawn = sphereTrianglesDrawn;
+        lastFrameCullStats = cullStats;
+        cullStats = CullStats();
+        lastFrameTextGlyphs = textBatch.glyphs();
+        lastFrameTextDrawCalls = textBatch.drawCalls();
+        textBatch.resetStats();
+        sphereTrianglesDrawn = 0;
+
+        profiler.end();
+
+        profiler.begin("ImGui widgets");
         generateImGuiWidgets();
+        profiler.end();
 
         if (bQuit)
             break;
 
         doubleClicked.tick();
         processFlags();
-        render();
 
-        {
-            GLint renderbufferID;
-            GLint depthSize;
-            glGetFramebufferAttachmentParameteriv(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_FRAMEBUFFER_ATTACHMENT_OBJECT_NAME, &renderbufferID);
-
-            glBindRenderbuffer(GL_RENDERBUFFER, renderbufferID);
-            glGetRenderbufferParameteriv(GL_RENDERBUFFER, GL_RENDERBUFFER_DEPTH_SIZE, &depthSize);
-            glBindRenderbuffer(GL_RENDERBUFFER, 0);
-
-            std::cout << "Depth buffer size: " << depthSize << " bits" << std::endl;
-        }
+        profiler.begin("Texture streaming");
+        textureStreamer.update();
+        if (earthRenderer && earthRenderer->_virtualTexture)
+            earthRenderer->_virtualTexture->update();
+        profiler.end();
 
+        profiler.begin("render");
+        render();
+        profiler.end();
 
+        profiler.begin("ImGui draw");
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        profiler.end();
 
+        profiler.begin("Swap");
         SDL_GL_SwapWindow(window);
+        profiler.end();
+
+        profiler.endFrame();
+
+        if (!bFirstFrameLogged) {
+            logStartupPhase("First frame");
+            bFirstFrameLogged = true;
+        }
     }
 
     return 0;
 
 }
 
+// Last few seconds of the profiler, as leela-<date>-<time>.json in the trace folder.  Open it in chrome://tracing
+// or Perfetto.
+void Leela::writeProfilerTrace()
+{
+    std::error_code ec;
+    std::filesystem::create_directories(traceFolderPath, ec);
+
+    std::time_t now = std::time(nullptr);
+    std::tm local;
+#ifndef _WIN32
+    localtime_r(&now, &local);
+#else
+    localtime_s(&local, &now);
+#endif
+    char fileName[64];
+    std::strftime(fileName, sizeof(fileName), "leela-%Y%m%d-%H%M%S.json", &local);
+
+    profiler.writeChromeTrace((std::filesystem::path(traceFolderPath) / fileName).string());
+}
+
 int Leela::run()
 {
+    startupTime = std::chrono::steady_clock::now();
     setvbuf(stdout, 0, _IONBF, 0);
     const char* glsl_version = "#version 330";
 
@@ -1517,6 +1760,15 @@ int Leela::run()
 
 
     glewInit();
+    logStartupPhase("Created window and GL context");
+
+    textureCache.cacheFolder = cacheFolderPath;
+    if (bCompressTextures && !GLEW_EXT_texture_compression_s3tc) {
+        spdlog::warn("S3TC texture compression isn't supported.  Using uncompressed textures.");
+        bCompressTextures = false;
+    }
+    textureCache.format = bCompressTextures ? TextureFormat::BC1 : TextureFormat::RGB8;
+    profiler.init();
 
     // Setup Dear ImGui context
     IMGUI_CHECKVERSION();
@@ -1549,6 +1801,8 @@ int Leela::run()
     ImGui_ImplSDL2_InitForOpenGL(window, context);
     ImGui_ImplOpenGL3_Init(glsl_version);
 
+    logStartupPhase("ImGui initialized");
+
     createFontCharacterTexture();
 
     SDL_GetWindowSize(window, &curWidth, &curHeight);
@@ -1578,8 +1832,22 @@ int Leela::run()
     int retval = 0;
     try
     {
-        compileShaders();
+        //
+        // Startup job graph.  CPU work (sphere meshes, texture decoding, glyph atlas, stars, minor body catalog) runs
+        // on jobSystem's workers.  GL calls stay on this thread: shaders are compiled while the workers get going, and
+        // each upload runs as soon as the data it needs is ready.
+        //
+        jobSystem.addOnCallingThread([this]() {
+            compileShaders();
+            frameUniformBuffer.init();
+            logStartupPhase("Shaders compiled");
+        });
+        SphereMesh::buildLodChain(jobSystem);
         initSceneObjectsAndComponents();
+        logStartupPhase("Scene objects created");
+
+        jobSystem.run();
+        logStartupPhase("Startup jobs done");
         printf("done\n");
 
         glEnable(GL_DEPTH_TEST);
@@ -18,6 +18,10 @@
 #include "LatLonRenderer.h"
 #include "Stars.h"
 #include "StarsRenderer.h"
+#include "MinorBodiesRenderer.h"
+#include "MinorBodyCatalog.h"
+#include "JobSystem.h"
+#include "EclipseSearch.h"
 #include "Space.h"
 #include "Fir.h"
 #include <fstream>
@@ -25,14 +29,20 @@
 #include <string>
 #include "map"
 #include <stack>
+#include <chrono>
 #include "UniverseMinimal.h"
 #include "ViewportSceneObject.h"
 
 #include "imgui.h"
 #include "OneShotTimer.h"
 #include "GlslProgram.h"
-#include <ft2build.h>
-#include FT_FREETYPE_H
+#include "GlslUniforms.h"
+#include "FrameUniformBuffer.h"
+#include "GlyphAtlas.h"
+#include "Profiler.h"
+#include "TextBatch.h"
+#include "TextureCache.h"
+#include "TextureStreamer.h"
 
 
 #include <spdlog/spdlog.h>
@@ -46,14 +56,6 @@ constexpr auto FIR_WIDTH = 100;
 #define RELEASE_BUILD
 //#define USE_ICOSPHERE
 
-struct Character {
-    unsigned int textureID;     // ID handle of the glyph texture
-    glm::ivec2 size;            // size of glyph
-    glm::ivec2 bearing;         // offset from baseline to top/left of glyph
-    unsigned int advance;       // offset to advance to next glyph
-};
-
-
 class Action
 {
 public:
@@ -233,6 +235,19 @@ typedef enum
 class Leela;
 class Space;
 
+struct RenderListEntry
+{
+    Renderer* renderer;
+    int node;                                       // index of the renderer's scene object in scene.flattened()
+};
+
+struct NodeBounds
+{
+    BoundingSphere body;                            // SceneObject::bodyBounds()
+    BoundingSphere drawn;                           // SceneObject::drawnBounds(); unbounded if a renderer draws outside it
+    BoundingSphere subtree;                         // drawn bounds of the node and all its descendants
+};
+
 //-----------------------------------------
 // Globally available handles
 //-----------------------------------------
@@ -261,14 +276,21 @@ public:
     void renderAllStages(ViewportType viewportType);
     void renderUsingAllShaderPrograms(ViewportType viewportType, RenderStage renderStage);
     bool setupViewport(ViewportType viewportType);
-    void renderSceneUsingGlslProgram(RenderStage renderStage, GlslProgram& glslProgram, ViewportType viewportType);
-    void renderSceneObjectUsingGlslProgram(SceneObject* sceneObject, RenderStage renderStage, GlslProgram& glslProgram, ViewportType viewportType);
-    void RenderText(GlslProgram& glslProgram, RenderTextType renderType, std::string text, float x, float y, float z, float scale, glm::vec3 color);
+    void renderSceneUsingGlslProgram(RenderStage renderStage, int programIndex, ViewportType viewportType);
+    void buildRenderLists();
+    unsigned int updateNodeVisibility();
+    void updateNodeBounds();
+    void updateShadowCasters();
+    void cullScene(ViewportType viewportType);
+    std::vector<RenderListEntry>& renderList(ViewportType viewportType, RenderStage renderStage, int programIndex);
+    void RenderText(const glm::mat4& projection, RenderTextType renderType, std::string text, float x, float y, float z, float scale, glm::vec3 color);
 
     void constructFontInfrastructureAndSendToGpu();
 
     void compileShaders();
     void initSceneObjectsAndComponents();
+    void loadMinorBodyCatalog();
+    void logStartupPhase(const char* phase);
     void printGlError();
 
     void ChangeSidewaysMotionMode();
@@ -324,8 +346,14 @@ public:
 
     void ChangeBoolean(bool *pBool, int nParam);
 
-    void _advanceSceneObject(SceneObject * sceneObject, float stepMultiplier);
-    void advanceScene(float stepMultiplier);
+    void evaluateScene(double simulationTime);
+    void jumpToSimulationTime(double simulationTime);
+    void advanceSimulation(double frameSeconds);
+    void simulationTick();
+    double stepsPerYear();
+    void searchEclipseEvents(double years);
+    bool jumpToNextEclipseEvent(EclipseEventType type, double leadSteps, const std::string& occluder = "", const std::string& target = "");
+    glm::vec3 rotatedWithEarth(glm::vec3 p, float referenceEarthAngle);
 
     void onKeyDown(SDL_Event* event);
     void onKeyUp(SDL_Event* event);
@@ -368,7 +396,17 @@ public:
     int previousY = 0;
     float _stepMultiplier = 1.0f;
     float _filteredStepMultiplier = 0.0f;
-    float _stepMultiplierFrameRateAdjustment = 0.0f;
+    double _simulationTime = 0.0;                   // absolute simulation time in reference frame steps. Rate is driven by _filteredStepMultiplier.
+
+    // Fixed timestep simulation clock.  Ticks run at REFERENCE_FRAME_RATE regardless of the display's frame rate.
+    // The scene is rendered at a time interpolated between the last two ticks.
+    double _previousTickTime = 0.0;                 // simulation time at the previous and the latest tick
+    double _tickTime = 0.0;
+    double _tickAccumulator = 0.0;                  // wall clock seconds not yet consumed by ticks
+    bool _bSimulationTimeJumped = false;            // set by jumpToSimulationTime(); the tick clock restarts from there
+    Uint64 _lastFrameCounter = 0;
+    int lastFrameSimulationTicks = 0;
+    unsigned droppedSimulationTicks = 0;            // ticks skipped because of the catch-up cap
 
     bool bMinus = false;
     bool bEquals = false;
@@ -385,6 +423,7 @@ public:
     bool bRotateLeftSd = false;
 
     const float REFERENCE_FRAME_RATE = 60.0f;
+    const int MAX_SIMULATION_TICKS_PER_FRAME = 8;   // after a long hitch, simulation time is dropped rather than caught up
 
 
     const float noYaw               = 0.0f;
@@ -443,6 +482,7 @@ public:
     bool bSidewaysMotionMode = true;
 
     bool bGalaxyStars = false;
+    bool bShowMinorBodies = true;
     bool bShowAxis = true;
     bool bShowPlanetAxis = false;
     bool bShowOrbitsGlobalEnable = true;           // Individual orbit enables are in respective renderer classes.
@@ -491,14 +531,24 @@ public:
     GLuint tex1 = 0;
     GLuint tex2 = 0;
 
-    GLuint fontVao, largeFontVao = 0;
-    GLuint fontVbo, largeFontVbo = 0;
+    std::string cacheFolderPath;                    // data generated once and kept between runs.  Set by main().
+    std::chrono::steady_clock::time_point startupTime;      // when run() started; for logging the time to first frame
+    bool bFirstFrameLogged = false;
+
+    // Labels.  RenderText() adds to textBatch, which is drawn at the end of each Font program pass.
+    GlyphAtlas glyphAtlas;                          // signed distance fields; any label size is drawn from it
+    TextBatch textBatch;
+    unsigned int lastFrameTextGlyphs = 0;
+    unsigned int lastFrameTextDrawCalls = 0;
 
-    FT_Library ft;
-    FT_Face face;
+    TextureCache textureCache;                      // planet textures, baked once and memory mapped after that
+    TextureStreamer textureStreamer;                // planet textures arrive over several frames
+    bool bCompressTextures = false;                 // bake textures as BC1.  Set by main().
+    std::string earthVirtualTextureFilename;        // high resolution earth map drawn as a virtual texture.  Set by main().
 
-    std::map<char, Character> characters = {};
-    std::map<char, Character> largeCharacters = {};
+    Profiler profiler;
+    std::string traceFolderPath;                    // where F12 writes profiler traces.  Set by main().
+    void writeProfilerTrace();
 
 
     GLint uniOverrideColor;
@@ -518,7 +568,10 @@ public:
     SphericalBody* moon = nullptr;
     Stars stars;
 
+    JobSystem jobSystem;            // worker threads for evaluating large numbers of bodies, and for startup
+    BodyStore bodyStore;            // orbital/rotational state of all spherical bodies
     Scene scene;
+    SceneObject::TransformCacheStats lastFrameTransformCacheStats;
 
     SunRenderer *sunRenderer = nullptr;
     PlanetRenderer *earthRenderer = nullptr;
@@ -528,6 +581,11 @@ public:
     LatLonRenderer* earthLatLonRenderer = nullptr;
 
     StarsRenderer starsRenderer;
+
+    MinorBodyCatalog minorBodyCatalog;                      // asteroids. Empty if no catalog file was found.
+    MinorBodiesRenderer* minorBodiesRenderer = nullptr;
+    size_t residentMemoryBytes = 0;                         // shown with the catalog; sampled twice a second
+    std::chrono::steady_clock::time_point residentMemorySampleTime;
     MonthLabelsRenderer* monthLabelsRenderer;        // for earth
 
     Space space;
@@ -539,6 +597,45 @@ public:
     std::vector<float> gstarVertices;
 
     std::vector<GlslProgram*> shaderPrograms;
+    FrameUniformBuffer frameUniformBuffer;          // camera and sun of the viewport being rendered
+
+    // Renderers that draw in each (viewport, stage, shader program) slot, in scene order.  Built from
+    // Renderer::rendersIn() when the scene topology changes, so that rendering only visits renderers that
+    // have something to draw instead of walking the scene for every combination.
+    std::vector<std::vector<RenderListEntry>> renderLists;
+    unsigned int renderListsTopologyGeneration = 0;
+    std::vector<char> nodeVisible;                  // per node of scene.flattened(); false if it or an ancestor is hidden
+
+    struct RenderListStats
+    {
+        unsigned int renderCalls = 0;               // virtual render() calls made
+        unsigned int sceneWalkRenderCalls = 0;      // calls that walking the scene for every combination would have made
+    };
+    RenderListStats renderListStats;
+    RenderListStats lastFrameRenderListStats;
+    unsigned int lastFrameUniformUploads = 0;
+
+    // Culling of scene objects against the view frustum and against opaque spheres.  See cullScene().
+    bool bCulling = true;
+    std::vector<NodeBounds> nodeBounds;             // per node of scene.flattened()
+    std::vector<char> nodeInView;                   // per node; visible and not culled in the viewport being drawn
+    std::vector<std::pair<BoundingSphere, SceneObject*>> occluders;
+
+    struct CullStats
+    {
+        unsigned int objectsCulled = 0;             // objects none of whose renderers were called
+        unsigned int bodiesOutsideView = 0;         // bodies not drawn; their orbits etc. might still be
+        unsigned int bodiesOccluded = 0;
+        unsigned int shadowCasters = 0;             // related spheres whose shadow can reach the body; given to the shader
+        unsigned int shadowCastersCulled = 0;       // related spheres whose shadow can't
+    };
+    CullStats cullStats;
+    CullStats lastFrameCullStats;
+
+    // Sphere level of detail.  See SphereMesh::selectLod().
+    float sphereLodPixelError = 0.5f;               // largest distance in pixels of a sphere's triangles from its true surface
+    unsigned int sphereTrianglesDrawn = 0;
+    unsigned int lastFrameSphereTrianglesDrawn = 0;
 
     // Realistic day/night shading, shadow shading.
     // Effect on day & nights:
@@ -546,6 +643,7 @@ public:
     //   When true, night hemisphere will be smaller than depending on the size of the sun.
     bool bRealisticShading = true;
     bool bRealisticSurfaces = true;
+    bool bPerFragmentShading = true;                // day/night and eclipse shading per pixel rather than per vertex
 
     ActionMap actionMap;
 
@@ -559,6 +657,7 @@ public:
     bool bShowFlagsOverlay = true;
     bool bShowMouseNavigationHelp = false;
     bool bShowKeyboardShortcuts = false;
+    bool bShowProfiler = false;
     bool bShowIntroduction = false;
 
     ImFont *appFontExtraSmall = nullptr;
@@ -579,6 +678,11 @@ public:
 
     std::string logString = "";
 
+    // Eclipse & transit search results shown in the control panel
+    std::vector<EclipseEvent> eclipseEvents;
+    float eclipseSearchYears = 100.0f;
+    double eclipseSearchSeconds = 0.0;
+
 
 };
 
@@ -11,28 +11,9 @@ void Leela::ShowDemo(int nParam)
 
         clearAllFirFilters();
 
-        // Set earth at (0,R,0)
-        Earth_SetOrbitalPositionAngle(1 * M_PI / 2);
-
         Earth_OrbitalPlane(UCmdParam_Off);
         Moon_OrbitalPlane(UCmdParam_Off);
 
-        // Adjust navigation view locks on earth and sun
-        
-        SetLockTargetAndMode(earth, TargetLockMode_ViewTarget);
-
-        // Set S
-        //newS = PNT(earth.getCenter().x + 500, earth.getCenter().y - 700, earth.getCenter().z + 150);
-        newS = PNT(-262.135429, 2403.108632, 54.783701);
-        space.setFrame(AT_POINT,
-            newS,
-            VECTOR(newS, earth->getCenter()),
-            PNT(newS.x, newS.y, newS.z - 100));
-
-        /* Set proper moon's position so that the moon's shadow will
-           fall on the earth shortly */
-        Moon_SetOrbitalPositionAngle(-3.2f * M_PI / 5);
-
         // Adjust earth's motions
         Earth_RotationMotion(UCmdParam_On);
         Earth_RevolutionMotion(UCmdParam_On);
@@ -43,6 +24,25 @@ void Leela::ShowDemo(int nParam)
         Moon_Orbit(UCmdParam_On);
         Moon_ResetNodalPrecession();
 
+        // Go to shortly before the moon's shadow reaches the earth. Motions must be set up before searching.
+        if (!jumpToNextEclipseEvent(EclipseEventType_TotalSolarEclipse, 10.0))
+        {
+            Earth_SetOrbitalPositionAngle(1 * M_PI / 2);
+            Moon_SetOrbitalPositionAngle(-3.2f * M_PI / 5);
+        }
+
+        // Adjust navigation view locks on earth and sun
+        
+        SetLockTargetAndMode(earth, TargetLockMode_ViewTarget);
+
+        // Set S.  Found with earth at (0,R,0); rotate it to where the earth is now.
+        //newS = PNT(earth.getCenter().x + 500, earth.getCenter().y - 700, earth.getCenter().z + 150);
+        newS = rotatedWithEarth(glm::vec3(-262.135429, 2403.108632, 54.783701), float(M_PI / 2));
+        space.setFrame(AT_POINT,
+            newS,
+            VECTOR(newS, earth->getCenter()),
+            PNT(newS.x, newS.y, newS.z - 100));
+
         // Increase the dot density
         SetDotDensity(UDotDensity_High);
         SetSimulationSpeed(USimulationSpeed_6p25_Percent);
@@ -191,28 +191,9 @@ void Leela::ShowDemo(int nParam)
 
         clearAllFirFilters();
 
-        // Set earth at (0,R,0)
-        Earth_SetOrbitalPositionAngle(M_PI / 2);
-
         Earth_OrbitalPlane(UCmdParam_On);
         Moon_OrbitalPlane(UCmdParam_Off);
 
-        // Adjust navigation view locks on earth and sun
-        SetLockTargetAndMode(earth, TargetLockMode_ViewTarget);
-
-        // Set S
-        //newS = PNT(earth.getCenter().x + 500, earth.getCenter().y - 700, earth.getCenter().z + 150);
-        newS = PNT(-452.441935, 1933.795838, 265.271073);
-        space.setFrame(AT_POINT,
-            newS,
-            VECTOR(newS, earth->getCenter()),
-            PNT(newS.x, newS.y, newS.z - 100));
-
-        /* Set proper moon's position so that the moon's shadow will
-           fall on the earth shortly */
-        Moon_SetOrbitalPositionAngle(0.96 * M_PI / 2);
-        Earth_SetOrbitalPositionAngle(1.24f * M_PI / 2);
-
         // Adjust earth's motions
         Earth_RotationMotion(UCmdParam_On);
         Earth_RevolutionMotion(UCmdParam_On);
@@ -223,6 +204,24 @@ void Leela::ShowDemo(int nParam)
         Moon_Orbit(UCmdParam_On);
         Moon_ResetNodalPrecession();
 
+        // Go to shortly before the moon enters the earth's penumbra
+        if (!jumpToNextEclipseEvent(EclipseEventType_PartialLunarEclipse, 10.0))
+        {
+            Moon_SetOrbitalPositionAngle(0.96 * M_PI / 2);
+            Earth_SetOrbitalPositionAngle(1.24f * M_PI / 2);
+        }
+
+        // Adjust navigation view locks on earth and sun
+        SetLockTargetAndMode(earth, TargetLockMode_ViewTarget);
+
+        // Set S.  Found with earth at 1.24 * 90 degrees; rotate it to where the earth is now.
+        //newS = PNT(earth.getCenter().x + 500, earth.getCenter().y - 700, earth.getCenter().z + 150);
+        newS = rotatedWithEarth(glm::vec3(-452.441935, 1933.795838, 265.271073), 1.24f * float(M_PI) / 2);
+        space.setFrame(AT_POINT,
+            newS,
+            VECTOR(newS, earth->getCenter()),
+            PNT(newS.x, newS.y, newS.z - 100));
+
         // Increase the dot density
         SetDotDensity(UDotDensity_High);
         SetSimulationSpeed(USimulationSpeed_6p25_Percent);
@@ -462,9 +461,9 @@ void Leela::ShowDemo(int nParam)
         bShowAxis = false;          // turn off coordinate axis
 
         Moon_OrbitalPlane(UCmdParam_On);
-        moon->_nodalPrecessionAngle = -1.025973;
-        moon->bNodalPrecessionSpeedSyncToParentsRevolution = true;
-        moon->bOrbitalRevolutionSyncToParent = true;
+        moon->nodalPrecessionAngle() = -1.025973;
+        moon->motionFlags().bNodalPrecessionSpeedSyncToParentsRevolution = true;
+        moon->motionFlags().bOrbitalRevolutionSyncToParent = true;
 
         Earth_RevolutionMotion(UCmdParam_Off);              // pause earth
         Earth_SetOrbitalPositionAngle(0.437745);
@@ -529,15 +528,6 @@ void Leela::ShowDemo(int nParam)
 
         clearAllFirFilters();
 
-        newS = PNT(3062.437918, -1366.079160, 91.954525);
-        newD = PNT(2105.770363, -705.266285, -204.884713);
-
-        space.setFrame(AT_POINT,
-            newS,
-            VECTOR(newS, newD),
-            PNT(newS.x, newS.y, newS.z - 100));
-
-
         // Adjust Earth's motions
         Earth_RotationMotion(UCmdParam_On);
         Earth_RevolutionMotion(UCmdParam_On);
@@ -552,10 +542,22 @@ void Leela::ShowDemo(int nParam)
         Earth_OrbitalPlane(UCmdParam_Off);
         Moon_OrbitalPlane(UCmdParam_Off);
 
-        mercury->setOrbitalAngle(-0.587241);
-        earth->setOrbitalAngle(5.885674);
-        mars->setOrbitalAngle(1.251819);
-        jupiter->setOrbitalAngle(5.387664);
+        if (!jumpToNextEclipseEvent(EclipseEventType_Transit, 20.0, "Mercury", "Earth"))
+        {
+            mercury->setOrbitalAngle(-0.587241);
+            earth->setOrbitalAngle(5.885674);
+            mars->setOrbitalAngle(1.251819);
+            jupiter->setOrbitalAngle(5.387664);
+        }
+
+        // Camera was placed with earth at orbital angle 5.885674; rotate it to where the earth is now.
+        newS = rotatedWithEarth(glm::vec3(3062.437918, -1366.079160, 91.954525), 5.885674f);
+        newD = rotatedWithEarth(glm::vec3(2105.770363, -705.266285, -204.884713), 5.885674f);
+
+        space.setFrame(AT_POINT,
+            newS,
+            VECTOR(newS, newD),
+            PNT(newS.x, newS.y, newS.z - 100));
 
         // OrientedViewTarget mode is necessary or else the sun will keep moving to the left and
         // it will be harder to focus on the transit.
@@ -1,4 +1,6 @@
 #include "Leela.h"
+#include "KeplerSolver.h"
+#include "SphereMesh.h"
 
 #include "imgui.h"
 #include "imgui_impl_sdl2.h"
@@ -6,6 +8,58 @@
 
 #include "spdlog/spdlog.h"
 
+#include <algorithm>
+
+
+//
+// A series of the profiler and its children.  Times are per frame, averaged over the history.  The histograms show
+// the history with the newest frame on the right.
+//
+static void profilerSeriesTree(const Profiler& profiler, int index)
+{
+    constexpr int N = Profiler::HISTORY_SIZE;
+    const Profiler::Series& s = profiler.series()[index];
+    int newest = profiler.newestHistoryIndex();
+
+    float cpuAverage = 0.0f, cpuMax = 0.0f;
+    float gpuAverage = 0.0f, gpuMax = 0.0f;
+    for (int i = 0; i < N; i++) {
+        cpuAverage += s.cpuMs[i];
+        cpuMax = std::max(cpuMax, s.cpuMs[i]);
+        gpuMax = std::max(gpuMax, s.gpuMs[i]);
+    }
+    // The newest frames have no GPU times yet
+    for (int i = Profiler::FRAMES_IN_FLIGHT; i < N; i++)
+        gpuAverage += s.gpuMs[(newest + N - i) % N];
+    cpuAverage /= N;
+    gpuAverage /= N - Profiler::FRAMES_IN_FLIGHT;
+
+    ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_SpanAvailWidth;
+    if (s.depth < 2)
+        flags |= ImGuiTreeNodeFlags_DefaultOpen;
+    if (s.children.empty())
+        flags |= ImGuiTreeNodeFlags_Leaf;
+
+    bool bOpen = ImGui::TreeNodeEx((void*)(intptr_t)index, flags, "%s", s.name.c_str());
+    ImGui::SameLine(320);
+    ImGui::Text("CPU %7.3f ms   GPU %7.3f ms", cpuAverage, gpuAverage);
+
+    if (bOpen) {
+        float scale = std::max(std::max(cpuMax, gpuMax), 0.1f);
+        char overlay[32];
+        snprintf(overlay, sizeof(overlay), "CPU, max %.2f ms", cpuMax);
+        ImGui::PlotHistogram("##cpu", s.cpuMs, N, (newest + 1) % N, overlay, 0.0f, scale, ImVec2(240, 36));
+        ImGui::SameLine();
+        snprintf(overlay, sizeof(overlay), "GPU, max %.2f ms", gpuMax);
+        ImGui::PlotHistogram("##gpu", s.gpuMs, N, (newest + 1) % N, overlay, 0.0f, scale, ImVec2(240, 36));
+
+        for (int child : s.children)
+            profilerSeriesTree(profiler, child);
+        ImGui::TreePop();
+    }
+}
+
+
 
 void Leela::generateImGuiWidgets()
 {
@@ -41,7 +95,7 @@ void Leela::generateImGuiWidgets()
         //ImGui::Button("z"); ImGui::SameLine();
         //ImGui::PopStyleColor();
 
-        if (!earth->bRevolutionMotion) color = onColor; else color = offColor;
+        if (!earth->motionFlags().bRevolutionMotion) color = onColor; else color = offColor;
         ImGui::PushStyleColor(ImGuiCol_Button, color);
         ImGui::Button("0"); ImGui::SameLine();
         ImGui::PopStyleColor();
@@ -218,6 +272,9 @@ void Leela::generateImGuiWidgets()
             { "F6",             "Start/Stop earth's precession motion." },
             { "Shift + F6",     "Reset earth's axis tilt direction to default." },
 
+            { "F12",            "Write the last few seconds of the profiler to a trace file in the Traces folder next to the logs. "
+                                "Open it in chrome://tracing or Perfetto." },
+
             { nullptr, nullptr },
 
             { "1",              "Set earth's position at 0 from +X axis in XY plane." },
@@ -242,6 +299,24 @@ void Leela::generateImGuiWidgets()
 
     }
 
+    if (bShowProfiler)
+    {
+        ImGui::SetNextWindowSize(ImVec2(760, 600), ImGuiCond_FirstUseEver);
+        if (ImGui::Begin("Profiler", &bShowProfiler))
+        {
+            SmallCheckbox("Enabled", &profiler.bEnabled); ImGui::SameLine();
+            if (ImGui::SmallButton("Write trace (F12)"))
+                writeProfilerTrace();
+            ImGui::Text("Per frame, over the last %d frames.  GPU times are %d frames behind.",
+                        Profiler::HISTORY_SIZE, Profiler::FRAMES_IN_FLIGHT);
+            ImGui::Separator();
+
+            for (int root : profiler.roots())
+                profilerSeriesTree(profiler, root);
+        }
+        ImGui::End();
+    }
+
     if (bShowMouseNavigationHelp)
     {
         ImGui::SetNextWindowSizeConstraints(ImVec2(800, 600), ImVec2(1024, 768));
@@ -381,6 +456,7 @@ void Leela::generateImGuiWidgets()
                 if (ImGui::MenuItem("Show Control Panel in Navigation mode", "F9", bAlwaysShowControlPanel, true)) {
                     toggleControlPanelVisibilityWhenMouseGrabbed();
                 }
+                ImGui::MenuItem("Show Profiler", nullptr, &bShowProfiler);
                 ImGui::EndMenu();
             }
 
@@ -485,6 +561,68 @@ void Leela::generateImGuiWidgets()
                 );
 
 
+                ImGui::PopFont();
+            }
+            if (ImGui::CollapsingHeader("Eclipses && transits", ImGuiTreeNodeFlags_None)) {
+                ImGui::PushFont(appFontExtraSmall);
+
+                ImGui::SetNextItemWidth(120);
+                ImGui::SliderFloat("years## eclipse search", &eclipseSearchYears, 1.0f, 1000.0f, "%.0f", ImGuiSliderFlags_Logarithmic);
+                ImGui::SameLine();
+                if (ImGui::Button("Search## eclipses"))
+                    searchEclipseEvents(eclipseSearchYears);
+                ImGui::SameLine();
+                HelpMarker("Finds all solar & lunar eclipses and transits of inner planets from the current time, "
+                           "assuming all bodies keep their current motions.  Press 'Go' to jump to the start of an event.");
+
+                if (!eclipseEvents.empty())
+                {
+                    ImGui::Text("%zu events, found in %.2f s", eclipseEvents.size(), eclipseSearchSeconds);
+
+                    ImGui::BeginChild("EclipseEvents", ImVec2(0, 150), true);
+                    ImGuiListClipper clipper;
+                    clipper.Begin(int(eclipseEvents.size()));
+                    while (clipper.Step())
+                    {
+                        for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++)
+                        {
+                            const EclipseEvent& event = eclipseEvents[i];
+                            ImGui::PushID(i);
+                            if (ImGui::SmallButton("Go"))
+                                jumpToSimulationTime(event.startTime);
+                            ImGui::PopID();
+                            ImGui::SameLine();
+                            ImGui::Text("%8.2f y  %s (%s)", (event.maximumTime - _simulationTime) / stepsPerYear(),
+                                        eclipseEventTypeName(event.type),
+                                        event.type == EclipseEventType_Transit ? event.occluder.c_str() : event.target.c_str());
+                        }
+                    }
+                    ImGui::EndChild();
+                }
+
+                ImGui::PopFont();
+            }
+            if (ImGui::CollapsingHeader("Benchmarks", ImGuiTreeNodeFlags_None)) {
+                ImGui::PushFont(appFontExtraSmall);
+
+                if (ImGui::Button("Kepler solver## benchmark"))
+                    keplerRunBenchmark();
+                ImGui::SameLine();
+                HelpMarker("Solves Kepler's equation for 50000 random orbits using the scalar and the vector (SSE2) code. "
+                           "Bodies per second for both are written to the log.");
+
+                if (ImGui::Button("Body store evaluation## benchmark"))
+                    bodyStoreRunBenchmark();
+                ImGui::SameLine();
+                HelpMarker("Evaluates the orbital and rotational angles of 100000 synthetic bodies in the body store. "
+                           "Time per body is written to the log.");
+
+                if (ImGui::Button("Multi-threaded body store evaluation## benchmark"))
+                    bodyStoreRunScalingBenchmark();
+                ImGui::SameLine();
+                HelpMarker("Evaluates 1 million synthetic bodies using 1, 2, 4 and 8 threads of the job system. "
+                           "Time per evaluation and speedup over 1 thread are written to the log.");
+
                 ImGui::PopFont();
             }
             ImGui::PopFont();
@@ -495,22 +633,42 @@ void Leela::generateImGuiWidgets()
             SmallCheckbox("Shading", &bRealisticShading); ImGui::SameLine();
             SmallCheckbox("Textured surfaces", &bRealisticSurfaces); ImGui::SameLine();
             SmallCheckbox("Wireframe", &bShowWireframeSurfaces);
+            SmallCheckbox("Per-pixel shading", &bPerFragmentShading); ImGui::SameLine();
+            HelpMarker("Evaluate day/night and eclipse shadows for every pixel rather than every vertex.\n"
+                       "Shadow edges no longer depend on the sphere's triangles, so coarser sphere meshes can be used.\n"
+                       "Compare frame time and sphere triangles with this on and off.");
             SmallCheckbox("Orbits (o)", &bShowOrbitsGlobalEnable); ImGui::SameLine();
             SmallCheckbox("Planet axis", &bShowPlanetAxis);
             SmallCheckbox("Coordinate axis (a)", &bShowAxis);
             SmallCheckbox("Low darkness at night", &bShowLowDarknessAtNight);
+            if (minorBodyCatalog.isLoaded())
+            {
+                // Reading it is a system call, or a read of /proc on Linux; not every frame.
+                auto now = std::chrono::steady_clock::now();
+                if (now - residentMemorySampleTime >= std::chrono::milliseconds(500)) {
+                    residentMemoryBytes = getResidentMemoryBytes();
+                    residentMemorySampleTime = now;
+                }
+
+                SmallCheckbox("Asteroids", &bShowMinorBodies); ImGui::SameLine();
+                ImGui::PushFont(appFontExtraSmall);
+                ImGui::Text("%zu, loaded in %.2f s%s, resident memory %.0f MB",
+                            minorBodyCatalog.size(),
+                            minorBodyCatalog.loadSeconds,
+                            minorBodyCatalog.bLoadedFromCache ? " from cache" : "",
+                            residentMemoryBytes / (1024.0 * 1024.0));
+                ImGui::PopFont();
+            }
             ImGui::Separator();
 
             ImGui::PushItemWidth(100);
             float sunRadius = sun->_radius;
             if (ImGui::SliderFloat("Sun radius## sun", &sunRadius, 100.0f, 250.0f)) {
-                sun->_radius = sunRadius;
-                sunRenderer->constructMainSphereVertices();
+                sun->_radius = sunRadius;           // sphere mesh is scaled to radius when drawn; nothing to rebuild
             }
             ImGui::PopItemWidth(); ImGui::SameLine();
             if (ImGui::Button("Reset##Sun radius")) {
                 sun->restoreRadius();
-                sunRenderer->constructMainSphereVertices();
             }
 
             ImGui::Separator();
@@ -547,6 +705,7 @@ void Leela::generateImGuiWidgets()
             ImGui::SameLine(0.0f, spacing);
             if (ImGui::Button("Reset"))
                 _stepMultiplier = 1.0f;
+            ImGui::Text("Simulation time: %.1f", _simulationTime);
 
 
             ImGui::Unindent();
@@ -562,9 +721,9 @@ void Leela::generateImGuiWidgets()
             ImGui::PopFont();
 
             ImGui::Indent();
-            SmallCheckbox("Rotation## earth", &earth->bRotationMotion); ImGui::SameLine();
-            SmallCheckbox("Sync with revolution", &earth->bSyncWithRevolution);
-            SmallCheckbox("Revolution  (0)## earth", &earth->bRevolutionMotion); ImGui::SameLine();
+            SmallCheckbox("Rotation## earth", &earth->motionFlags().bRotationMotion); ImGui::SameLine();
+            SmallCheckbox("Sync with revolution", &earth->motionFlags().bSyncWithRevolution);
+            SmallCheckbox("Revolution  (0)## earth", &earth->motionFlags().bRevolutionMotion); ImGui::SameLine();
 
             ImGui::Text("Darkness:"); ImGui::SameLine();
             ImGui::PushItemWidth(75);
@@ -590,7 +749,7 @@ void Leela::generateImGuiWidgets()
                 earthRenderer->constructOrbitalPlaneGridVertices();
                 earthRenderer->constructOrbitalPlaneVertices();
             }
-            SmallCheckbox("Precession (F6)## earth", &earth->bPrecessionMotion);
+            SmallCheckbox("Precession (F6)## earth", &earth->motionFlags().bPrecessionMotion);
             ImGui::SameLine();
             if (ImGui::Button("Reset## earth precession motion"))
                 Earth_PrecessionMotion(UCmdParam_Reset);
@@ -646,20 +805,20 @@ void Leela::generateImGuiWidgets()
 
             ImGui::Indent();
             SmallCheckbox("Hide", &moon->_hidden);
-            SmallCheckbox("Revolution", &moon->bRevolutionMotion);  ImGui::SameLine();
-            SmallCheckbox("Sync with Earth", &moon->bOrbitalRevolutionSyncToParent);
+            SmallCheckbox("Revolution", &moon->motionFlags().bRevolutionMotion);  ImGui::SameLine();
+            SmallCheckbox("Sync with Earth", &moon->motionFlags().bOrbitalRevolutionSyncToParent);
             SmallCheckbox("Orbit## moon", &moonRenderer->bShowOrbit); ImGui::SameLine();
             SmallCheckbox("Plane (m)##moon", &moonRenderer->bShowOrbitalPlane);  ImGui::SameLine();
             if (SmallCheckbox("Transparency##moon orbital plane", &moonRenderer->bOrbitalPlaneTransparency)) {
                 moonRenderer->constructOrbitalPlaneGridVertices();
                 moonRenderer->constructOrbitalPlaneVertices();
             }
-            SmallCheckbox("Nodal Precession (F5)", &moon->bOrbitalPlaneRotation);
+            SmallCheckbox("Nodal Precession (F5)", &moon->motionFlags().bOrbitalPlaneRotation);
             ImGui::SameLine();
             if (ImGui::Button("Reset## moon orbital plane rotation"))
                 Moon_OrbitalPlaneRotation(UCmdParam_Reset);
             ImGui::Indent();
-            SmallCheckbox("Sync with earth's revolution", &moon->bNodalPrecessionSpeedSyncToParentsRevolution);
+            SmallCheckbox("Sync with earth's revolution", &moon->motionFlags().bNodalPrecessionSpeedSyncToParentsRevolution);
             ImGui::Unindent();
             ImGui::PushItemWidth(100);
             //ImGui::SetNextItemWidth(180);
@@ -692,7 +851,7 @@ void Leela::generateImGuiWidgets()
             ImGui::PopFont();
 
             ImGui::Indent();
-            SmallCheckbox("Revolution", &mars->bRevolutionMotion); ImGui::SameLine();
+            SmallCheckbox("Revolution", &mars->motionFlags().bRevolutionMotion); ImGui::SameLine();
             SmallCheckbox("Orbit## mars", &marsRenderer->bShowOrbit); ImGui::SameLine();
             SmallCheckbox("Plane## mars", &marsRenderer->bShowOrbitalPlane);
             ImGui::Unindent();
@@ -782,7 +941,34 @@ void Leela::generateImGuiWidgets()
             //-----------------------------------------------------
 
             ImGui::Text("%.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
-            _stepMultiplierFrameRateAdjustment = REFERENCE_FRAME_RATE / ImGui::GetIO().Framerate;
+            ImGui::Text("Simulation: %d ticks this frame, %u dropped", lastFrameSimulationTicks, droppedSimulationTicks);
+            ImGui::Text("Transforms: %u computed, %u reused from cache",
+                        lastFrameTransformCacheStats.computed, lastFrameTransformCacheStats.reused);
+            ImGui::Text("Render calls: %u (%u without render lists)",
+                        lastFrameRenderListStats.renderCalls, lastFrameRenderListStats.sceneWalkRenderCalls);
+            ImGui::Text("Uniform uploads: %u", lastFrameUniformUploads);
+            ImGui::Text("Text: %u glyphs in %u draw calls", lastFrameTextGlyphs, lastFrameTextDrawCalls);
+            ImGui::Text("Texture streaming: %u textures, %.1f MB to go, %.2f MB last frame",
+                        textureStreamer.pendingTextures(), textureStreamer.pendingBytes() / (1024.0 * 1024.0),
+                        textureStreamer.lastUpdateBytes() / (1024.0 * 1024.0));
+            if (earthRenderer && earthRenderer->_virtualTexture) {
+                const VirtualTexture& vt = *earthRenderer->_virtualTexture;
+                ImGui::Text("Earth virtual texture: %dx%d, %.1f%% hit rate, %u tiles loading",
+                            vt.width(), vt.height(), vt.hitRate() * 100.0f, vt.loadingTiles());
+                ImGui::Text("    %u of %u tiles resident, %.1f of %.1f MB",
+                            vt.residentTiles(), vt.atlasTiles(),
+                            vt.residentBytes() / (1024.0 * 1024.0), vt.atlasBytes() / (1024.0 * 1024.0));
+            }
+            SmallCheckbox("Culling", &bCulling); ImGui::SameLine();
+            ImGui::Text("%u objects, %u bodies out of view, %u occluded",
+                        lastFrameCullStats.objectsCulled, lastFrameCullStats.bodiesOutsideView, lastFrameCullStats.bodiesOccluded);
+            ImGui::Text("Shadow casters: %u, %u out of reach",
+                        lastFrameCullStats.shadowCasters, lastFrameCullStats.shadowCastersCulled);
+            ImGui::Text("Sphere meshes: %.2f MB, %u triangles drawn",
+                        SphereMesh::totalGpuBytes() / (1024.0 * 1024.0), lastFrameSphereTrianglesDrawn);
+            ImGui::PushItemWidth(100);
+            ImGui::SliderFloat("Sphere LOD pixel error", &sphereLodPixelError, 0.1f, 4.0f, "%.2f", ImGuiSliderFlags_Logarithmic);
+            ImGui::PopItemWidth();
 
             ImGui::Separator();
             ImGui::Text("S: %.4f, %.4f, %.4f", space.S.x, space.S.y, space.S.z);
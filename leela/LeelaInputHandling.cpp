@@ -95,19 +95,19 @@ void Leela::onKeyDown(SDL_Event* event)
                 LOG_BUFFER_SIZE,
                 "\nS = %f, %f, %f"
                 "\nD = %f, %f, %f"
-                "\nmercury->_orbitalAngle = %f"
-                "\nearth->_orbitalAngle = %f"
-                "\nmars->_orbitalAngle = %f"
-                "\njupiter->_orbitalAngle = %f"
-                "\nmoon->_nodalPrecessionAngle = %f"
+                "\nmercury->orbitalAngle() = %f"
+                "\nearth->orbitalAngle() = %f"
+                "\nmars->orbitalAngle() = %f"
+                "\njupiter->orbitalAngle() = %f"
+                "\nmoon->nodalPrecessionAngle() = %f"
                 ,
                 space.S.x, space.S.y, space.S.z,
                 space.D.x, space.D.y, space.D.z,
-                mercury->_orbitalAngle,
-                earth->_orbitalAngle,
-                mars->_orbitalAngle,
-                jupiter->_orbitalAngle,
-                moon->_nodalPrecessionAngle
+                mercury->orbitalAngle(),
+                earth->orbitalAngle(),
+                mars->orbitalAngle(),
+                jupiter->orbitalAngle(),
+                moon->nodalPrecessionAngle()
             );
             logString = logBuffer;                  // ImGui will check the logString (of type std::string), and write its contents to Windows clipboard.
             spdlog::info(logBuffer);
@@ -199,6 +199,9 @@ void Leela::onKeyDown(SDL_Event* event)
     case SDLK_F11:
         toggleFullScreen();
         break;
+    case SDLK_F12:
+        writeProfilerTrace();
+        break;
 
 
 
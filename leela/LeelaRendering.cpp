@@ -6,57 +6,24 @@
 
 #include "spdlog/spdlog.h"
 
+#include <typeinfo>
 
 
-void Leela::constructFontInfrastructureAndSendToGpu()
-{
-    glGenVertexArrays(1, &fontVao);
-    glGenBuffers(1, &fontVbo);
-
-    glBindVertexArray(fontVao);
-    glBindBuffer(GL_ARRAY_BUFFER, fontVbo);
-    //glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
-    //glEnableVertexAttribArray(0);
-    //glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
-
-
-    //-------------
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 5, NULL, GL_DYNAMIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), 0);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-    //-------------
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
-
-    //---------------------
-    // Large font
-
-    glGenVertexArrays(1, &largeFontVao);
-    glGenBuffers(1, &largeFontVbo);
 
-    glBindVertexArray(largeFontVao);
-    glBindBuffer(GL_ARRAY_BUFFER, largeFontVbo);
-    //glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
-    //glEnableVertexAttribArray(0);
-    //glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
+// Label sizes, and the size of the signed distance field atlas they are drawn from.
+static constexpr int LABEL_PIXEL_SIZE = 20;
+static constexpr int LARGE_LABEL_PIXEL_SIZE = 64;
+static constexpr int LABEL_ATLAS_PIXEL_SIZE = 32;
+static constexpr int LABEL_ATLAS_SPREAD = 4;
 
-
-    //-------------
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 5, NULL, GL_DYNAMIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), 0);
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-    //-------------
-
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+// Profiler scope names, indexed by ViewportType and RenderStage
+static const char* VIEWPORT_PROFILE_NAMES[NUM_VIEWPORT_TYPES] = { "Primary viewport", "Minimap viewport", "Alternate observer viewport" };
+static const char* RENDER_STAGE_PROFILE_NAMES[NUM_RENDER_STAGES] = { "Pre", "Main", "Post", "TranslucentMain", "Final" };
 
 
+void Leela::constructFontInfrastructureAndSendToGpu()
+{
+    textBatch.init();
 }
 
 
@@ -71,16 +38,38 @@ void Leela::render()
 
 void Leela::renderAllViewportTypes()
 {
+    profiler.begin("Scene update");
+    if (renderListsTopologyGeneration != SceneObject::topologyGeneration())
+        buildRenderLists();
+    unsigned int visibleRenderers = updateNodeVisibility();
+    updateNodeBounds();
+    updateShadowCasters();
+    profiler.end();
+
     for (auto viewportType : {  ViewportType::Primary,
                                 ViewportType::Minimap,
                                 ViewportType::AlternateObserver }
                                 // add scene types here if new items are added to ViewportType enum
         )
     {
+        ProfileScope profileScope(profiler, VIEWPORT_PROFILE_NAMES[int(viewportType)]);
         bool configured = setupViewport(viewportType);
         
-        if (configured)
+        if (configured) {
+            cullScene(viewportType);
+
+            // camera and sun for all programs, in one write
+            FrameUniforms frameUniforms = {};
+            frameUniforms.view = viewMatrix;
+            frameUniforms.proj = projectionMatrix;
+            frameUniforms.sunCenterTransformed = sun->getModelTransformedCenter();
+            frameUniforms.sunRadius = sun->getRadius();
+            frameUniforms.realisticShading = bRealisticShading;
+            frameUniformBuffer.update(frameUniforms);
+
             renderAllStages(viewportType);
+            renderListStats.sceneWalkRenderCalls += visibleRenderers * NUM_RENDER_STAGES * unsigned(shaderPrograms.size());
+        }
     }
 
     glBindVertexArray(0);
@@ -101,6 +90,7 @@ void Leela::renderAllStages(ViewportType viewportType)
                                 // add stages here if new items are added to RenderStage enum
         )
     {
+        ProfileScope profileScope(profiler, RENDER_STAGE_PROFILE_NAMES[int(renderStage)]);
         renderUsingAllShaderPrograms(viewportType, renderStage);
     }
 
@@ -108,8 +98,13 @@ void Leela::renderAllStages(ViewportType viewportType)
 
 void Leela::renderUsingAllShaderPrograms(ViewportType viewportType, RenderStage renderStage)
 {
-    for (GlslProgram* prog : shaderPrograms)
+    for (int programIndex = 0; programIndex < int(shaderPrograms.size()); programIndex++)
     {
+        // nothing in the scene draws with this program in this stage
+        if (renderList(viewportType, renderStage, programIndex).empty())
+            continue;
+
+        GlslProgram* prog = shaderPrograms[programIndex];
         prog->use();
 
         //---------------------------------------------------------
@@ -118,45 +113,24 @@ void Leela::renderUsingAllShaderPrograms(ViewportType viewportType, RenderStage
         if (prog->type() == GlslProgramType::Font)
         {
             glm::mat4 projection = glm::ortho(0.0f, float(curViewportWidth), 0.0f, float(curViewportHeight));
-            prog->setMat4("projection", glm::value_ptr(projection));
+            prog->set(Uniforms::projection, projection);
         }
+        // view, projection and sun come from the FrameUniforms buffer
         else if (prog->type() == GlslProgramType::Planet)
         {
-
-            prog->setMat4("view", glm::value_ptr(viewMatrix));
-            prog->setMat4("proj", glm::value_ptr(projectionMatrix));
-
             // turn usage of texture on/off based on global setting. Individual spheres might change this
             // depending on whether they have texture set up.
-            prog->setBool("useTexture", bRealisticSurfaces);
-
-            prog->setVec3("sunCenterTransformed", glm::value_ptr(sun->getModelTransformedCenter()));
-            prog->setFloat("sunRadius", sun->getRadius());
-            prog->setBool("realisticShading", bRealisticShading);
-        }
-        else if (prog->type() == GlslProgramType::Star)
-        {
-            prog->setMat4("view", glm::value_ptr(viewMatrix));
-            prog->setMat4("proj", glm::value_ptr(projectionMatrix));
+            prog->set(Uniforms::useTexture, bRealisticSurfaces);
+            prog->set(Uniforms::perFragmentShading, bPerFragmentShading);
         }
         else if (prog->type() == GlslProgramType::Sun)
         {
-            prog->setMat4("view", glm::value_ptr(viewMatrix));
-            prog->setMat4("proj", glm::value_ptr(projectionMatrix));
-            prog->setBool("useTexture", bRealisticSurfaces);
-        }
-        else if (prog->type() == GlslProgramType::Simple)
-        {
-            prog->setMat4("view", glm::value_ptr(viewMatrix));
-            prog->setMat4("proj", glm::value_ptr(projectionMatrix));
-        }
-        else if (prog->type() == GlslProgramType::SimpleOrtho)
-        {
+            prog->set(Uniforms::useTexture, bRealisticSurfaces);
         }
         else if (prog->type() == GlslProgramType::BookmarkSphere)
         {
             glm::mat4 projection = glm::ortho(0.0f, float(curViewportWidth), 0.0f, float(curViewportHeight));
-            prog->setMat4("projection", glm::value_ptr(projection));
+            prog->set(Uniforms::projection, projection);
         }
         //------------------------------------------------------
 
@@ -165,7 +139,11 @@ void Leela::renderUsingAllShaderPrograms(ViewportType viewportType, RenderStage
             glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
         }
 
-        renderSceneUsingGlslProgram(renderStage, *prog, viewportType);
+        renderSceneUsingGlslProgram(renderStage, programIndex, viewportType);
+
+        // labels added by the renderers, all at once
+        if (prog->type() == GlslProgramType::Font)
+            textBatch.flush(*prog);
 
         if (renderStage == RenderStage::TranslucentMain)
             glDisable(GL_BLEND);
@@ -284,130 +262,301 @@ bool Leela::setupViewport(ViewportType viewportType)
 }
 
 //
-// Render all scene objects.
+// Render all scene objects that draw with the given program in this stage.
 //
-void Leela::renderSceneUsingGlslProgram(RenderStage renderStage, GlslProgram& glslProgram, ViewportType viewportType)
+void Leela::renderSceneUsingGlslProgram(RenderStage renderStage, int programIndex, ViewportType viewportType)
+{
+    GlslProgram& glslProgram = *shaderPrograms[programIndex];
+
+    // One profiler scope per run of renderers of the same class
+    const std::type_info* profiledClass = nullptr;
+
+    for (const RenderListEntry& entry : renderList(viewportType, renderStage, programIndex))
+    {
+        if (nodeInView[entry.node]) {
+            const std::type_info& rendererClass = typeid(*entry.renderer);
+            if (profiledClass == nullptr || *profiledClass != rendererClass) {
+                if (profiledClass)
+                    profiler.end();
+                profiler.begin(rendererClass);
+                profiledClass = &rendererClass;
+            }
+
+            entry.renderer->render(viewportType, renderStage, glslProgram);
+            renderListStats.renderCalls++;
+        }
+    }
+
+    if (profiledClass)
+        profiler.end();
+}
+
+std::vector<RenderListEntry>& Leela::renderList(ViewportType viewportType, RenderStage renderStage, int programIndex)
 {
-    //spdlog::info("renderSceneUsingGlslProgram: glslProgram type = {}", (int)glslProgram.type());
-    renderSceneObjectUsingGlslProgram(&scene, renderStage, glslProgram, viewportType);
+    size_t index = (size_t(viewportType) * NUM_RENDER_STAGES + size_t(renderStage)) * shaderPrograms.size() + programIndex;
+    return renderLists[index];
 }
 
 //
-// Render the given `sceneObject` and all its children recursively.
+// Sort all renderers of the scene into a list per (viewport, stage, shader program) slot.
+//  - Order within a list is the scene order, which is the order they used to be drawn in when walking the scene.
+//  - Hidden objects are kept in the lists.  Hidden flags can change at any time and are applied when rendering.
 //
-void Leela::renderSceneObjectUsingGlslProgram(SceneObject * sceneObject, RenderStage renderStage, GlslProgram& glslProgram, ViewportType viewportType)
+void Leela::buildRenderLists()
 {
-    if (!sceneObject->hidden()) {
-        for (Renderer* r : sceneObject->_renderers)
+    const std::vector<Scene::FlatNode>& nodes = scene.flattened();
+
+    renderLists.assign(size_t(NUM_VIEWPORT_TYPES) * NUM_RENDER_STAGES * shaderPrograms.size(), {});
+
+    for (int v = 0; v < NUM_VIEWPORT_TYPES; v++)
+    {
+        for (int s = 0; s < NUM_RENDER_STAGES; s++)
         {
-            r->render(viewportType, renderStage, glslProgram);
+            for (int p = 0; p < int(shaderPrograms.size()); p++)
+            {
+                ViewportType viewportType = ViewportType(v);
+                RenderStage renderStage = RenderStage(s);
+                std::vector<RenderListEntry>& list = renderList(viewportType, renderStage, p);
+
+                for (int n = 0; n < int(nodes.size()); n++)
+                {
+                    for (Renderer* r : nodes[n].object->_renderers)
+                    {
+                        if (r->rendersIn(viewportType, renderStage, shaderPrograms[p]->type()))
+                            list.push_back({ r, n });
+                    }
+                }
+            }
         }
+    }
 
-        for (SceneObject* obj : sceneObject->_childSceneObjects)
-        {
-            renderSceneObjectUsingGlslProgram(obj, renderStage, glslProgram, viewportType);
+    renderListsTopologyGeneration = SceneObject::topologyGeneration();
+}
+
+//
+// Work out which scene objects are visible this frame.  An object is hidden along with its whole subtree.
+// Returns the number of renderers of visible objects.
+//
+unsigned int Leela::updateNodeVisibility()
+{
+    const std::vector<Scene::FlatNode>& nodes = scene.flattened();
+    nodeVisible.assign(nodes.size(), 0);
+
+    unsigned int visibleRenderers = 0;
+    size_t i = 0;
+    while (i < nodes.size())
+    {
+        if (nodes[i].object->hidden()) {
+            i = nodes[i].subtreeEnd;
+            continue;
         }
+
+        nodeVisible[i] = 1;
+        visibleRenderers += unsigned(nodes[i].object->_renderers.size());
+        i++;
     }
+
+    return visibleRenderers;
 }
 
+//
+// Bounding spheres of all visible scene objects, in world coordinates.  Same for all viewports.
+//
+void Leela::updateNodeBounds()
+{
+    const std::vector<Scene::FlatNode>& nodes = scene.flattened();
+    nodeBounds.assign(nodes.size(), NodeBounds());
+
+    // Children come after their parent.  Go backwards so that children's subtree bounds are ready for the parent.
+    for (int i = int(nodes.size()) - 1; i >= 0; i--)
+    {
+        if (!nodeVisible[i])
+            continue;
 
+        SceneObject* object = nodes[i].object;
+        NodeBounds& bounds = nodeBounds[i];
+
+        bounds.body = object->bodyBounds();
+        bounds.drawn = object->drawnBounds();
+        for (Renderer* r : object->_renderers) {
+            if (r->drawsOutsideBounds())
+                bounds.drawn = BoundingSphere();
+        }
+
+        bounds.subtree = bounds.drawn;
+        for (int child = i + 1; child < nodes[i].subtreeEnd; child = nodes[child].subtreeEnd) {
+            if (nodeVisible[child])
+                bounds.subtree.merge(nodeBounds[child].subtree);
+        }
+    }
+}
 
 //
-// prerequisites: fontGlslProgram must be active before calling this method.
+// Pick the related spheres that can cast a shadow on each visible sphere at the current positions.  Only those are
+// given to the planet shader, which evaluates every one of them for every pixel.  Same for all viewports.
 //
-void Leela::RenderText(GlslProgram& glslProgram, RenderTextType renderType, std::string text, float x, float y, float z, float scale, glm::vec3 color)
+void Leela::updateShadowCasters()
 {
-    glslProgram.setVec3("textColor", glm::value_ptr(color));
+    const std::vector<Scene::FlatNode>& nodes = scene.flattened();
 
-    GLboolean curDepthMaskEnable;
-    GLboolean prevBlendEnable;
-    
-    glGetBooleanv(GL_BLEND, &prevBlendEnable);          // backup blending enable/disable status before enabling it.
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    if (renderType == RenderTextType_ScreenText) {
-        glGetBooleanv(GL_DEPTH_WRITEMASK, &curDepthMaskEnable);       // backup current depth mask before disabling it
-        if (!bShowLabelsOnTop)
-            glDepthMask(GL_FALSE);            // disable writing to depth buffer.  This will allow other objects (spheres, etc) to
-                                              // overwrite the label when they are drawn later.
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        if (!nodeVisible[i])
+            continue;
+
+        SphericalBody* sb = dynamic_cast<SphericalBody*>(nodes[i].object);
+        if (sb == nullptr || sb->_relatedSpheres.empty())
+            continue;
+
+        sb->updateShadowCasters();
+        cullStats.shadowCasters += unsigned(sb->_shadowCasters.size());
+        cullStats.shadowCastersCulled += unsigned(sb->_relatedSpheres.size() - sb->_shadowCasters.size());
     }
+}
 
-    //---------------------------------
+//
+// Work out what to draw in the viewport that was just set up.
+//  - Objects whose drawn bounds are outside the view frustum are left out of nodeInView, so their renderers
+//    aren't called.  Whole subtrees are skipped when their combined bounds are outside.
+//  - Bodies outside the frustum, or completely behind an opaque sphere drawn by another object (e.g. a moon behind
+//    its planet), are flagged with _bodyCulled.  Renderers don't draw the body itself then, but still draw parts
+//    that can be elsewhere, such as the orbit.
+//  - Occlusion is only tested in perspective views.
+//
+void Leela::cullScene(ViewportType viewportType)
+{
+    const std::vector<Scene::FlatNode>& nodes = scene.flattened();
+    nodeInView = nodeVisible;
 
-    glActiveTexture(GL_TEXTURE0);
-    if (bShowLargeLabels)
-        glBindVertexArray(largeFontVao);
-    else
-        glBindVertexArray(fontVao);
+    for (const Scene::FlatNode& node : nodes)
+        node.object->_bodyCulled = false;
 
+    if (!bCulling)
+        return;
 
-    PNT p(x, y, z), p1, p2, p3, p4, p5, p6;
+    Frustum frustum(projectionMatrix * viewMatrix);
+    occluders.clear();
 
-    // iterate through all characters
-    std::string::const_iterator c;
-    for (c = text.begin(); c != text.end(); c++)
+    size_t i = 0;
+    while (i < nodes.size())
     {
-        Character ch;
+        if (!nodeInView[i]) {
+            i++;
+            continue;
+        }
+
+        if (!frustum.intersects(nodeBounds[i].subtree)) {
+            for (int j = int(i); j < nodes[i].subtreeEnd; j++) {
+                if (nodeInView[j]) {
+                    nodeInView[j] = 0;
+                    cullStats.objectsCulled++;
+                }
+            }
+            i = nodes[i].subtreeEnd;
+            continue;
+        }
 
-        //spdlog::info("*c = {}", *c);
-        if (bShowLargeLabels)
-            ch = largeCharacters[*c];
-        else
-            ch = characters[*c];
+        SceneObject* object = nodes[i].object;
+        if (!frustum.intersects(nodeBounds[i].drawn)) {
+            nodeInView[i] = 0;
+            cullStats.objectsCulled++;
+        }
+        else if (!frustum.intersects(nodeBounds[i].body)) {
+            object->_bodyCulled = true;
+            cullStats.bodiesOutsideView++;
+        }
+        else {
+            for (Renderer* r : object->_renderers) {
+                BoundingSphere occluder = r->occluderBounds();
+                if (occluder.bounded())
+                    occluders.push_back({ occluder, object });
+            }
+        }
+        i++;
+    }
 
-        float ch_w = ch.size.x * scale;
-        float ch_h = ch.size.y * scale;
+    bool bPerspective = (projectionMatrix[3][3] == 0.0f);
+    if (!bPerspective || occluders.empty())
+        return;
+
+    glm::vec3 eye = glm::vec3(glm::inverse(viewMatrix)[3]);
+
+    for (size_t n = 0; n < nodes.size(); n++)
+    {
+        SceneObject* object = nodes[n].object;
+        if (!nodeInView[n] || object->_bodyCulled || !nodeBounds[n].body.bounded())
+            continue;
+
+        for (auto& [occluder, occluderObject] : occluders)
+        {
+            if (occluderObject != object && isSphereOccluded(eye, occluder, nodeBounds[n].body)) {
+                object->_bodyCulled = true;
+                cullStats.bodiesOccluded++;
+                break;
+            }
+        }
+    }
+}
+
+
+
+//
+// Add `text` to the labels drawn at the end of the current Font program pass.  See TextBatch.
+//  - projection: used by the Font program for this text.
+//
+void Leela::RenderText(const glm::mat4& projection, RenderTextType renderType, std::string text, float x, float y, float z, float scale, glm::vec3 color)
+{
+    const GlyphAtlas& atlas = glyphAtlas;
+
+    // Screen text normally doesn't write to depth buffer.  This will allow other objects (spheres, etc) to
+    // overwrite the label when they are drawn later.
+    bool bDepthWrite = (renderType != RenderTextType_ScreenText) || bShowLabelsOnTop;
+    textBatch.setState(atlas, projection, bDepthWrite);
+
+    // atlas metrics are in pixels of a font of the atlas' size
+    scale *= float(bShowLargeLabels ? LARGE_LABEL_PIXEL_SIZE : LABEL_PIXEL_SIZE) / atlas.pixelSize();
 
-        // render glyph texture over quad
-        glBindTexture(GL_TEXTURE_2D, ch.textureID);
+    PNT p(x, y, z), p1, p2, p3, p6;
 
-        // update content of VBO memory
-        if (bShowLargeLabels)
-            glBindBuffer(GL_ARRAY_BUFFER, largeFontVbo);
-        else
-            glBindBuffer(GL_ARRAY_BUFFER, fontVbo);
+    // find the "right" direction vector
+    // assume `space` object's S, D, R and correctly set.  (R gives downward direction with DR perpendicular to SD)
+    VECTOR DS, DR, DL;
+    if (renderType == RenderTextType_ObjectText) {
+        DS = VECTOR(space.D, space.S);
+        DR = VECTOR(space.D, space.R);
+        DL = DS.cross(DR);
+    }
 
+    // iterate through all characters
+    for (char c : text)
+    {
+        const GlyphAtlas::Glyph& ch = atlas.glyph(c);
+
+        float ch_w = ch.size.x * scale;
+        float ch_h = ch.size.y * scale;
 
         if (renderType == RenderTextType_ScreenText) {
             float xpos = x + ch.bearing.x * scale;
             float ypos = y - (ch.size.y - ch.bearing.y) * scale;
 
-            // update VBO for each character
-            float vertices[6][5] = {
-                // point coordiinates                 Texture coordinates
-                //---------------------------------   -------------------------
-                {xpos,         ypos + ch_h,  0.0f,    0.0f, 0.0f },                 // the point here is equivalent to p1 in the `else` part
-                {xpos,         ypos,         0.0f,    0.0f, 1.0f },                 // the point here is equivalent to p2 in the `else` part
-                {xpos + ch_w,  ypos,         0.0f,    1.0f, 1.0f },                 // the point here is equivalent to p3 in the `else` part
-
-                {xpos,         ypos + ch_h,  0.0f,    0.0f, 0.0f },                 // the point here is equivalent to p1 in the `else` part
-                {xpos + ch_w,  ypos,         0.0f,    1.0f, 1.0f },                 // the point here is equivalent to p3 in the `else` part
-                {xpos + ch_w,  ypos + ch_h,  0.0f,    1.0f, 0.0f },                 // the point here is equivalent to p6 in the `else` part
-            };
-
-            glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
+            textBatch.addQuad(glm::vec3(xpos,         ypos + ch_h,  0.0f),
+                              glm::vec3(xpos + ch_w,  ypos + ch_h,  0.0f),
+                              glm::vec3(xpos + ch_w,  ypos,         0.0f),
+                              glm::vec3(xpos,         ypos,         0.0f),
+                              ch.uvMin, ch.uvMax, color);
 
             // advance cursors for next glyph (advance is 1/64 pixels)
-            x += (ch.advance >> 6) * scale;
-
+            x += (ch.advance / 64.0f) * scale;
         }
         else {
             // text is upright in z direction and perpendicular to the observer.
             // find the 4 unique points of the two triangles of the character glyph.
             // starting with x, y and z given to this function, move in the "right" direction given observer's position and down direction.
             // 
-            // p1/p4 o--o p6   
-            //       |\ |
-            //       | \|
-            // p2    o--o p3/p5
-
-            // find the "right" direction vector
-            // assume `space` object's S, D, R and correctly set.  (R gives downward direction with DR perpendicular to SD)
-            VECTOR DS = VECTOR(space.D, space.S);
-            VECTOR DR = VECTOR(space.D, space.R);
-            VECTOR DL = DS.cross(DR);
-
+            // p1    o--o p6   
+            //       |  |
+            //       |  |
+            // p2    o--o p3
 
             // Calculate p2 which is equivalent of this coordinate.
             //      - float xpos = x + ch.bearing.x * scale;
@@ -417,117 +566,35 @@ void Leela::RenderText(GlslProgram& glslProgram, RenderTextType renderType, std:
             p3 = p2.translated(ch_w, DL);
             p6 = p3.translated(-ch_h, DR);
 
-            float vertices[6][5] = {
-                // point coordiinates                 Texture coordinates
-                //---------------------------------   -------------------------
-                {p1.x, p1.y, p1.z,                    0.0f, 0.0f },
-                {p2.x, p2.y, p2.z,                    0.0f, 1.0f },
-                {p3.x, p3.y, p3.z,                    1.0f, 1.0f },
-                                                    
-                {p1.x, p1.y, p1.z,                    0.0f, 0.0f },
-                {p3.x, p3.y, p3.z,                    1.0f, 1.0f },
-                {p6.x, p6.y, p6.z,                    1.0f, 0.0f },
-            };
-
-            glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
+            textBatch.addQuad(glm::vec3(p1.x, p1.y, p1.z),
+                              glm::vec3(p6.x, p6.y, p6.z),
+                              glm::vec3(p3.x, p3.y, p3.z),
+                              glm::vec3(p2.x, p2.y, p2.z),
+                              ch.uvMin, ch.uvMax, color);
 
             // advance cursors for next glyph (advance is 1/64 pixels)
-            p.translate((ch.advance >> 6) * scale, DL);
+            p.translate((ch.advance / 64.0f) * scale, DL);
         }
-
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-        // render quad
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-    }
-
-    glBindVertexArray(0);
-    glBindTexture(GL_TEXTURE_2D, 0);
-
-    if (renderType == RenderTextType_ScreenText) {
-        glDepthMask(curDepthMaskEnable);    // restore depth mask
     }
-
-    if (!prevBlendEnable)               // disabled blending if it was previously disabled
-        glDisable(GL_BLEND);
-
 }
 
 int Leela::getHeightOfCharA()
 {
-    Character ch = characters['A'];
-    return ch.size.y;
+    int atlasHeight = glyphAtlas.glyph('A').size.y - 2 * glyphAtlas.spread();
+    return atlasHeight * LABEL_PIXEL_SIZE / glyphAtlas.pixelSize();
 }
 
+// Adds jobs to jobSystem: the atlas is loaded or generated on a worker and uploaded on this thread.
 void Leela::createFontCharacterTexture()
 {
-    spdlog::info("Generating font character textures");
-
-    //if (FT_Load_Glyph(face, "X", FT_LOAD_RENDER))
-    //    cout << "ERROR:FREETYPE Failed to load Glyph" << endl;
-
-    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);      // no byte alignment restriction
-
-    for (int i = 0; i < 2; i++)
-    {
-        if (FT_Init_FreeType(&ft))
-            spdlog::error("ERROR:FREETYPE Could not init FreeType library");
-
-        //if (FT_New_Face(ft, "fonts/arial.ttf", 0, &face))
-        if (FT_New_Face(ft, "fonts/Roboto-Medium.ttf", 0, &face))
-            spdlog::error("ERROR:FREETYPE Failed to load font");
-
-        if (i == 0)
-            FT_Set_Pixel_Sizes(face, 0, 20);
-        else
-            FT_Set_Pixel_Sizes(face, 0, 64);
-
-        //----------------------
-
-        for (unsigned char c = 0; c < 128; c++)
-        {
-            if (FT_Load_Glyph(face, FT_Get_Char_Index(face, c), FT_LOAD_RENDER)) {
-                spdlog::error("ERROR:FREETYPE Failed to load Glyph");
-                continue;
-            }
-
-            unsigned int texture;
-            glGenTextures(1, &texture);
-            glBindTexture(GL_TEXTURE_2D, texture);
-            glTexImage2D(
-                GL_TEXTURE_2D,
-                0, GL_RED,
-                face->glyph->bitmap.width,
-                face->glyph->bitmap.rows,
-                0,
-                GL_RED,
-                GL_UNSIGNED_BYTE,
-                face->glyph->bitmap.buffer
-            );
-
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-            Character character = {
-                texture,
-                glm::ivec2(face->glyph->bitmap.width, face->glyph->bitmap.rows),
-                glm::ivec2(face->glyph->bitmap_left, face->glyph->bitmap_top),
-                face->glyph->advance.x
-            };
-
-            if (i == 0)
-                characters.insert(std::pair<char, Character>(c, character));
-            else
-                largeCharacters.insert(std::pair<char, Character>(c, character));
-        }
-
-        FT_Done_Face(face);
-        FT_Done_FreeType(ft);
-    }
-    //----------------------
-
+    JobId load = jobSystem.add([this]() {
+        //glyphAtlas.load("fonts/arial.ttf", cacheFolderPath, LABEL_ATLAS_PIXEL_SIZE, LABEL_ATLAS_SPREAD);
+        glyphAtlas.load("fonts/Roboto-Medium.ttf", cacheFolderPath, LABEL_ATLAS_PIXEL_SIZE, LABEL_ATLAS_SPREAD);
+    });
+    jobSystem.addOnCallingThread([this]() {
+        glyphAtlas.upload();
+        logStartupPhase("Glyph atlas sent to GPU");
+    }, { load });
 }
 
 
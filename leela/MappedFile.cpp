@@ -0,0 +1,143 @@
+#include "MappedFile.h"
+#include "spdlog/spdlog.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#define PSAPI_VERSION 2                 // GetProcessMemoryInfo from kernel32; no psapi.lib needed
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdio>
+#endif
+
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& filePath)
+{
+    close();
+
+    HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr) {
+        spdlog::error("Failed to create file mapping for {}", filePath);
+        CloseHandle(file);
+        return false;
+    }
+
+    const void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (data == nullptr) {
+        spdlog::error("Failed to map view of {}", filePath);
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    _fileHandle = file;
+    _mappingHandle = mapping;
+    _data = data;
+    _size = size_t(fileSize.QuadPart);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (_data)
+        UnmapViewOfFile(_data);
+    if (_mappingHandle)
+        CloseHandle(_mappingHandle);
+    if (_fileHandle)
+        CloseHandle(_fileHandle);
+
+    _fileHandle = nullptr;
+    _mappingHandle = nullptr;
+    _data = nullptr;
+    _size = 0;
+}
+
+size_t getResidentMemoryBytes()
+{
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.WorkingSetSize;
+    return 0;
+}
+
+#else
+
+bool MappedFile::open(const std::string& filePath)
+{
+    close();
+
+    int fd = ::open(filePath.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void* data = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        spdlog::error("Failed to memory map {}", filePath);
+        ::close(fd);
+        return false;
+    }
+
+    _fd = fd;
+    _data = data;
+    _size = size_t(st.st_size);
+    return true;
+}
+
+void MappedFile::close()
+{
+    if (_data)
+        munmap(const_cast<void*>(_data), _size);
+    if (_fd >= 0)
+        ::close(_fd);
+
+    _fd = -1;
+    _data = nullptr;
+    _size = 0;
+}
+
+size_t getResidentMemoryBytes()
+{
+    // second field of statm is the resident set size in pages
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (!f)
+        return 0;
+
+    unsigned long long pages = 0, residentPages = 0;
+    int n = fscanf(f, "%llu %llu", &pages, &residentPages);
+    fclose(f);
+
+    if (n != 2)
+        return 0;
+    return size_t(residentPages) * size_t(sysconf(_SC_PAGESIZE));
+}
+
+#endif
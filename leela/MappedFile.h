@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+//
+// Read-only memory mapping of a whole file.
+//  - Pages are brought in by the OS on first access, so opening a large file is nearly free and only the parts
+//    that are touched count towards resident memory.
+//  - Mapping stays valid until close() or destruction.
+//
+class MappedFile
+{
+public:
+    MappedFile() {}
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& filePath);
+    void close();
+
+    bool isOpen() const                             { return _data != nullptr; }
+    const void* data() const                        { return _data; }
+    size_t size() const                             { return _size; }
+
+private:
+#ifdef _WIN32
+    void* _fileHandle = nullptr;
+    void* _mappingHandle = nullptr;
+#else
+    int _fd = -1;
+#endif
+
+    const void* _data = nullptr;
+    size_t _size = 0;
+};
+
+// Resident (working set) memory of this process in bytes.  0 if it can't be determined.
+size_t getResidentMemoryBytes();
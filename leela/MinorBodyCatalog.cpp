@@ -0,0 +1,332 @@
+#include "MinorBodyCatalog.h"
+#include "KeplerSolver.h"
+#include "JobSystem.h"
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include "spdlog/spdlog.h"
+
+
+// Header of the binary cache.  Followed by MinorBodyColumn_Count float columns of `count` entries each.
+struct MinorBodyCacheHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t count;
+    uint64_t sourceSize;                        // size and modification time of the text file the cache was made from
+    int64_t sourceModifiedTime;
+};
+
+static const char MINOR_BODY_CACHE_MAGIC[4] = { 'L', 'M', 'B', 'C' };
+static const uint32_t MINOR_BODY_CACHE_VERSION = 1;
+
+static const double J2000_JULIAN_DAY = 2451545.0;
+static const double DEGREES_TO_RADIANS = M_PI / 180.0;
+
+
+//----------------------------------------------------------------------------------------------
+// MPCORB text parsing
+//----------------------------------------------------------------------------------------------
+
+// Parse a fixed width numeric field.  Returns false if the field is blank or the line is too short.
+static bool _parseField(const char* line, size_t lineLength, size_t start, size_t width, double& value)
+{
+    if (start + width > lineLength)
+        return false;
+
+    char buf[32];
+    memcpy(buf, line + start, width);
+    buf[width] = '\0';
+
+    char* end = nullptr;
+    value = strtod(buf, &end);
+    return end != buf;
+}
+
+// Packed month/day character: 1-9, then A = 10, B = 11, ...
+static int _unpackDigit(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'A' && c <= 'Z')
+        return c - 'A' + 10;
+    return -1;
+}
+
+// Packed epoch (e.g. K24AH = 2024 Oct 17) to days since J2000.  Epochs are at 0h TT.
+static bool _parsePackedEpoch(const char* packed, double& daysSinceJ2000)
+{
+    int century = _unpackDigit(packed[0]);          // I = 18, J = 19, K = 20
+    int month = _unpackDigit(packed[3]);
+    int day = _unpackDigit(packed[4]);
+    if (century < 18 || month < 1 || month > 12 || day < 1 || day > 31 || !isdigit(packed[1]) || !isdigit(packed[2]))
+        return false;
+
+    int year = century * 100 + (packed[1] - '0') * 10 + (packed[2] - '0');
+
+    // Julian day number of the gregorian date
+    int a = (14 - month) / 12;
+    int y = year + 4800 - a;
+    int m = month + 12 * a - 3;
+    long jdn = day + (153 * m + 2) / 5 + 365L * y + y / 4 - y / 100 + y / 400 - 32045;
+
+    daysSinceJ2000 = (double(jdn) - 0.5) - J2000_JULIAN_DAY;
+    return true;
+}
+
+
+bool MinorBodyCatalog::load(const std::string& textFilePath)
+{
+    unload();
+
+    std::error_code ec;
+    uint64_t sourceSize = std::filesystem::file_size(textFilePath, ec);
+    if (ec) {
+        spdlog::info("Minor body catalog {} not found", textFilePath);
+        return false;
+    }
+    int64_t sourceModifiedTime = int64_t(std::filesystem::last_write_time(textFilePath, ec).time_since_epoch().count());
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::string cacheFilePath = textFilePath + ".cache";
+
+    bLoadedFromCache = _mapCache(cacheFilePath, sourceSize, sourceModifiedTime);
+    if (!bLoadedFromCache)
+    {
+        if (!_convertToCache(textFilePath, cacheFilePath, sourceSize, sourceModifiedTime) ||
+            !_mapCache(cacheFilePath, sourceSize, sourceModifiedTime))
+        {
+            spdlog::error("Failed to load minor body catalog {}", textFilePath);
+            unload();
+            return false;
+        }
+    }
+
+    _meanAnomaly.resize(_count);
+    _x.resize(_count);
+    _y.resize(_count);
+    _positions.resize(_count * 3);
+
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+    loadSeconds = elapsed.count();
+    residentMemoryAfterLoad = getResidentMemoryBytes();
+
+    spdlog::info("Loaded {} minor bodies from {} in {:.2f} s ({}).  Resident memory: {:.1f} MB",
+                 _count, bLoadedFromCache ? cacheFilePath : textFilePath, loadSeconds,
+                 bLoadedFromCache ? "memory mapped cache" : "converted text file",
+                 residentMemoryAfterLoad / (1024.0 * 1024.0));
+    return true;
+}
+
+void MinorBodyCatalog::unload()
+{
+    _cache.close();
+    _count = 0;
+    for (int c = 0; c < MinorBodyColumn_Count; c++)
+        _column[c] = nullptr;
+
+    _meanAnomaly.clear();
+    _x.clear();
+    _y.clear();
+    _positions.clear();
+    _evaluatedTime = std::numeric_limits<double>::quiet_NaN();
+}
+
+bool MinorBodyCatalog::_mapCache(const std::string& cacheFilePath, uint64_t sourceSize, int64_t sourceModifiedTime)
+{
+    if (!_cache.open(cacheFilePath))
+        return false;
+
+    const MinorBodyCacheHeader* header = static_cast<const MinorBodyCacheHeader*>(_cache.data());
+    bool valid =
+        _cache.size() >= sizeof(MinorBodyCacheHeader) &&
+        memcmp(header->magic, MINOR_BODY_CACHE_MAGIC, sizeof(header->magic)) == 0 &&
+        header->version == MINOR_BODY_CACHE_VERSION &&
+        header->sourceSize == sourceSize &&
+        header->sourceModifiedTime == sourceModifiedTime &&
+        _cache.size() == sizeof(MinorBodyCacheHeader) + header->count * MinorBodyColumn_Count * sizeof(float);
+
+    if (!valid || header->count == 0) {
+        spdlog::info("Minor body cache {} is out of date", cacheFilePath);
+        _cache.close();
+        return false;
+    }
+
+    _count = size_t(header->count);
+    const float* columns = reinterpret_cast<const float*>(header + 1);
+    for (int c = 0; c < MinorBodyColumn_Count; c++)
+        _column[c] = columns + c * _count;
+
+    return true;
+}
+
+//
+// Parse an MPCORB.DAT style file and write the binary cache.
+//  - Lines before the "-----" separator are header and are skipped.  Files without a header are accepted too.
+//  - Columns (1 based):  21-25 packed epoch,  27-35 M,  38-46 argument of periapsis,  49-57 node,
+//    60-68 inclination,  71-79 e,  81-91 n (deg/day),  93-103 a (AU)
+//  - Mean anomaly is brought from each body's own epoch to J2000 using its mean motion.
+//  - Hyperbolic and parabolic orbits are skipped.
+//
+bool MinorBodyCatalog::_convertToCache(const std::string& textFilePath, const std::string& cacheFilePath,
+                                       uint64_t sourceSize, int64_t sourceModifiedTime)
+{
+    spdlog::info("Converting minor body catalog {} to binary cache", textFilePath);
+
+    std::ifstream in(textFilePath, std::ios::binary);
+    if (!in)
+        return false;
+    std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    size_t pos = 0;
+    size_t separator = text.find("\n-----");
+    if (separator != std::string::npos)
+        pos = text.find('\n', separator + 1);
+
+    std::vector<float> columns[MinorBodyColumn_Count];
+    size_t skipped = 0;
+
+    while (pos != std::string::npos && pos < text.size())
+    {
+        size_t lineStart = (text[pos] == '\n') ? pos + 1 : pos;
+        size_t lineEnd = text.find('\n', lineStart);
+        if (lineEnd == std::string::npos)
+            lineEnd = text.size();
+        pos = lineEnd;
+
+        const char* line = text.c_str() + lineStart;
+        size_t lineLength = lineEnd - lineStart;
+        if (lineLength < 103)
+            continue;                               // blank line or section break
+
+        double M, w, node, incl, e, n, a, epoch;
+        if (!_parseField(line, lineLength, 26, 9, M) ||
+            !_parseField(line, lineLength, 37, 9, w) ||
+            !_parseField(line, lineLength, 48, 9, node) ||
+            !_parseField(line, lineLength, 59, 9, incl) ||
+            !_parseField(line, lineLength, 70, 9, e) ||
+            !_parseField(line, lineLength, 80, 11, n) ||
+            !_parseField(line, lineLength, 92, 11, a) ||
+            !_parsePackedEpoch(line + 20, epoch) ||
+            e >= 1.0 || a <= 0.0)
+        {
+            skipped++;
+            continue;
+        }
+
+        M *= DEGREES_TO_RADIANS;
+        w *= DEGREES_TO_RADIANS;
+        node *= DEGREES_TO_RADIANS;
+        incl *= DEGREES_TO_RADIANS;
+        n *= DEGREES_TO_RADIANS;
+
+        double meanAnomalyAtJ2000 = fmod(M - n * epoch, 2 * M_PI);
+
+        double cw = cos(w), sw = sin(w);
+        double cn = cos(node), sn = sin(node);
+        double ci = cos(incl), si = sin(incl);
+
+        columns[MinorBodyColumn_SemiMajorAxis].push_back(float(a));
+        columns[MinorBodyColumn_Eccentricity].push_back(float(e));
+        columns[MinorBodyColumn_MeanAnomaly].push_back(float(meanAnomalyAtJ2000));
+        columns[MinorBodyColumn_MeanMotion].push_back(float(n));
+        columns[MinorBodyColumn_Px].push_back(float(cw * cn - sw * sn * ci));
+        columns[MinorBodyColumn_Py].push_back(float(cw * sn + sw * cn * ci));
+        columns[MinorBodyColumn_Pz].push_back(float(sw * si));
+        columns[MinorBodyColumn_Qx].push_back(float(-sw * cn - cw * sn * ci));
+        columns[MinorBodyColumn_Qy].push_back(float(-sw * sn + cw * cn * ci));
+        columns[MinorBodyColumn_Qz].push_back(float(cw * si));
+    }
+
+    size_t count = columns[0].size();
+    if (skipped)
+        spdlog::info("Skipped {} unparsable or non-elliptical rows", skipped);
+    if (count == 0) {
+        spdlog::error("No minor bodies found in {}", textFilePath);
+        return false;
+    }
+
+    MinorBodyCacheHeader header;
+    memcpy(header.magic, MINOR_BODY_CACHE_MAGIC, sizeof(header.magic));
+    header.version = MINOR_BODY_CACHE_VERSION;
+    header.count = count;
+    header.sourceSize = sourceSize;
+    header.sourceModifiedTime = sourceModifiedTime;
+
+    // Write to a temporary file first, so that an interrupted write doesn't leave a broken cache to be mapped later.
+    std::string tempPath = cacheFilePath + ".tmp";
+    std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (int c = 0; c < MinorBodyColumn_Count; c++)
+        out.write(reinterpret_cast<const char*>(columns[c].data()), count * sizeof(float));
+    out.close();
+
+    std::error_code ec;
+    if (!out) {
+        spdlog::error("Failed to write minor body cache {}", tempPath);
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+
+    std::filesystem::rename(tempPath, cacheFilePath, ec);
+    if (ec) {
+        spdlog::error("Failed to write minor body cache {}: {}", cacheFilePath, ec.message());
+        return false;
+    }
+    return true;
+}
+
+
+//----------------------------------------------------------------------------------------------
+// Evaluation
+//----------------------------------------------------------------------------------------------
+
+void MinorBodyCatalog::evaluateAt(double days, JobSystem* jobSystem)
+{
+    if (jobSystem)
+        jobSystem->parallelFor(_count, 16384, [this, days](size_t begin, size_t end) { evaluateRange(begin, end, days); });
+    else
+        evaluateRange(0, _count, days);
+    _evaluatedTime = days;
+}
+
+void MinorBodyCatalog::evaluateRange(size_t begin, size_t end, double days)
+{
+    const float* M0 = _column[MinorBodyColumn_MeanAnomaly];
+    const float* n = _column[MinorBodyColumn_MeanMotion];
+
+    for (size_t i = begin; i < end; i++)
+    {
+        double M = M0[i] + n[i] * days;
+        _meanAnomaly[i] = float(M - 2 * M_PI * double((long long) (M * (1.0 / (2 * M_PI)))));
+    }
+
+    keplerOrbitalPlanePositionsBatch(_meanAnomaly.data() + begin,
+                                     _column[MinorBodyColumn_Eccentricity] + begin,
+                                     _column[MinorBodyColumn_SemiMajorAxis] + begin,
+                                     _x.data() + begin, _y.data() + begin, end - begin);
+
+    const float* px = _column[MinorBodyColumn_Px];
+    const float* py = _column[MinorBodyColumn_Py];
+    const float* pz = _column[MinorBodyColumn_Pz];
+    const float* qx = _column[MinorBodyColumn_Qx];
+    const float* qy = _column[MinorBodyColumn_Qy];
+    const float* qz = _column[MinorBodyColumn_Qz];
+    float* out = _positions.data();
+
+    for (size_t i = begin; i < end; i++)
+    {
+        float x = _x[i];
+        float y = _y[i];
+        out[3 * i + 0] = x * px[i] + y * qx[i];
+        out[3 * i + 1] = x * py[i] + y * qy[i];
+        out[3 * i + 2] = x * pz[i] + y * qz[i];
+    }
+}
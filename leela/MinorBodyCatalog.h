@@ -0,0 +1,76 @@
+#pragma once
+
+#include "MappedFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+class JobSystem;
+
+// Per-body columns of the binary cache, stored one after the other (struct of arrays).
+typedef enum
+{
+    MinorBodyColumn_SemiMajorAxis,              // AU
+    MinorBodyColumn_Eccentricity,
+    MinorBodyColumn_MeanAnomaly,                // radians, at J2000
+    MinorBodyColumn_MeanMotion,                 // radians per day
+    MinorBodyColumn_Px,                         // P: unit vector towards periapsis in ecliptic coordinates
+    MinorBodyColumn_Py,
+    MinorBodyColumn_Pz,
+    MinorBodyColumn_Qx,                         // Q: unit vector 90 degrees ahead of P in the orbital plane
+    MinorBodyColumn_Qy,
+    MinorBodyColumn_Qz,
+    MinorBodyColumn_Count
+} MinorBodyColumnEnum;
+
+
+//
+// Orbital elements of a large number of minor bodies (asteroids), loaded from an MPCORB style text file.
+//  - On first use, the text file is parsed and converted to a binary cache next to it (<file>.cache).  The cache
+//    is rebuilt when the text file's size or modification time changes.
+//  - The cache is memory mapped, not read.  Orientation of each orbit (i, node, argument of periapsis) is
+//    stored as the P and Q vectors, so evaluation needs no trigonometry other than the Kepler solve.
+//  - evaluateAt() advances all bodies in bulk with the batched Kepler solver and writes heliocentric ecliptic
+//    positions (AU, x y z interleaved) ready to be sent to the GPU.
+//
+class MinorBodyCatalog
+{
+public:
+    bool load(const std::string& textFilePath);
+    void unload();
+
+    bool isLoaded() const                               { return _count != 0; }
+    size_t size() const                                 { return _count; }
+    const float* column(MinorBodyColumnEnum c) const    { return _column[c]; }
+
+    // Evaluate positions at `days` since J2000.  Split across the job system's threads if one is given.
+    void evaluateAt(double days, JobSystem* jobSystem = nullptr);
+    void evaluateRange(size_t begin, size_t end, double days);
+    double evaluatedTime() const                        { return _evaluatedTime; }
+    const std::vector<float>& positions() const         { return _positions; }
+
+    // Load statistics
+    bool bLoadedFromCache = false;
+    double loadSeconds = 0.0;
+    size_t residentMemoryAfterLoad = 0;
+
+private:
+    bool _mapCache(const std::string& cacheFilePath, uint64_t sourceSize, int64_t sourceModifiedTime);
+    bool _convertToCache(const std::string& textFilePath, const std::string& cacheFilePath,
+                         uint64_t sourceSize, int64_t sourceModifiedTime);
+
+private:
+    MappedFile _cache;
+    size_t _count = 0;
+    const float* _column[MinorBodyColumn_Count] = {};
+
+    // evaluation scratch, one entry per body
+    std::vector<float> _meanAnomaly;
+    std::vector<float> _x;
+    std::vector<float> _y;
+
+    std::vector<float> _positions;
+    double _evaluatedTime = std::numeric_limits<double>::quiet_NaN();
+};
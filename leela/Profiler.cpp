@@ -0,0 +1,288 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+
+#include "spdlog/spdlog.h"
+
+#ifndef _MSC_VER
+#include <cxxabi.h>
+#endif
+
+
+void Profiler::init()
+{
+    _bGpu = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+    if (!_bGpu) {
+        spdlog::warn("Timer queries not supported; the profiler measures CPU time only");
+        return;
+    }
+    _calibrate();
+}
+
+
+int64_t Profiler::_nowNs() const
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+
+// The two clocks drift apart slowly; called every HISTORY_SIZE frames.
+void Profiler::_calibrate()
+{
+    GLint64 gpuNow = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+    _gpuToCpuNs = int64_t(gpuNow) - _nowNs();
+}
+
+
+void Profiler::beginFrame()
+{
+    _bFrameActive = bEnabled;
+    if (!_bFrameActive)
+        return;
+
+    _frameSlot = int(_frameNumber % FRAMES_IN_FLIGHT);
+    Frame& frame = _frames[_frameSlot];
+
+    // The frame that last used this query set is FRAMES_IN_FLIGHT frames old
+    if (frame.historyIndex >= 0)
+        _resolve(frame);
+
+    frame.scopes.clear();
+    frame.numQueries = 0;
+    frame.historyIndex = int(_frameNumber % HISTORY_SIZE);
+    frame.bGpuResolved = false;
+    _openScopes.clear();
+
+    if (_bGpu && frame.historyIndex == 0)
+        _calibrate();
+
+    begin("Frame");
+}
+
+
+void Profiler::endFrame()
+{
+    if (!_bFrameActive)
+        return;
+
+    while (!_openScopes.empty())
+        end();
+
+    Frame& frame = _frames[_frameSlot];
+    int h = frame.historyIndex;
+    for (Series& s : _series) {
+        s.cpuMs[h] = 0.0f;
+        s.gpuMs[h] = 0.0f;
+    }
+    for (const Scope& scope : frame.scopes)
+        _series[scope.series].cpuMs[h] += float(scope.cpuEndNs - scope.cpuBeginNs) * 1e-6f;
+
+    _historyIndex = h;
+    _frameNumber++;
+    _bFrameActive = false;
+}
+
+
+void Profiler::begin(const char* name)
+{
+    _begin(name, false);
+}
+
+void Profiler::begin(const std::type_info& type)
+{
+    _begin(type.name(), true);
+}
+
+void Profiler::_begin(const char* key, bool bTypeName)
+{
+    if (!_bFrameActive)
+        return;
+
+    Frame& frame = _frames[_frameSlot];
+    int parent = _openScopes.empty() ? -1 : frame.scopes[_openScopes.back()].series;
+
+    Scope scope;
+    scope.series = _findSeries(parent, key, bTypeName);
+    scope.queryBegin = _timestamp(frame);
+    scope.queryEnd = -1;
+    scope.cpuBeginNs = _nowNs();
+    scope.cpuEndNs = scope.cpuBeginNs;
+
+    _openScopes.push_back(int(frame.scopes.size()));
+    frame.scopes.push_back(scope);
+}
+
+
+void Profiler::end()
+{
+    if (!_bFrameActive || _openScopes.empty())
+        return;
+
+    Frame& frame = _frames[_frameSlot];
+    Scope& scope = frame.scopes[_openScopes.back()];
+    _openScopes.pop_back();
+
+    scope.cpuEndNs = _nowNs();
+    scope.queryEnd = _timestamp(frame);
+}
+
+
+// Class name for display, from type_info::name(): "class X" with MSVC, mangled with GCC and Clang.
+static std::string typeDisplayName(const char* typeName)
+{
+    std::string name = typeName;
+#ifdef _MSC_VER
+    for (const char* prefix : { "class ", "struct " }) {
+        if (name.rfind(prefix, 0) == 0)
+            name.erase(0, strlen(prefix));
+    }
+#else
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(typeName, nullptr, nullptr, &status);
+    if (status == 0 && demangled)
+        name = demangled;
+    free(demangled);
+#endif
+    return name;
+}
+
+
+int Profiler::_findSeries(int parent, const char* key, bool bTypeName)
+{
+    const std::vector<int>& siblings = (parent >= 0) ? _series[parent].children : _roots;
+    for (int i : siblings) {
+        if (_series[i].key == key || strcmp(_series[i].key, key) == 0)
+            return i;
+    }
+
+    Series s;
+    s.key = key;
+    s.name = bTypeName ? typeDisplayName(key) : std::string(key);
+    s.parent = parent;
+    s.depth = (parent >= 0) ? _series[parent].depth + 1 : 0;
+
+    int index = int(_series.size());
+    _series.push_back(std::move(s));
+    if (parent >= 0)
+        _series[parent].children.push_back(index);
+    else
+        _roots.push_back(index);
+    return index;
+}
+
+
+// Issues a timestamp query; returns its index in the query set of the frame.
+int Profiler::_timestamp(Frame& frame)
+{
+    if (!_bGpu)
+        return -1;
+
+    if (frame.numQueries == int(frame.queries.size())) {
+        size_t oldSize = frame.queries.size();
+        frame.queries.resize(std::max<size_t>(64, oldSize * 2));
+        glGenQueries(GLsizei(frame.queries.size() - oldSize), frame.queries.data() + oldSize);
+    }
+
+    glQueryCounter(frame.queries[frame.numQueries], GL_TIMESTAMP);
+    return frame.numQueries++;
+}
+
+
+// Reads the GPU times of a finished frame if they're in, and keeps it for the trace.
+void Profiler::_resolve(Frame& frame)
+{
+    if (_bGpu && frame.numQueries > 0) {
+        // Commands complete in order, so once the last timestamp is in, all of them are
+        GLint available = 0;
+        glGetQueryObjectiv(frame.queries[frame.numQueries - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+
+        if (available) {
+            int h = frame.historyIndex;
+            for (Scope& scope : frame.scopes) {
+                GLuint64 gpuBegin = 0;
+                GLuint64 gpuEnd = 0;
+                glGetQueryObjectui64v(frame.queries[scope.queryBegin], GL_QUERY_RESULT, &gpuBegin);
+                glGetQueryObjectui64v(frame.queries[scope.queryEnd], GL_QUERY_RESULT, &gpuEnd);
+                scope.gpuBeginNs = int64_t(gpuBegin);
+                scope.gpuEndNs = int64_t(gpuEnd);
+                _series[scope.series].gpuMs[h] += float(scope.gpuEndNs - scope.gpuBeginNs) * 1e-6f;
+            }
+            frame.bGpuResolved = true;
+        }
+    }
+
+    Frame traced;
+    traced.scopes = frame.scopes;
+    traced.historyIndex = frame.historyIndex;
+    traced.bGpuResolved = frame.bGpuResolved;
+    _trace.push_back(std::move(traced));
+    while (_trace.size() > TRACE_FRAMES)
+        _trace.pop_front();
+}
+
+
+static void writeJsonString(std::ostream& out, const std::string& s)
+{
+    out << '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\')
+            out << '\\';
+        out << c;
+    }
+    out << '"';
+}
+
+
+//
+// Trace Event Format: complete ("X") events with timestamps and durations in microseconds.  CPU scopes are on
+// thread 1, GPU scopes on thread 2.  GPU timestamps are moved onto the CPU clock, so the lag of the GPU behind the
+// CPU shows.
+//
+bool Profiler::writeChromeTrace(const std::string& path) const
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        spdlog::error("Couldn't write trace file {}", path);
+        return false;
+    }
+
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Leela\"}},\n";
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n";
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+
+    auto writeEvent = [&](const Scope& scope, int tid, int64_t beginNs, int64_t endNs) {
+        out << ",\n{\"name\":";
+        writeJsonString(out, _series[scope.series].name);
+        out << ",\"cat\":\"" << (tid == 1 ? "cpu" : "gpu") << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+            << ",\"ts\":" << double(beginNs) * 1e-3 << ",\"dur\":" << double(endNs - beginNs) * 1e-3 << "}";
+    };
+
+    size_t numEvents = 0;
+    for (const Frame& frame : _trace) {
+        for (const Scope& scope : frame.scopes) {
+            writeEvent(scope, 1, scope.cpuBeginNs, scope.cpuEndNs);
+            numEvents++;
+            if (frame.bGpuResolved) {
+                writeEvent(scope, 2, scope.gpuBeginNs - _gpuToCpuNs, scope.gpuEndNs - _gpuToCpuNs);
+                numEvents++;
+            }
+        }
+    }
+    out << "\n]}\n";
+
+    if (!out) {
+        spdlog::error("Couldn't write trace file {}", path);
+        return false;
+    }
+    spdlog::info("Wrote {} frames, {} events, to trace file {}", _trace.size(), numEvents, path);
+    return true;
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <typeinfo>
+#include <vector>
+
+//
+// CPU and GPU time spent in the parts of a frame.
+//  - begin()/end() pairs, or a ProfileScope, mark the parts.  They nest.  Parts with the same name under the same
+//    parent are one series; a series is timed in total for the frame however many times it runs.
+//  - CPU time is wall clock time on the calling thread.  GPU time is measured with GL timestamp queries around
+//    the commands issued in between.
+//  - Queries are double buffered: the results of a frame are read FRAMES_IN_FLIGHT frames later, when the GPU is
+//    normally done with it.  If it isn't, that frame has no GPU times rather than waiting for them.
+//  - Each series keeps the times of the last HISTORY_SIZE frames.  The scopes of the last TRACE_FRAMES frames are
+//    kept for writeChromeTrace(), which writes them in the Trace Event Format of chrome://tracing and Perfetto.
+//  - Names must outlive the profiler, e.g. string literals.  begin(typeid(x)) names the part after the class of x,
+//    readable with both MSVC and GCC.  Main thread only.
+//
+class Profiler
+{
+public:
+    static constexpr int HISTORY_SIZE = 240;
+    static constexpr int FRAMES_IN_FLIGHT = 2;
+    static constexpr int TRACE_FRAMES = 300;
+
+    struct Series
+    {
+        const char* key;                            // name as passed to begin(), or type_info::name()
+        std::string name;                           // for display
+        int parent;                                 // -1 for the root
+        int depth;
+        std::vector<int> children;                  // in the order they first ran
+        float cpuMs[HISTORY_SIZE] = {};
+        float gpuMs[HISTORY_SIZE] = {};             // 0 until the results of the frame are in
+    };
+
+    void init();                                    // GL query objects; needs the context
+    void beginFrame();
+    void endFrame();
+
+    void begin(const char* name);
+    void begin(const std::type_info& type);
+    void end();
+
+    bool writeChromeTrace(const std::string& path) const;
+
+    const std::vector<Series>& series() const      { return _series; }
+    const std::vector<int>& roots() const           { return _roots; }
+    int newestHistoryIndex() const                  { return _historyIndex; }       // of the last finished frame
+
+public:
+    bool bEnabled = true;
+
+private:
+    struct Scope
+    {
+        int series;
+        int64_t cpuBeginNs;
+        int64_t cpuEndNs;
+        int queryBegin;                             // in the query set of the frame; -1 without GPU timing
+        int queryEnd;
+        int64_t gpuBeginNs = 0;                     // GPU clock; filled in when resolved
+        int64_t gpuEndNs = 0;
+    };
+
+    struct Frame
+    {
+        std::vector<Scope> scopes;                  // in the order they began
+        std::vector<GLuint> queries;
+        int numQueries = 0;
+        int historyIndex = -1;
+        bool bGpuResolved = false;
+    };
+
+    int64_t _nowNs() const;
+    void _calibrate();
+    void _begin(const char* key, bool bTypeName);
+    int _findSeries(int parent, const char* key, bool bTypeName);
+    int _timestamp(Frame& frame);
+    void _resolve(Frame& frame);
+
+private:
+    std::vector<Series> _series;
+    std::vector<int> _roots;
+    Frame _frames[FRAMES_IN_FLIGHT];
+    int _frameSlot = 0;
+    uint64_t _frameNumber = 0;
+    int _historyIndex = 0;
+    bool _bFrameActive = false;
+    bool _bGpu = false;                             // timestamp queries supported and init() called
+    std::vector<int> _openScopes;                   // indices into the scopes of the current frame
+
+    int64_t _gpuToCpuNs = 0;                        // subtracted from GPU timestamps to put them on the CPU clock
+    std::deque<Frame> _trace;
+};
+
+
+// Times the enclosing block
+class ProfileScope
+{
+public:
+    ProfileScope(Profiler& profiler, const char* name)
+        : _profiler(profiler)
+    {
+        _profiler.begin(name);
+    }
+
+    ~ProfileScope()
+    {
+        _profiler.end();
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    Profiler& _profiler;
+};
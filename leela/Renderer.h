@@ -4,6 +4,7 @@
 #include "GlslProgram.h"
 #include <spdlog/spdlog.h>
 #include "UniverseMinimal.h"
+#include "Culling.h"
 
 //
 // Render certain aspects of a scene object.
@@ -20,4 +21,16 @@ public:
 
 	virtual void render(ViewportType viewportType, RenderStage renderStage, GlslProgram& glslProgram) = 0;
 
+	// Whether render() draws anything for the given combination.  Used to build the per-stage render lists once
+	// when the scene changes, so the answer must not depend on state that can change from frame to frame.
+	// Such conditions (show/hide flags, etc.) are checked in render().
+	virtual bool rendersIn(ViewportType viewportType, RenderStage renderStage, GlslProgramType programType) = 0;
+
+	// True if render() currently draws something outside its scene object's drawnBounds().  The object is then
+	// never culled as a whole.
+	virtual bool drawsOutsideBounds() { return false; }
+
+	// Opaque sphere that render() currently draws, which hides whatever is behind it.  Unbounded if none.
+	virtual BoundingSphere occluderBounds() { return BoundingSphere(); }
+
 };
\ No newline at end of file
@@ -1,23 +1,91 @@
 #include "SceneObject.h"
 #include "Component.h"
+#include <algorithm>
+
+
+unsigned int SceneObject::_topologyGeneration = 1;
+unsigned int SceneObject::_transformsComputed = 0;
+unsigned int SceneObject::_transformsReused = 0;
+
+
+SceneObject::TransformCacheStats SceneObject::takeTransformCacheStats()
+{
+    TransformCacheStats stats;
+    stats.computed = _transformsComputed;
+    stats.reused = _transformsReused;
+    _transformsComputed = 0;
+    _transformsReused = 0;
+    return stats;
+}
+
+void SceneObject::invalidateTransforms()
+{
+    _positionTransform.bValid = false;
+    _orientationTransform.bValid = false;
+    _transform.bValid = false;
+
+    for (SceneObject* o : _childSceneObjects)
+        o->invalidateTransforms();
+}
 
 
 // transform to move this scene object from its parent's position
-glm::mat4 SceneObject::getPositionTransform()
+glm::mat4 SceneObject::computePositionTransform()
 {
     return glm::mat4(1.0f);
 }
 
 // transform to rotate/orient this object in its local coordinate system
-glm::mat4 SceneObject::getOrientationTransform()
+glm::mat4 SceneObject::computeOrientationTransform()
 {
     return glm::mat4(1.0f);
 }
 
+glm::mat4 SceneObject::getPositionTransform()
+{
+    if (!_positionTransform.bValid) {
+        _positionTransform.mat = computePositionTransform();
+        _positionTransform.bValid = true;
+        _transformsComputed++;
+    }
+    else {
+        _transformsReused++;
+    }
+    return _positionTransform.mat;
+}
+
+glm::mat4 SceneObject::getOrientationTransform()
+{
+    if (!_orientationTransform.bValid) {
+        _orientationTransform.mat = computeOrientationTransform();
+        _orientationTransform.bValid = true;
+        _transformsComputed++;
+    }
+    else {
+        _transformsReused++;
+    }
+    return _orientationTransform.mat;
+}
+
+// Default: step forward (or backward) from the last evaluated time.
+void SceneObject::evaluateAt(double t)
+{
+    advance(float(t - _evaluatedTime));
+    _evaluatedTime = t;
+}
+
 // combined transform
 glm::mat4 SceneObject::getTransform()
 {
-    return getPositionTransform() * getOrientationTransform();
+    if (!_transform.bValid) {
+        _transform.mat = getPositionTransform() * getOrientationTransform();
+        _transform.bValid = true;
+        _transformsComputed++;
+    }
+    else {
+        _transformsReused++;
+    }
+    return _transform.mat;
 }
 
 void SceneObject::addComponent(Component* component)
@@ -28,11 +96,18 @@ void SceneObject::addComponent(Component* component)
     if (r)
         _renderers.push_back(r);
 
+    _topologyGeneration++;
 }
 
 void SceneObject::removeComponent(Component* component)
 {
-    // TODO
+    _components.erase(std::remove(_components.begin(), _components.end(), component), _components.end());
+
+    Renderer* r = dynamic_cast<Renderer*>(component);
+    if (r)
+        _renderers.erase(std::remove(_renderers.begin(), _renderers.end(), r), _renderers.end());
+
+    _topologyGeneration++;
 }
 
 // Add a child scene object
@@ -40,12 +115,14 @@ void SceneObject::addSceneObject(SceneObject* childObject)
 {
     childObject->_setParent(this);					// tell the child it has a new parent
     _childSceneObjects.push_back(childObject);
+    _topologyGeneration++;
 }
 
 void SceneObject::_setParent(SceneObject* parent)
 {
     _sceneParent = parent;
     parentChanged();		// allow subclasses to process this change
+    invalidateTransforms();
 }
 
 void SceneObject::_printIndent(int indent)
@@ -109,3 +186,43 @@ void SceneObject::setHidden(bool hide)
     _hidden = hide;
 }
 
+
+
+//----------------------------------------------------------------------------------------------
+
+// Returns the scene tree in pre-order.  Parent's index is always lower than its children's.
+const std::vector<Scene::FlatNode>& Scene::flattened()
+{
+    if (_flattenedTopologyGeneration == topologyGeneration())
+        return _flattened;
+
+    _flattened.clear();
+
+    // Iterative pre-order walk.  `subtreeEnd` of a node is filled in once all its descendants have been visited.
+    std::vector<std::pair<SceneObject*, int>> stack;        // object, index of its node (-1 until visited)
+    stack.push_back({ this, -1 });
+
+    while (!stack.empty())
+    {
+        SceneObject* obj = stack.back().first;
+        int nodeIndex = stack.back().second;
+
+        if (nodeIndex == -1)
+        {
+            stack.back().second = int(_flattened.size());
+            _flattened.push_back({ obj, 0 });
+
+            // push children in reverse so that they are visited in their original order.
+            for (auto it = obj->_childSceneObjects.rbegin(); it != obj->_childSceneObjects.rend(); ++it)
+                stack.push_back({ *it, -1 });
+        }
+        else
+        {
+            _flattened[nodeIndex].subtreeEnd = int(_flattened.size());
+            stack.pop_back();
+        }
+    }
+
+    _flattenedTopologyGeneration = topologyGeneration();
+    return _flattened;
+}
@@ -9,6 +9,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <Renderer.h>
+#include "Culling.h"
 
 class Component;
 
@@ -20,22 +21,61 @@ public:
     {	
     }
 
+    virtual ~SceneObject() = default;
+
     virtual void init() = 0;
     virtual void advance(float stepMultiplier) = 0;
 
+    // Bring this scene object to absolute simulation time `t` (in reference frame steps).
+    //  - Default implementation falls back to stepping by the difference from the last evaluated time.
+    //  - Subclasses that can compute their state in closed form (e.g. SphericalBody) override this so that
+    //    a jump to any time costs the same as a single step.
+    virtual void evaluateAt(double t);
+
     // subclass of SceneObject is expected to examine _sceneParent in order to typecast it and save it as a pointer to the desired subclass.
     //  - For e.g. SphericalBody class might want to know if _sceneParent is another SphericalBody instance, and use it later.
     virtual void parentChanged() {}
 
     // transform to move this scene object from its parent's position
-    virtual glm::mat4 getPositionTransform();
+    //  - The get*Transform() functions return cached matrices. They are computed at most once until invalidateTransforms() is called
+    //    on this object or one of its ancestors.
+    glm::mat4 getPositionTransform();
 
     // transform to rotate/orient this object in its local coordinate system
-    virtual glm::mat4 getOrientationTransform();
+    glm::mat4 getOrientationTransform();
 
     // combined transform
     glm::mat4 getTransform();
 
+    // Invalidate cached transforms of this object and its descendants, whose positions are relative to it.
+    //  - Called on the scene once per frame after it is evaluated, and by setters that change something a transform
+    //    depends on.
+    void invalidateTransforms();
+
+    // Number of transforms computed and number served from the cache.
+    struct TransformCacheStats
+    {
+        unsigned int computed = 0;
+        unsigned int reused = 0;
+    };
+    // Counts since the last call, and starts counting again.  Transforms are cached and counted on the main thread only.
+    static TransformCacheStats takeTransformCacheStats();
+
+    // Bounding spheres for culling.  Unbounded by default.
+    //  - bodyBounds: the object itself.  Tested for being hidden behind other objects.
+    //  - drawnBounds: everything this object's renderers draw, e.g. a body with its orbit around the parent.
+    virtual BoundingSphere bodyBounds()                     { return BoundingSphere(); }
+    virtual BoundingSphere drawnBounds()                    { return bodyBounds(); }
+
+    // Bumped whenever scene objects or components are added/removed anywhere.
+    static unsigned int topologyGeneration()                { return _topologyGeneration; }
+
+protected:
+    // Subclasses override these to compute transforms.  Parent's transform must be obtained with its get*Transform().
+    virtual glm::mat4 computePositionTransform();
+    virtual glm::mat4 computeOrientationTransform();
+
+public:
     void addComponent(Component* component);
     void removeComponent(Component* component);
 
@@ -61,15 +101,46 @@ public:
     bool _hidden = false;                           // if hidden, none of its components will be processed.
     SceneObject * _sceneParent = nullptr;
     std::string _name;
+    double _evaluatedTime = 0.0;                    // simulation time this object was last evaluated at.
+    bool _bodyCulled = false;                       // set for the viewport being drawn: body is out of view or behind another body
+
+private:
+    struct CachedTransform
+    {
+        glm::mat4 mat = glm::mat4(1.0f);
+        bool bValid = false;
+    };
+    CachedTransform _positionTransform;
+    CachedTransform _orientationTransform;
+    CachedTransform _transform;
+
+    static unsigned int _topologyGeneration;
+    static unsigned int _transformsComputed;
+    static unsigned int _transformsReused;
 };
 
 
 
 //
 // A comcrete SceneObject intended to be used as the top-level scene object.
+//  - Keeps the tree under it flattened in parent-before-child (pre-order) order, so that passes over the whole
+//    scene can iterate an array instead of recursing.  Rebuilt only when the topology changes.
 //
 class Scene : public SceneObject
 {
+public:
+    struct FlatNode
+    {
+        SceneObject* object;
+        int subtreeEnd;                 // index one past the last descendant of `object`.  Jump here to skip the subtree.
+    };
+
     void init() {}
-    void advance(float stepMultiplier) {}
+    void advance(float) {}                         // the scene itself doesn't move
+
+    const std::vector<FlatNode>& flattened();
+
+private:
+    std::vector<FlatNode> _flattened;
+    unsigned int _flattenedTopologyGeneration = 0;
 };
\ No newline at end of file
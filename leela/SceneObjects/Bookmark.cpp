@@ -5,3 +5,9 @@ void Bookmark::parentChanged()
 {
     _sphericalBody = dynamic_cast<SphericalBody*>(_sceneParent);
 }
+
+// The bookmarked point on the parent's surface
+BoundingSphere Bookmark::bodyBounds()
+{
+    return BoundingSphere(_sphericalBody->getTransformedLatitudeLongitude(_lat, _lon), 0.0f);
+}
@@ -13,6 +13,7 @@ public:
 	void init() {}
 	void advance(float stepMultiplier) {}
 	virtual void parentChanged();
+	BoundingSphere bodyBounds();
 
 	void set(std::string label, float lat, float lon)
 	{
@@ -13,7 +13,7 @@ public:
 	virtual void init() {}
 	virtual void advance(float stepMultiplier) {}
 
-	virtual glm::mat4 getPositionTransform() {
+	virtual glm::mat4 computePositionTransform() {
 		glm::mat4 mat(1.0f);
 
 		//-------------------------------------------------------------------
@@ -1,9 +1,14 @@
 #include "SphericalBody.h"
+#include "KeplerSolver.h"
+#include "Culling.h"
+#include <algorithm>
 
 
 void SphericalBody::setOrbitalAngle(float orbitalAngle, bool calculateDependencies)
 {
-    _orbitalAngle = orbitalAngle;
+    this->orbitalAngle() = orbitalAngle;
+    eccentricAnomaly() = keplerSolveEccentricAnomaly(orbitalAngle, eccentricity());
+    invalidateTransforms();
     if (calculateDependencies) {
         calculateCenterPosition();
     }
@@ -13,12 +18,13 @@ void SphericalBody::setRotationParameters(float radius, float rotationAngle, flo
 {
     _radius = radius;
     _radius_Backup = _radius;
-    _rotationAngle = rotationAngle;
-    _rotationAngularVelocity = rotationAngularVelocity;
-    _axisTiltOrientationAngle = axisTiltOrientationAngle;
+    this->rotationAngle() = rotationAngle;
+    this->rotationAngularVelocity() = rotationAngularVelocity;
+    this->axisTiltOrientationAngle() = axisTiltOrientationAngle;
     _axisTiltAngle = axisTiltAngle;
     _axisTiltAngle_Backup = axisTiltAngle;
     _axisTiltAngle_Deg = glm::degrees(_axisTiltAngle);
+    invalidateTransforms();
 }
 
 void SphericalBody::setOrbitalParameters(float orbitalRadius, float orbitalAngle, float orbitalAngularVelocity, float nodalPrecessionInitialAngle, float orbitalPlaneTiltAngle)
@@ -26,68 +32,50 @@ void SphericalBody::setOrbitalParameters(float orbitalRadius, float orbitalAngle
     setOrbitalRadius(orbitalRadius);
     _orbitalRadius_Backup = _orbitalRadius;
 
-    _orbitalAngle = orbitalAngle;
-    _orbitalAngularVelocity = orbitalAngularVelocity;
-    _nodalPrecessionAngle = nodalPrecessionInitialAngle;
+    this->orbitalAngle() = orbitalAngle;
+    this->orbitalAngularVelocity() = orbitalAngularVelocity;
+    nodalPrecessionAngle() = nodalPrecessionInitialAngle;
     _orbitalPlaneTiltAngle = orbitalPlaneTiltAngle;
     _orbitalPlaneTiltAngle_Deg = glm::degrees(_orbitalPlaneTiltAngle);
+    invalidateTransforms();
 }
 
+void SphericalBody::setOrbitShape(float eccentricity, float argumentOfPeriapsis)
+{
+    this->eccentricity() = eccentricity;
+    eccentricAnomaly() = keplerSolveEccentricAnomaly(orbitalAngle(), eccentricity);
+    _argumentOfPeriapsis = argumentOfPeriapsis;
+    invalidateTransforms();
+}
 
 
 
 void SphericalBody::advance(float stepMultiplier)
 {
-    if (bRotationMotion)
-    {
-        float increment = _rotationAngularVelocity;
-        if (bSyncWithRevolution)
-            increment = _orbitalAngularVelocity * 356.25f;
-
-        _rotationAngle += increment * stepMultiplier;
-        _rotationAngle = _normalizeAngle(_rotationAngle);
-    }
-
-    if (bRevolutionMotion)
-    {
-        float increment = _orbitalAngularVelocity;
-        if (bOrbitalRevolutionSyncToParent) {
-            if (_sphericalBodyParent != nullptr)
-                increment = _sphericalBodyParent->_orbitalAngularVelocity * 12.3f;       // hardcode for moon
-        }
-
-        _orbitalAngle += increment * stepMultiplier;
-        _orbitalAngle = _normalizeAngle(_orbitalAngle);
-    }
-
-    if (bPrecessionMotion)
-    {
-        _axisRotationAngle -= 0.005f * stepMultiplier;
-        _axisRotationAngle = _normalizeAngle(_axisRotationAngle);
+    evaluateAt(_evaluatedTime + stepMultiplier);
+}
 
-        _axisTiltOrientationAngle -= 0.01f * stepMultiplier;
-        _axisTiltOrientationAngle = _normalizeAngle(_axisTiltOrientationAngle);
-    }
-    if (bOrbitalPlaneRotation)
-    {
-        float increment = 0.005f;
-        if (bNodalPrecessionSpeedSyncToParentsRevolution) {         // e.g. Moon's nodal precession with earth's revolution period with a factor of 18.6
-            //spdlog::info("applying orbital plane rotation sync'd to parent's revolution");
-            //spdlog::info("_parent = {}", fmt::ptr(_parent));
-
-            if (_sphericalBodyParent != nullptr)
-                increment = _sphericalBodyParent->_orbitalAngularVelocity / 18.6;        // hardcode this for moon
-        }
-        _nodalPrecessionAngle -= increment * stepMultiplier;
-        _nodalPrecessionAngle = _normalizeAngle(_nodalPrecessionAngle);
+//
+// Bring this body to absolute simulation time `t`.
+//  - The angles of all bodies are normally evaluated together by BodyStore::evaluateAt() before the scene
+//    tree is walked.  In that case only the position is calculated here.
+//
+void SphericalBody::evaluateAt(double t)
+{
+    if (_store->evaluatedTime() != t) {
+        _store->evaluateBodyAt(_bodyIndex, t);
+        invalidateTransforms();
     }
 
+    _evaluatedTime = t;
     calculateCenterPosition();
 }
 
 void SphericalBody::parentChanged()
 {
     _sphericalBodyParent = dynamic_cast<SphericalBody*>(_sceneParent);
+    if (_sphericalBodyParent != nullptr && _sphericalBodyParent->_store == _store)
+        _store->setParent(_bodyIndex, _sphericalBodyParent->_bodyIndex);
 }
 
 
@@ -140,7 +128,7 @@ glm::vec3 SphericalBody::getTransformedLatitudeLongitude(float lat, float lon, f
 
 // Transforms a point on an upright sphere at origin to the tilted sphere at origin.
 //    - use axial tilt, rotation position and precession of the sphere.
-glm::mat4 SphericalBody::getOrientationTransform()
+glm::mat4 SphericalBody::computeOrientationTransform()
 {
     glm::mat4 mat(1.0f);
 
@@ -155,7 +143,7 @@ glm::mat4 SphericalBody::getOrientationTransform()
     glm::vec3 axisTiltOrientationAxis = getAxisTiltOrientationAxis();
 
     mat = glm::rotate(mat, _axisTiltAngle, axisTiltOrientationAxis);
-    mat = glm::rotate(mat, _rotationAngle, glm::vec3(0.0f, 0.0f, 1.0f));
+    mat = glm::rotate(mat, rotationAngle(), glm::vec3(0.0f, 0.0f, 1.0f));
 
     return mat;
 }
@@ -164,7 +152,7 @@ glm::mat4 SphericalBody::getOrientationTransform()
 // returns a vec3 in x-y plane (z=0)
 glm::vec3 SphericalBody::getAxisTiltOrientationAxis()
 {
-    glm::vec3 axisTiltOrientationAxis = glm::vec3(cos(_axisTiltOrientationAngle), sin(_axisTiltOrientationAngle), 0.0f);
+    glm::vec3 axisTiltOrientationAxis = glm::vec3(cos(axisTiltOrientationAngle()), sin(axisTiltOrientationAngle()), 0.0f);
     return axisTiltOrientationAxis;
 }
 
@@ -177,13 +165,55 @@ glm::mat4 SphericalBody::getOrbitalPlaneModelMatrix()
     if (_sceneParent != nullptr)
     {
         modelTrans = _sceneParent->getPositionTransform();
-        modelTrans = glm::rotate(modelTrans, _nodalPrecessionAngle, glm::vec3(0.0f, 0.0f, 1.0f));
+        modelTrans = glm::rotate(modelTrans, nodalPrecessionAngle(), glm::vec3(0.0f, 0.0f, 1.0f));
         modelTrans = glm::rotate(modelTrans, _orbitalPlaneTiltAngle, glm::vec3(0.0f, 1.0f, 0.0f));
     }
 
     return modelTrans;
 }
 
+// Sphere, including the rotation axis which sticks out of the poles.
+BoundingSphere SphericalBody::bodyBounds()
+{
+    return BoundingSphere(_center, _radius * 1.3f);
+}
+
+// Sphere plus the orbit and orbital plane, which are centered at the parent.
+BoundingSphere SphericalBody::drawnBounds()
+{
+    BoundingSphere bounds = bodyBounds();
+
+    if (_sceneParent != nullptr && _orbitalRadius > 0.0f)
+    {
+        // orbital plane is a square of side 2.4 times the orbital radius; the orbit fits in it unless it's very eccentric.
+        float orbitExtent = _orbitalRadius * std::max(1.2f * float(M_SQRT2), 1.0f + eccentricity());
+        bounds.merge(BoundingSphere(glm::vec3(_sceneParent->getPositionTransform()[3]), orbitExtent));
+    }
+
+    return bounds;
+}
+
+void SphericalBody::updateShadowCasters()
+{
+    _shadowCasters.clear();
+    if (_sunSphere == nullptr)
+        return;
+
+    BoundingSphere sun(_sunSphere->_center, _sunSphere->_radius);
+    BoundingSphere self(_center, _radius);
+
+    for (SphericalBody* related : _relatedSpheres)
+    {
+        if (related != nullptr && isInShadowCone(sun, BoundingSphere(related->_center, related->_radius), self))
+            _shadowCasters.push_back(related);
+    }
+
+    // closest first, so that the ones that matter most are kept if the shader takes fewer
+    std::sort(_shadowCasters.begin(), _shadowCasters.end(), [this](SphericalBody* a, SphericalBody* b) {
+        return glm::distance(a->_center, _center) < glm::distance(b->_center, _center);
+    });
+}
+
 glm::vec3 SphericalBody::getModelTransformedCenter()
 {
     return _center;
@@ -191,7 +221,7 @@ glm::vec3 SphericalBody::getModelTransformedCenter()
 
 // Get the model matrix of the center of this sphere.
 // - This includes first getting the parent's center's model matrix.
-glm::mat4 SphericalBody::getPositionTransform()
+glm::mat4 SphericalBody::computePositionTransform()
 {
     glm::mat4 mat(1.0f);
 
@@ -206,7 +236,7 @@ glm::mat4 SphericalBody::getPositionTransform()
     // apply nodal precession
     mat = glm::rotate(
         mat,
-        _nodalPrecessionAngle,
+        nodalPrecessionAngle(),
         glm::vec3(0.0f, 0.0f, 1.0f)         // nodal precession application along z axis
     );
 
@@ -218,14 +248,22 @@ glm::mat4 SphericalBody::getPositionTransform()
     );
 
     // Create point on the orbit by translating a point at 0,0,0 to the orbit.
-    mat = glm::translate(
-        mat,
-        glm::vec3(
-            _orbitalRadius * cos(_orbitalAngle),
-            _orbitalRadius * sin(_orbitalAngle),
-            0.0f
-        )
-    );
+    mat = glm::translate(mat, getOrbitalPlanePosition(eccentricAnomaly()));
 
     return mat;
+}
+
+// Position on the orbit (in the orbital plane, relative to the parent) for the given eccentric anomaly.
+//  - Parent is at the focus of the ellipse.  Periapsis is at `_argumentOfPeriapsis` from +x axis.
+//  - For a circular orbit, this is a point at `_orbitalRadius` at angle `eccentricAnomaly`.
+glm::vec3 SphericalBody::getOrbitalPlanePosition(float eccentricAnomaly)
+{
+    float e = eccentricity();
+    float x = _orbitalRadius * (cos(eccentricAnomaly) - e);
+    float y = _orbitalRadius * sqrt(1.0f - e * e) * sin(eccentricAnomaly);
+
+    float cw = cos(_argumentOfPeriapsis);
+    float sw = sin(_argumentOfPeriapsis);
+
+    return glm::vec3(x * cw - y * sw, x * sw + y * cw, 0.0f);
 }
\ No newline at end of file
@@ -9,6 +9,7 @@
 #define _USE_MATH_DEFINES
 #include <math.h>
 #include <SceneObject.h>
+#include "BodyStore.h"
 #include <spdlog/spdlog.h>
 
 #define VERTEX_STRIDE_IN_VBO        7
@@ -40,13 +41,17 @@ public:
 class SphericalBody : public SceneObject
 {
 public:
-    SphericalBody(std::string name)
-        : SceneObject(name)
+    // Orbital and rotational state of this body lives in `store`.
+    SphericalBody(std::string name, BodyStore& store)
+        : SceneObject(name),
+          _store(&store),
+          _bodyIndex(store.add())
     {}
     ~SphericalBody() {}
 
     virtual void init() {}
     void advance(float stepMultiplier);
+    void evaluateAt(double t);
 
     virtual void parentChanged();
 
@@ -54,38 +59,57 @@ public:
     void setColor(float r, float g, float b)                { _r = r; _g = g; _b = b; _color = glm::vec3(r, g, b); }
     void setName(std::string name)                          { _name = name; }
     //void setOrbitalPlaneColor(glm::vec3 orbitalPlaneColor)  { _orbitalPlaneColor = orbitalPlaneColor; }
-    void setOrbitalRadius(float orbitalRadius)              { _orbitalRadius = orbitalRadius; }
+    void setOrbitalRadius(float orbitalRadius)              { _orbitalRadius = orbitalRadius; invalidateTransforms(); }
     void setOrbitalAngle(float orbitalAngle, bool calculateDependencies = true);
     inline glm::vec3& getCenter()                           { return _center; }
     inline float getRadius()                                { return _radius; }
     void restoreRadius()                                    { _radius = _radius_Backup;  }
     inline float _normalizeAngle(float angle)               { return (float) fmod(angle, 2 * M_PI);  }
 
-    // related sphere is a sphere that is close enough to this sphere so as to possibly cast a shadow
+    // related spheres are spheres that are close enough to this sphere so as to possibly cast a shadow
     // on this sphere.
-    void setRelatedSphere(SphericalBody * relatedSphere)           { _relatedSphere = relatedSphere; }
+    void addRelatedSphere(SphericalBody * relatedSphere)           { _relatedSpheres.push_back(relatedSphere); }
     void setSunSphere(SphericalBody* sunSphere)                    { _sunSphere = sunSphere; }
-    void restoreOrbitalRadius()                             { _orbitalRadius = _orbitalRadius_Backup; }
-    void restoreAxisTiltAngleFromBackup()                   { _axisTiltAngle = _axisTiltAngle_Backup;  _axisTiltAngle_Deg = glm::degrees(_axisTiltAngle); }
+    void restoreOrbitalRadius()                             { _orbitalRadius = _orbitalRadius_Backup; invalidateTransforms(); }
+    void restoreAxisTiltAngleFromBackup()                   { _axisTiltAngle = _axisTiltAngle_Backup;  _axisTiltAngle_Deg = glm::degrees(_axisTiltAngle); invalidateTransforms(); }
 
     void setRotationParameters(float radius, float rotationAngle, float rotationAngularVelocity, float axisTiltOrientationAngle, float axisTiltAngle);
     void setOrbitalParameters(float orbitalRadius, float orbitalAngle, float orbitalAngularVelocity, float nodalPrecessionInitialAngle, float orbitalPlaneTiltAngle);
+    void setOrbitShape(float eccentricity, float argumentOfPeriapsis);
+    glm::vec3 getOrbitalPlanePosition(float eccentricAnomaly);
 
     glm::mat4 getOrbitalPlaneModelMatrix();
     glm::vec3 getModelTransformedCenter();
-    glm::mat4 getPositionTransform();
-    glm::mat4 getOrientationTransform();
     glm::vec3 getAxisTiltOrientationAxis();
     glm::vec3 getTranslatedSpherePoint(glm::vec3 p);
     glm::vec3 getTransformedNorthPole();
     glm::vec3 getTransformedLatitudeLongitude(float lat, float lon, float radiusScale = 1.0f);
     void calculateCenterPosition();
 
+    BoundingSphere bodyBounds();
+    BoundingSphere drawnBounds();
+
+    // Keep the related spheres whose shadow can fall on this sphere at the current positions.  Called every frame.
+    void updateShadowCasters();
+
+    // State kept in the body store.  References are valid until the next body is added to the store.
+    int bodyIndex()                                         { return _bodyIndex; }
+    BodyMotionFlags& motionFlags()                          { return _store->flags[_bodyIndex]; }
+    float& rotationAngle()                                  { return _store->angle[BodyAngle_Rotation][_bodyIndex]; }
+    float& rotationAngularVelocity()                        { return _store->rotationAngularVelocity[_bodyIndex]; }
+    float& axisRotationAngle()                              { return _store->angle[BodyAngle_AxisRotation][_bodyIndex]; }
+    float& axisTiltOrientationAngle()                       { return _store->angle[BodyAngle_AxisTiltOrientation][_bodyIndex]; }
+    float& orbitalAngle()                                   { return _store->angle[BodyAngle_Orbital][_bodyIndex]; }     // mean anomaly
+    float& orbitalAngularVelocity()                         { return _store->orbitalAngularVelocity[_bodyIndex]; }
+    float& nodalPrecessionAngle()                           { return _store->angle[BodyAngle_NodalPrecession][_bodyIndex]; }
+    float& eccentricity()                                   { return _store->eccentricity[_bodyIndex]; }
+    float& eccentricAnomaly()                               { return _store->eccentricAnomaly[_bodyIndex]; }
+
+protected:
+    glm::mat4 computePositionTransform();
+    glm::mat4 computeOrientationTransform();
+
 public:
-    bool bRevolutionMotion = true;
-    bool bRotationMotion = true;
-    bool bPrecessionMotion = false;
-    bool bOrbitalPlaneRotation = false;
     bool bIsCenterOfMass = false;               // if true, this is a virtual sphere. It represents the center of mass of two or more bodies.
 
     // angles and angle velocities are in radians
@@ -103,30 +127,26 @@ public:
     // Rotation variables
     float _radius = 0;                      // radius of sphere
     float _radius_Backup = 0;
-    float _rotationAngle = 0;               // current rotation angle (increments based on rotation angular velocity).
-    float _rotationAngularVelocity = 0;     // angular velocity or rotation around sphere's axis.
-    bool   bSyncWithRevolution = false;      // sync with this sphere's revolution
-    float _axisRotationAngle = 0;           // 
     float _axisTiltAngle = 0;               // 
     float _axisTiltAngle_Backup = 0;        // allows restoring after modifying axis tilt
     float _axisTiltAngle_Deg = 0;           // to show in ImGui for controlling via slider.
-    float _axisTiltOrientationAngle = glm::radians(0.0f);
 
     // Revolution variables
-    float _orbitalRadius = 0;
+    float _orbitalRadius = 0;               // semi-major axis of the orbit.
     float _orbitalRadius_Backup = 0;        // allows restoring after modifying orbital radius
-    float _orbitalAngle = 0;                // current revolution (orbital) angle (increments based on revolution angular velocity).
-    float _orbitalAngularVelocity = 0;      // angular velocity of revolution around parent sphere.
-    bool   bOrbitalRevolutionSyncToParent = false;
-    float _nodalPrecessionAngle = 0;   // 
-    bool   bNodalPrecessionSpeedSyncToParentsRevolution = false;
+    float _argumentOfPeriapsis = 0;         // angle of periapsis from the ascending node, in the orbital plane.
     float _orbitalPlaneTiltAngle = 0;       // 
     float _orbitalPlaneTiltAngle_Deg = 0;   // this is initialized when _orbitalPlaneTiltAngle is initially set.  After that, Imgui will show and change the _Deg value
                                             // through the use of a slider. If modified, the radian value will be changed by the code that invokes Imgui slider.
 
-    SphericalBody* _relatedSphere = nullptr;
+    std::vector<SphericalBody*> _relatedSpheres;
+    std::vector<SphericalBody*> _shadowCasters;     // subset of _relatedSpheres, closest first.  See updateShadowCasters().
     SphericalBody* _sunSphere = nullptr;
 
     SphericalBody* _sphericalBodyParent = nullptr;  // e.g. if this is moon, _parent is earth.
                                                     // TODO: this will change when we bring in center of mass virtual SphericalBody object.
+
+private:
+    BodyStore* _store;
+    int _bodyIndex;
 };
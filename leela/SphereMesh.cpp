@@ -0,0 +1,217 @@
+#include "SphereMesh.h"
+#include "JobSystem.h"
+
+#define _USE_MATH_DEFINES
+#include <math.h>
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <vector>
+
+#include "spdlog/spdlog.h"
+
+
+static std::map<int, SphereMesh*> s_meshes;
+
+
+SphereMesh* SphereMesh::get(int numEquatorVertices)
+{
+    auto it = s_meshes.find(numEquatorVertices);
+    if (it != s_meshes.end())
+        return it->second;
+
+    SphereMesh* mesh = new SphereMesh(numEquatorVertices);
+    mesh->_buildGeometry();
+    mesh->_upload();
+    s_meshes[numEquatorVertices] = mesh;
+    return mesh;
+}
+
+size_t SphereMesh::totalGpuBytes()
+{
+    size_t bytes = 0;
+    for (auto& [numEquatorVertices, mesh] : s_meshes)
+        bytes += mesh->gpuBytes();
+    return bytes;
+}
+
+void SphereMesh::buildLodChain(JobSystem& jobSystem)
+{
+    std::vector<JobId> uploads;
+
+    for (int level = 0; level < NUM_SPHERE_LODS; level++)
+    {
+        int numEquatorVertices = SPHERE_LOD_EQUATOR_VERTICES[level];
+        if (s_meshes.count(numEquatorVertices))
+            continue;
+
+        // In the map right away, so get() doesn't build it again.  Nothing draws before the jobs are done.
+        SphereMesh* mesh = new SphereMesh(numEquatorVertices);
+        s_meshes[numEquatorVertices] = mesh;
+
+        JobId geometry = jobSystem.add([mesh]() { mesh->_buildGeometry(); });
+        uploads.push_back(jobSystem.addOnCallingThread([mesh]() { mesh->_upload(); }, { geometry }));
+    }
+
+    jobSystem.addOnCallingThread([]() {
+        spdlog::info("Sphere LOD chain: {} levels, {:.2f} MB on GPU", NUM_SPHERE_LODS, totalGpuBytes() / (1024.0 * 1024.0));
+    }, uploads);
+}
+
+float SphereMesh::lodPixelError(int level, float projectedRadiusPixels)
+{
+    return projectedRadiusPixels * (1.0f - cos(float(M_PI) / SPHERE_LOD_EQUATOR_VERTICES[level]));
+}
+
+int SphereMesh::selectLod(float projectedRadiusPixels, float maxPixelError, int currentLevel)
+{
+    auto coarsestWithin = [projectedRadiusPixels](float pixelError) {
+        for (int level = 0; level < NUM_SPHERE_LODS; level++)
+            if (lodPixelError(level, projectedRadiusPixels) <= pixelError)
+                return level;
+        return NUM_SPHERE_LODS - 1;
+    };
+
+    int level = coarsestWithin(maxPixelError);
+    if (currentLevel < 0 || level >= currentLevel)
+        return level;
+
+    // Coarser level is enough.  Move to it only if it's well within the budget.
+    return std::min(currentLevel, coarsestWithin(maxPixelError * SPHERE_LOD_HYSTERESIS));
+}
+
+template<typename T>
+static std::vector<T> buildIndices(int numColumns, int numRows)
+{
+    std::vector<T> indices;
+    indices.reserve(size_t(numColumns) * numRows * 6);
+
+    // vertex (column i, row j) is at i * (numRows + 1) + j
+    for (int i = 0; i < numColumns; i++)
+    {
+        for (int j = 0; j < numRows; j++)
+        {
+            T v1 = T(i * (numRows + 1) + j);
+            T v2 = T(v1 + 1);
+            T v3 = T(v1 + (numRows + 1));
+            T v4 = T(v3 + 1);
+
+            // Triangles touching a pole have two of their vertices on the pole.  Skip them.
+            if (j != 0) {
+                indices.push_back(v1);
+                indices.push_back(v2);
+                indices.push_back(v3);
+            }
+            if (j != numRows - 1) {
+                indices.push_back(v3);
+                indices.push_back(v2);
+                indices.push_back(v4);
+            }
+        }
+    }
+
+    return indices;
+}
+
+SphereMesh::SphereMesh(int numEquatorVertices)
+    : _numEquatorVertices(numEquatorVertices)
+{
+}
+
+// Vertices and indices.  No GL calls, so it can run on any thread.
+void SphereMesh::_buildGeometry()
+{
+    auto start = std::chrono::steady_clock::now();
+
+    int numColumns = _numEquatorVertices;           // alpha: 0 to 2 PI, around the Z axis
+    int numRows = _numEquatorVertices / 2;          // theta: 0 to PI, from +Z axis
+
+    _vertices.clear();
+    _vertices.reserve(size_t(numColumns + 1) * (numRows + 1));
+
+    for (int i = 0; i <= numColumns; i++)
+    {
+        float alpha = float(2 * M_PI) * i / numColumns;
+        uint16_t texX = uint16_t(65535 * i / numColumns);
+
+        for (int j = 0; j <= numRows; j++)
+        {
+            float theta = float(M_PI) * j / numRows;
+            uint16_t texY = uint16_t(65535 * j / numRows);
+
+            SphereMeshVertex v;
+            v.position = glm::vec3(sin(theta) * cos(alpha), sin(theta) * sin(alpha), cos(theta));
+            v.texCoord[0] = texX;
+            v.texCoord[1] = texY;
+            _vertices.push_back(v);
+        }
+    }
+
+    _numVertices = _vertices.size();
+
+    if (_numVertices <= 0x10000)
+    {
+        _indices16 = buildIndices<uint16_t>(numColumns, numRows);
+        _indexType = GL_UNSIGNED_SHORT;
+        _numIndices = _indices16.size();
+        _gpuBytes = sizeof(uint16_t) * _indices16.size();
+    }
+    else
+    {
+        _indices32 = buildIndices<uint32_t>(numColumns, numRows);
+        _indexType = GL_UNSIGNED_INT;
+        _numIndices = _indices32.size();
+        _gpuBytes = sizeof(uint32_t) * _indices32.size();
+    }
+    _gpuBytes += sizeof(SphereMeshVertex) * _vertices.size();
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    spdlog::info("Sphere mesh {}: {} vertices, {} triangles, {:.1f} KB on GPU, built in {:.1f} ms",
+                 _numEquatorVertices, _numVertices, _numIndices / 3, _gpuBytes / 1024.0, ms);
+}
+
+// Send what _buildGeometry() made to the GPU, and free it.  Needs a current GL context.
+void SphereMesh::_upload()
+{
+    glGenVertexArrays(1, &_vao);
+    glBindVertexArray(_vao);
+
+    glGenBuffers(1, &_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(SphereMeshVertex) * _vertices.size(), _vertices.data(), GL_STATIC_DRAW);
+
+    glGenBuffers(1, &_ebo);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ebo);
+    if (_indexType == GL_UNSIGNED_SHORT)
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint16_t) * _indices16.size(), _indices16.data(), GL_STATIC_DRAW);
+    else
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint32_t) * _indices32.size(), _indices32.data(), GL_STATIC_DRAW);
+
+    // x, y & z coordinates of the point
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(SphereMeshVertex), (void*)offsetof(SphereMeshVertex, position));
+    glEnableVertexAttribArray(0);
+
+    // color (attribute 1) comes from the current attribute value.  See class comment.
+    glDisableVertexAttribArray(1);
+
+    // unit normal vector is the same as the point
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(SphereMeshVertex), (void*)offsetof(SphereMeshVertex, position));
+    glEnableVertexAttribArray(2);
+
+    // texture coordinates of the point
+    glVertexAttribPointer(3, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(SphereMeshVertex), (void*)offsetof(SphereMeshVertex, texCoord));
+    glEnableVertexAttribArray(3);
+
+    glBindVertexArray(0);
+
+    _vertices = std::vector<SphereMeshVertex>();
+    _indices16 = std::vector<uint16_t>();
+    _indices32 = std::vector<uint32_t>();
+}
+
+void SphereMesh::draw() const
+{
+    glBindVertexArray(_vao);
+    glDrawElements(GL_TRIANGLES, (GLsizei)_numIndices, _indexType, nullptr);
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+
+//
+// Vertex of the shared unit sphere: 16 bytes.
+//  - On a unit sphere the position is also the normal, so the same bytes are fed to both attribute 0 (position)
+//    and attribute 2 (normal).
+//  - Texture coordinates are quantised to 16 bit normalized integers.
+//
+struct SphereMeshVertex
+{
+    glm::vec3 position;
+    uint16_t texCoord[2];
+};
+static_assert(sizeof(SphereMeshVertex) == 16, "SphereMeshVertex is expected to be tightly packed");
+
+// Levels of detail: equator vertex count of each mesh in the chain, coarsest first.
+constexpr int SPHERE_LOD_EQUATOR_VERTICES[] = { 16, 32, 64, 128, 256, 512, 1024 };
+constexpr int NUM_SPHERE_LODS = int(sizeof(SPHERE_LOD_EQUATOR_VERTICES) / sizeof(SPHERE_LOD_EQUATOR_VERTICES[0]));
+
+// A body that got finer moves back to a coarser level only when that level's error is below this fraction of the
+// pixel error budget.  Keeps bodies at the edge of a level from popping back and forth.
+constexpr float SPHERE_LOD_HYSTERESIS = 0.5f;
+
+
+//
+// Indexed latitude/longitude tessellation of a sphere of radius 1 centered at the origin.
+//  - One mesh per tessellation level, shared by all spherical bodies using that level.  Bodies scale it to their
+//    radius through the model matrix, so changing a radius doesn't touch the mesh.
+//  - The color attribute (1) is not part of the vertex; it's left disabled in the VAO so that the current value
+//    set with glVertexAttrib4f() before each draw is used for all vertices.
+//  - Same layout of points and texture coordinates as ConstructSphereVertices(), with the seam and pole vertices
+//    duplicated so that each has its own texture coordinate.
+//
+class SphereMesh
+{
+public:
+    // Mesh with numEquatorVertices around the equator.  Built on first use; needs a current GL context.
+    static SphereMesh* get(int numEquatorVertices);
+
+    // GPU memory used by all meshes built so far
+    static size_t totalGpuBytes();
+
+    //
+    // Level of detail chain
+    //  - The error of a level is the sagitta of one equator segment (how far the flat triangle is from the true
+    //    surface) in pixels, for a sphere whose projected radius is projectedRadiusPixels.
+    //  - selectLod() returns the coarsest level within maxPixelError.  currentLevel is the level used for the
+    //    body last time, or -1; see SPHERE_LOD_HYSTERESIS.
+    //  - buildLodChain() adds jobs to `jobSystem` that build the chain when it runs: vertices and indices on
+    //    workers, buffers on the calling thread, which must have the GL context.
+    //
+    static void buildLodChain(JobSystem& jobSystem);
+    static SphereMesh* lod(int level)               { return get(SPHERE_LOD_EQUATOR_VERTICES[level]); }
+    static float lodPixelError(int level, float projectedRadiusPixels);
+    static int selectLod(float projectedRadiusPixels, float maxPixelError, int currentLevel);
+
+    void draw() const;
+
+    int numEquatorVertices() const                  { return _numEquatorVertices; }
+    size_t numVertices() const                      { return _numVertices; }
+    size_t numIndices() const                       { return _numIndices; }
+    size_t gpuBytes() const                         { return _gpuBytes; }
+
+private:
+    explicit SphereMesh(int numEquatorVertices);
+    void _buildGeometry();
+    void _upload();
+
+private:
+    int _numEquatorVertices = 0;
+    GLuint _vao = 0;
+    GLuint _vbo = 0;
+    GLuint _ebo = 0;
+    GLenum _indexType = GL_UNSIGNED_INT;
+    size_t _numVertices = 0;
+    size_t _numIndices = 0;
+    size_t _gpuBytes = 0;
+
+    // until uploaded
+    std::vector<SphereMeshVertex> _vertices;
+    std::vector<uint16_t> _indices16;
+    std::vector<uint32_t> _indices32;
+};
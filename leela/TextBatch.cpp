@@ -0,0 +1,105 @@
+#include "TextBatch.h"
+#include "GlyphAtlas.h"
+#include "GlslProgram.h"
+#include "GlslUniforms.h"
+
+#include <algorithm>
+#include <cstddef>
+
+
+void TextBatch::init()
+{
+    glGenVertexArrays(1, &_vao);
+    glGenBuffers(1, &_vbo);
+
+    glBindVertexArray(_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void*)offsetof(TextVertex, position));
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void*)offsetof(TextVertex, texCoord));
+    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void*)offsetof(TextVertex, color));
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+void TextBatch::setState(const GlyphAtlas& atlas, const glm::mat4& projection, bool bDepthWrite)
+{
+    if (!_runs.empty())
+    {
+        Run& last = _runs.back();
+        if (last.texture == atlas.texture() && last.projection == projection && last.bDepthWrite == bDepthWrite)
+            return;
+
+        // nothing was added with the previous state
+        if (last.numVertices == 0)
+            _runs.pop_back();
+    }
+
+    _runs.push_back({ atlas.texture(), projection, bDepthWrite, GLint(_vertices.size()), 0 });
+}
+
+void TextBatch::addQuad(const glm::vec3& topLeft, const glm::vec3& topRight, const glm::vec3& bottomRight, const glm::vec3& bottomLeft,
+                        const glm::vec2& uvMin, const glm::vec2& uvMax, const glm::vec3& color)
+{
+    TextVertex tl = { topLeft,      uvMin,                          color };
+    TextVertex tr = { topRight,     glm::vec2(uvMax.x, uvMin.y),    color };
+    TextVertex br = { bottomRight,  uvMax,                          color };
+    TextVertex bl = { bottomLeft,   glm::vec2(uvMin.x, uvMax.y),    color };
+
+    _vertices.insert(_vertices.end(), { tl, bl, br,   tl, br, tr });
+    _runs.back().numVertices += 6;
+}
+
+void TextBatch::flush(GlslProgram& glslProgram)
+{
+    if (_vertices.empty())
+    {
+        _runs.clear();
+        return;
+    }
+
+    glBindVertexArray(_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, _vbo);
+
+    // Orphan the previous contents so that the driver doesn't wait for draws still reading them.
+    _vboCapacity = std::max(_vboCapacity, _vertices.size());
+    glBufferData(GL_ARRAY_BUFFER, sizeof(TextVertex) * _vboCapacity, nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(TextVertex) * _vertices.size(), _vertices.data());
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glActiveTexture(GL_TEXTURE0);
+
+    bool bDepthWrite = true;
+    for (const Run& run : _runs)
+    {
+        if (run.numVertices == 0)
+            continue;
+
+        if (run.bDepthWrite != bDepthWrite) {
+            glDepthMask(run.bDepthWrite ? GL_TRUE : GL_FALSE);
+            bDepthWrite = run.bDepthWrite;
+        }
+
+        glslProgram.set(Uniforms::projection, run.projection);
+        glBindTexture(GL_TEXTURE_2D, run.texture);
+        glDrawArrays(GL_TRIANGLES, run.firstVertex, run.numVertices);
+        _drawCalls++;
+    }
+
+    if (!bDepthWrite)
+        glDepthMask(GL_TRUE);
+    glDisable(GL_BLEND);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    _glyphs += unsigned(_vertices.size() / 6);
+    _vertices.clear();
+    _runs.clear();
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+class GlslProgram;
+class GlyphAtlas;
+
+struct TextVertex
+{
+    glm::vec3 position;
+    glm::vec2 texCoord;
+    glm::vec3 color;
+};
+
+
+//
+// Glyph quads collected from all RenderText() calls of a render pass, drawn together by flush().
+//  - All quads go into one streaming vertex buffer.  Consecutive quads with the same atlas, projection and depth
+//    write setting form a run, and each run is a single draw call.
+//  - Color is per vertex so that text of different colors shares a run.
+//
+class TextBatch
+{
+public:
+    void init();
+
+    // Following quads use these settings.  Starts a new run if any of them differs from the current one.
+    void setState(const GlyphAtlas& atlas, const glm::mat4& projection, bool bDepthWrite);
+
+    // Quad with corners given from the top left, clockwise.  setState() must have been called since the last flush().
+    void addQuad(const glm::vec3& topLeft, const glm::vec3& topRight, const glm::vec3& bottomRight, const glm::vec3& bottomLeft,
+                 const glm::vec2& uvMin, const glm::vec2& uvMax, const glm::vec3& color);
+
+    //
+    // Draw everything collected so far with the Font program, which must be in use, and start over.
+    //  - Blending is enabled for the draws and disabled afterwards.  Depth writes are turned back on afterwards.
+    //
+    void flush(GlslProgram& glslProgram);
+
+    bool empty() const                              { return _vertices.empty(); }
+
+    // Totals since the last call to resetStats().
+    unsigned int drawCalls() const                  { return _drawCalls; }
+    unsigned int glyphs() const                     { return _glyphs; }
+    void resetStats()                               { _drawCalls = 0; _glyphs = 0; }
+
+private:
+    struct Run
+    {
+        GLuint texture;
+        glm::mat4 projection;
+        bool bDepthWrite;
+        GLint firstVertex;
+        GLsizei numVertices;
+    };
+
+    GLuint _vao = 0;
+    GLuint _vbo = 0;
+    size_t _vboCapacity = 0;                // in vertices
+
+    std::vector<TextVertex> _vertices;
+    std::vector<Run> _runs;
+
+    unsigned int _drawCalls = 0;
+    unsigned int _glyphs = 0;
+};
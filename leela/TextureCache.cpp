@@ -0,0 +1,395 @@
+#include "TextureCache.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#include "lodepng.h"
+#include "spdlog/spdlog.h"
+
+
+// Bump when the layout of the cache file or the way textures are baked changes.
+static constexpr uint32_t TEXTURE_CACHE_VERSION = 1;
+static const char TEXTURE_CACHE_MAGIC[4] = { 'L', 'T', 'E', 'X' };
+static constexpr size_t TEXTURE_CACHE_ALIGNMENT = 16;
+static constexpr uint32_t TEXTURE_CACHE_MAX_LEVELS = 32;
+
+// Numbers the temporary files of cache writes, so that workers baking the same source don't write into one file.
+static std::atomic<unsigned int> textureCacheWriteCount = 0;
+
+//
+// Cache file layout:
+//      TextureCacheHeader
+//      TextureCacheLevel       x numLevels, level 0 first
+//      level data              each at a multiple of TEXTURE_CACHE_ALIGNMENT
+//
+struct TextureCacheHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t format;                    // TextureFormat
+    uint32_t numLevels;
+    uint64_t sourceSize;
+    int64_t sourceModifiedTime;
+};
+
+struct TextureCacheLevel
+{
+    uint32_t width;
+    uint32_t height;
+    uint64_t offset;                    // from the start of the file
+    uint64_t size;
+};
+
+
+static const char* formatName(TextureFormat format)
+{
+    return format == TextureFormat::BC1 ? "bc1" : "rgb8";
+}
+
+//---------------------------------------------------------------------------------------------------
+// Baking
+
+RgbImage halveImage(const RgbImage& src)
+{
+    RgbImage dst;
+    dst.width = std::max(src.width / 2, 1);
+    dst.height = std::max(src.height / 2, 1);
+    dst.pixels.resize(size_t(dst.width) * dst.height * 3);
+
+    for (int y = 0; y < dst.height; y++)
+    {
+        // a dimension that is already 1 is not halved; reuse the same row/column
+        int y0 = std::min(2 * y, src.height - 1);
+        int y1 = std::min(2 * y + 1, src.height - 1);
+
+        for (int x = 0; x < dst.width; x++)
+        {
+            int x0 = std::min(2 * x, src.width - 1);
+            int x1 = std::min(2 * x + 1, src.width - 1);
+
+            const unsigned char* p00 = &src.pixels[(size_t(y0) * src.width + x0) * 3];
+            const unsigned char* p01 = &src.pixels[(size_t(y0) * src.width + x1) * 3];
+            const unsigned char* p10 = &src.pixels[(size_t(y1) * src.width + x0) * 3];
+            const unsigned char* p11 = &src.pixels[(size_t(y1) * src.width + x1) * 3];
+            unsigned char* d = &dst.pixels[(size_t(y) * dst.width + x) * 3];
+
+            for (int c = 0; c < 3; c++)
+                d[c] = (unsigned char)((p00[c] + p01[c] + p10[c] + p11[c] + 2) / 4);
+        }
+    }
+
+    return dst;
+}
+
+static uint16_t packRgb565(const float c[3])
+{
+    int r = std::clamp(int(c[0] * 31.0f / 255.0f + 0.5f), 0, 31);
+    int g = std::clamp(int(c[1] * 63.0f / 255.0f + 0.5f), 0, 63);
+    int b = std::clamp(int(c[2] * 31.0f / 255.0f + 0.5f), 0, 31);
+    return uint16_t((r << 11) | (g << 5) | b);
+}
+
+static void unpackRgb565(uint16_t v, int c[3])
+{
+    int r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+    c[0] = (r << 3) | (r >> 2);
+    c[1] = (g << 2) | (g >> 4);
+    c[2] = (b << 3) | (b >> 2);
+}
+
+//
+// One 4x4 block of RGB pixels to BC1.
+//  - Endpoints are the corners of the colors' bounding box, on the diagonal that follows the colors: channels
+//    that go down while the channel with the largest range goes up are flipped.  Inset by 1/16 of the range,
+//    which lowers the error for the usual case of colors spread along the diagonal.
+//  - Always the 4 color mode (color0 > color1).
+//
+static void compressBlockBC1(const unsigned char pixels[16 * 3], unsigned char out[8])
+{
+    float mean[3] = { 0, 0, 0 };
+    int lo[3] = { 255, 255, 255 }, hi[3] = { 0, 0, 0 };
+    for (int i = 0; i < 16; i++)
+        for (int c = 0; c < 3; c++) {
+            mean[c] += pixels[i * 3 + c] / 16.0f;
+            lo[c] = std::min(lo[c], int(pixels[i * 3 + c]));
+            hi[c] = std::max(hi[c], int(pixels[i * 3 + c]));
+        }
+
+    int axis = 0;
+    for (int c = 1; c < 3; c++)
+        if (hi[c] - lo[c] > hi[axis] - lo[axis])
+            axis = c;
+
+    float c0[3], c1[3];
+    for (int c = 0; c < 3; c++)
+    {
+        float covariance = 0.0f;
+        for (int i = 0; i < 16; i++)
+            covariance += (pixels[i * 3 + c] - mean[c]) * (pixels[i * 3 + axis] - mean[axis]);
+
+        float inset = (hi[c] - lo[c]) / 16.0f;
+        c0[c] = covariance >= 0.0f ? hi[c] - inset : lo[c] + inset;
+        c1[c] = covariance >= 0.0f ? lo[c] + inset : hi[c] - inset;
+    }
+
+    uint16_t e0 = packRgb565(c0);
+    uint16_t e1 = packRgb565(c1);
+    if (e0 < e1)
+        std::swap(e0, e1);
+
+    uint32_t indices = 0;
+    if (e0 != e1)
+    {
+        int p[4][3];
+        unpackRgb565(e0, p[0]);
+        unpackRgb565(e1, p[1]);
+        for (int c = 0; c < 3; c++) {
+            p[2][c] = (2 * p[0][c] + p[1][c]) / 3;
+            p[3][c] = (p[0][c] + 2 * p[1][c]) / 3;
+        }
+
+        for (int i = 0; i < 16; i++)
+        {
+            int best = 0, bestDistance = INT_MAX;
+            for (int j = 0; j < 4; j++)
+            {
+                int distance = 0;
+                for (int c = 0; c < 3; c++) {
+                    int d = pixels[i * 3 + c] - p[j][c];
+                    distance += d * d;
+                }
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    best = j;
+                }
+            }
+            indices |= uint32_t(best) << (2 * i);
+        }
+    }
+
+    out[0] = uint8_t(e0);   out[1] = uint8_t(e0 >> 8);
+    out[2] = uint8_t(e1);   out[3] = uint8_t(e1 >> 8);
+    memcpy(out + 4, &indices, 4);           // little endian
+}
+
+static void compressBC1(const RgbImage& image, unsigned char* out)
+{
+    int blocksX = (image.width + 3) / 4;
+    int blocksY = (image.height + 3) / 4;
+
+    for (int by = 0; by < blocksY; by++)
+    {
+        for (int bx = 0; bx < blocksX; bx++)
+        {
+            // pixels past the edge of small levels repeat the last row/column
+            unsigned char block[16 * 3];
+            for (int y = 0; y < 4; y++)
+                for (int x = 0; x < 4; x++) {
+                    int sx = std::min(bx * 4 + x, image.width - 1);
+                    int sy = std::min(by * 4 + y, image.height - 1);
+                    memcpy(&block[(y * 4 + x) * 3], &image.pixels[(size_t(sy) * image.width + sx) * 3], 3);
+                }
+
+            compressBlockBC1(block, out + (size_t(by) * blocksX + bx) * 8);
+        }
+    }
+}
+
+static size_t alignUp(size_t n)
+{
+    return (n + TEXTURE_CACHE_ALIGNMENT - 1) / TEXTURE_CACHE_ALIGNMENT * TEXTURE_CACHE_ALIGNMENT;
+}
+
+// Decode `sourcePath` and bake it into the contents of a cache file.
+static bool bake(const std::string& sourcePath, TextureFormat format, uint64_t sourceSize, int64_t sourceModifiedTime,
+                 std::vector<unsigned char>& file)
+{
+    RgbImage level;
+    unsigned int width, height;
+    unsigned int error = lodepng::decode(level.pixels, width, height, sourcePath, LCT_RGB, 8);
+    if (error) {
+        spdlog::error("Couldn't decode texture {}: {}", sourcePath, lodepng_error_text(error));
+        return false;
+    }
+    level.width = int(width);
+    level.height = int(height);
+
+    std::vector<RgbImage> mips;
+    mips.push_back(std::move(level));
+    while (mips.back().width > 1 || mips.back().height > 1)
+        mips.push_back(halveImage(mips.back()));
+
+    //---------------------------------------------------------------
+    // Lay out the file
+    uint32_t numLevels = uint32_t(mips.size());
+    std::vector<TextureCacheLevel> levels(numLevels);
+    size_t offset = alignUp(sizeof(TextureCacheHeader) + sizeof(TextureCacheLevel) * numLevels);
+    for (uint32_t l = 0; l < numLevels; l++)
+    {
+        levels[l].width = uint32_t(mips[l].width);
+        levels[l].height = uint32_t(mips[l].height);
+        levels[l].offset = offset;
+        levels[l].size = textureRowBytes(format, mips[l].width) * textureNumRows(format, mips[l].height);
+        offset = alignUp(offset + size_t(levels[l].size));
+    }
+
+    TextureCacheHeader header;
+    memcpy(header.magic, TEXTURE_CACHE_MAGIC, sizeof(TEXTURE_CACHE_MAGIC));
+    header.version = TEXTURE_CACHE_VERSION;
+    header.format = uint32_t(format);
+    header.numLevels = numLevels;
+    header.sourceSize = sourceSize;
+    header.sourceModifiedTime = sourceModifiedTime;
+
+    file.assign(offset, 0);
+    memcpy(file.data(), &header, sizeof(header));
+    memcpy(file.data() + sizeof(header), levels.data(), sizeof(TextureCacheLevel) * numLevels);
+
+    for (uint32_t l = 0; l < numLevels; l++)
+    {
+        unsigned char* dst = file.data() + levels[l].offset;
+        if (format == TextureFormat::BC1)
+            compressBC1(mips[l], dst);
+        else
+            memcpy(dst, mips[l].pixels.data(), mips[l].pixels.size());
+    }
+
+    return true;
+}
+
+//---------------------------------------------------------------------------------------------------
+// Loading
+
+// Point the mips of `image` into the contents of a cache file.  false if it's out of date or broken.
+static bool parse(const unsigned char* data, size_t size, TextureFormat format, uint64_t sourceSize,
+                  int64_t sourceModifiedTime, TextureImage& image)
+{
+    if (size < sizeof(TextureCacheHeader))
+        return false;
+
+    const TextureCacheHeader* header = reinterpret_cast<const TextureCacheHeader*>(data);
+    if (memcmp(header->magic, TEXTURE_CACHE_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != TEXTURE_CACHE_VERSION ||
+        header->format != uint32_t(format) ||
+        header->sourceSize != sourceSize ||
+        header->sourceModifiedTime != sourceModifiedTime ||
+        header->numLevels == 0 || header->numLevels > TEXTURE_CACHE_MAX_LEVELS ||
+        size < sizeof(TextureCacheHeader) + sizeof(TextureCacheLevel) * header->numLevels)
+    {
+        return false;
+    }
+
+    const TextureCacheLevel* levels = reinterpret_cast<const TextureCacheLevel*>(header + 1);
+    image.format = format;
+    image.mips.clear();
+    for (uint32_t l = 0; l < header->numLevels; l++)
+    {
+        const TextureCacheLevel& level = levels[l];
+        if (level.offset > size || level.size > size - level.offset ||
+            level.size != textureRowBytes(format, int(level.width)) * textureNumRows(format, int(level.height)))
+        {
+            image.mips.clear();
+            return false;
+        }
+        image.mips.push_back({ int(level.width), int(level.height), data + level.offset, size_t(level.size) });
+    }
+
+    return true;
+}
+
+// FNV-1a.  Unlike std::hash, the same on every run and every compiler, so it can be part of a file name.
+static uint64_t pathHash(const std::string& path)
+{
+    uint64_t h = 14695981039346656037ull;
+    for (unsigned char c : path) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+bool TextureCache::load(const std::string& sourcePath, TextureImage& image) const
+{
+    auto start = std::chrono::steady_clock::now();
+
+    std::error_code ec;
+    uint64_t sourceSize = std::filesystem::file_size(sourcePath, ec);
+    int64_t sourceModifiedTime = int64_t(std::filesystem::last_write_time(sourcePath, ec).time_since_epoch().count());
+
+    // e.g. jupiter2k.5d1ea3c07a8b4f02.rgb8.texcache.  The hash of the full path keeps sources with the same name in
+    // different folders from overwriting each other's cache.
+    std::string cachePath;
+    if (!cacheFolder.empty())
+    {
+        std::filesystem::create_directories(cacheFolder, ec);
+        std::filesystem::path fullSourcePath = std::filesystem::absolute(sourcePath, ec).lexically_normal();
+        char hash[17];
+        snprintf(hash, sizeof(hash), "%016llx", (unsigned long long)pathHash(fullSourcePath.generic_string()));
+        std::string name = std::filesystem::path(sourcePath).stem().string() + "." + hash + "." + formatName(format) + ".texcache";
+        cachePath = (std::filesystem::path(cacheFolder) / name).string();
+    }
+
+    //---------------------------------------------------------------
+    // Mapped cache file
+    if (!cachePath.empty())
+    {
+        auto mapped = std::make_shared<MappedFile>();
+        if (mapped->open(cachePath))
+        {
+            if (parse((const unsigned char*)mapped->data(), mapped->size(), format, sourceSize, sourceModifiedTime, image))
+            {
+                image.storage = mapped;
+                double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                spdlog::info("Texture {}: {}x{}, {} levels, mapped from cache in {:.1f} ms",
+                             sourcePath, image.mips[0].width, image.mips[0].height, image.mips.size(), ms);
+                return true;
+            }
+            spdlog::info("Texture cache {} is out of date", cachePath);
+        }
+    }
+
+    //---------------------------------------------------------------
+    // Bake it, and write the cache for next time
+    auto file = std::make_shared<std::vector<unsigned char>>();
+    if (!bake(sourcePath, format, sourceSize, sourceModifiedTime, *file))
+        return false;
+
+    if (!cachePath.empty())
+    {
+        // Write to a temporary file first, so that an interrupted write doesn't leave a broken cache behind.
+        std::string tempPath = cachePath + "." + std::to_string(textureCacheWriteCount++) + ".tmp";
+        bool bWritten = false;
+        {
+            std::ofstream f(tempPath, std::ios::binary | std::ios::trunc);
+            f.write((const char*)file->data(), file->size());
+            f.close();
+            bWritten = bool(f);
+        }
+
+        if (!bWritten) {
+            // e.g. disk full.  A partial file would only be rejected and baked again on every run.
+            spdlog::warn("Couldn't write texture cache {}", tempPath);
+            std::filesystem::remove(tempPath, ec);
+        }
+        else {
+            std::filesystem::rename(tempPath, cachePath, ec);
+            if (ec)
+                spdlog::warn("Couldn't write texture cache {}: {}", cachePath, ec.message());
+        }
+    }
+
+    parse(file->data(), file->size(), format, sourceSize, sourceModifiedTime, image);
+    image.storage = file;
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    spdlog::info("Texture {}: {}x{}, {} levels, baked as {} in {:.1f} ms",
+                 sourcePath, image.mips[0].width, image.mips[0].height, image.mips.size(), formatName(format), ms);
+    return true;
+}
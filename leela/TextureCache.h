@@ -0,0 +1,37 @@
+#pragma once
+
+#include "TextureStreamer.h"
+#include <string>
+#include <vector>
+
+// 8 bit RGB pixels, rows tightly packed, top row first
+struct RgbImage
+{
+    int width = 0;
+    int height = 0;
+    std::vector<unsigned char> pixels;
+};
+
+// Half the size in both dimensions, 2x2 box filter.  A dimension that is already 1 stays 1.
+RgbImage halveImage(const RgbImage& src);
+
+//
+// Textures baked for the GPU and cached on disk.
+//  - The first time a texture file is loaded it's decoded, its mip chain is built with a 2x2 box filter and, for
+//    TextureFormat::BC1, compressed.  The result is written to a cache file in the layout the GPU takes.
+//  - After that the cache file is memory mapped.  The mips of the image point into the mapping, so sending the
+//    texture to the GPU is a straight copy.
+//  - A cache file is rebuilt when the size or modification time of its source changes.  Its name has a hash of the
+//    full source path, so sources with the same name in different folders have separate caches.
+//  - PNG sources only.
+//
+class TextureCache
+{
+public:
+    // Thread safe.  Returns false if the source can't be decoded.
+    bool load(const std::string& sourcePath, TextureImage& image) const;
+
+public:
+    std::string cacheFolder;                        // no cache files if empty; textures are baked on every load
+    TextureFormat format = TextureFormat::RGB8;
+};
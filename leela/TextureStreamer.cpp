@@ -0,0 +1,181 @@
+#include "TextureStreamer.h"
+
+#include <algorithm>
+#include <cstring>
+
+
+GLenum textureInternalFormat(TextureFormat format)
+{
+    switch (format)
+    {
+    case TextureFormat::BC1:    return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    case TextureFormat::RGB8:
+    default:                    return GL_RGB8;
+    }
+}
+
+int textureRowHeight(TextureFormat format)
+{
+    return format == TextureFormat::BC1 ? 4 : 1;
+}
+
+size_t textureRowBytes(TextureFormat format, int width)
+{
+    if (format == TextureFormat::BC1)
+        return size_t((width + 3) / 4) * 8;
+    return size_t(width) * 3;
+}
+
+int textureNumRows(TextureFormat format, int height)
+{
+    int rowHeight = textureRowHeight(format);
+    return (height + rowHeight - 1) / rowHeight;
+}
+
+// Rows [row, row + numRows) of `level` from `pixels`, which is a client pointer or an offset into the bound
+// pixel unpack buffer.
+static void uploadRows(TextureFormat format, int level, const TextureMip& mip, int row, int numRows, const void* pixels)
+{
+    int rowHeight = textureRowHeight(format);
+    int y = row * rowHeight;
+    int height = std::min(numRows * rowHeight, mip.height - y);
+
+    if (format == TextureFormat::BC1)
+        glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, y, mip.width, height, textureInternalFormat(format),
+                                  GLsizei(textureRowBytes(format, mip.width) * numRows), pixels);
+    else
+        glTexSubImage2D(GL_TEXTURE_2D, level, 0, y, mip.width, height, GL_RGB, GL_UNSIGNED_BYTE, pixels);
+}
+
+
+void TextureStreamer::add(GLuint texture, TextureImage&& image)
+{
+    if (image.empty())
+        return;
+
+    const std::vector<TextureMip>& mips = image.mips;
+    int numLevels = int(mips.size());
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);          // RGB rows of small levels aren't 4 byte aligned
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexStorage2D(GL_TEXTURE_2D, numLevels, textureInternalFormat(image.format), mips[0].width, mips[0].height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, numLevels - 1);
+
+    // Placeholder: the small levels, straight from memory
+    int level = numLevels - 1;
+    while (level > 0 && mips[level - 1].width <= PLACEHOLDER_SIZE && mips[level - 1].height <= PLACEHOLDER_SIZE)
+        level--;
+
+    for (int l = numLevels - 1; l >= level; l--)
+        uploadRows(image.format, l, mips[l], 0, textureNumRows(image.format, mips[l].height), mips[l].data);
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    if (level == 0)
+        return;
+
+    for (int l = 0; l < level; l++)
+        _pendingBytes += mips[l].size;
+    _pending.push_back({ texture, std::move(image), level - 1, 0 });
+}
+
+void TextureStreamer::update()
+{
+    _lastUpdateBytes = 0;
+    if (_pending.empty())
+        return;
+
+    //---------------------------------------------------------------
+    // Pick rows to upload, coarsest pending level first
+    _chunks.clear();
+    size_t totalBytes = 0;
+
+    while (true)
+    {
+        size_t next = _pending.size();
+        for (size_t i = 0; i < _pending.size(); i++)
+        {
+            if (_pending[i].level >= 0 && (next == _pending.size() || _pending[i].level > _pending[next].level))
+                next = i;
+        }
+        if (next == _pending.size())
+            break;
+
+        PendingTexture& p = _pending[next];
+        const TextureMip& mip = p.image.mips[p.level];
+        size_t rowBytes = textureRowBytes(p.image.format, mip.width);
+        int numLevelRows = textureNumRows(p.image.format, mip.height);
+
+        // At least one row per update, however small the budget
+        size_t budgetRows = totalBytes < bytesPerFrame ? (bytesPerFrame - totalBytes) / rowBytes : 0;
+        if (budgetRows == 0 && totalBytes > 0)
+            break;
+
+        int numRows = int(std::clamp<size_t>(budgetRows, 1, size_t(numLevelRows - p.row)));
+        _chunks.push_back({ next, p.level, p.row, numRows, totalBytes });
+        totalBytes += rowBytes * numRows;
+
+        p.row += numRows;
+        if (p.row == numLevelRows) {
+            p.level--;
+            p.row = 0;
+        }
+    }
+
+    //---------------------------------------------------------------
+    // Copy them into the pixel buffer, and from there to the textures
+    if (_pbo == 0)
+        glGenBuffers(1, &_pbo);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _pbo);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    // Orphan the previous contents so that the driver doesn't wait for uploads still reading them.
+    _pboCapacity = std::max(_pboCapacity, totalBytes);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, _pboCapacity, nullptr, GL_STREAM_DRAW);
+
+    unsigned char* dst = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, totalBytes,
+                                                          GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (dst)
+    {
+        for (const Chunk& chunk : _chunks)
+        {
+            const TextureImage& image = _pending[chunk.pendingIndex].image;
+            const TextureMip& mip = image.mips[chunk.level];
+            size_t rowBytes = textureRowBytes(image.format, mip.width);
+            memcpy(dst + chunk.offset, mip.data + rowBytes * chunk.row, rowBytes * chunk.numRows);
+        }
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+        for (const Chunk& chunk : _chunks)
+        {
+            PendingTexture& p = _pending[chunk.pendingIndex];
+            const TextureMip& mip = p.image.mips[chunk.level];
+
+            glBindTexture(GL_TEXTURE_2D, p.texture);
+            uploadRows(p.image.format, chunk.level, mip, chunk.row, chunk.numRows, (void*)chunk.offset);
+
+            // level complete; start sampling from it
+            if (chunk.row + chunk.numRows == textureNumRows(p.image.format, mip.height))
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, chunk.level);
+        }
+
+        _pendingBytes -= totalBytes;
+        _lastUpdateBytes = totalBytes;
+    }
+    else
+    {
+        // try again next frame
+        for (auto it = _chunks.rbegin(); it != _chunks.rend(); ++it) {
+            _pending[it->pendingIndex].level = it->level;
+            _pending[it->pendingIndex].row = it->row;
+        }
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    // done; release the image data
+    _pending.erase(std::remove_if(_pending.begin(), _pending.end(), [](const PendingTexture& p) { return p.level < 0; }),
+                   _pending.end());
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+enum class TextureFormat : uint32_t
+{
+    RGB8,               // 3 bytes per pixel, rows tightly packed
+    BC1,                // 4x4 blocks of 8 bytes (S3TC DXT1), rows of blocks tightly packed
+};
+
+// One level of a texture's mip chain, in the layout the GPU takes it
+struct TextureMip
+{
+    int width = 0;
+    int height = 0;
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+};
+
+// A whole mip chain, level 0 first.  `storage` keeps the data of the mips alive, e.g. a buffer or a mapped file.
+struct TextureImage
+{
+    TextureFormat format = TextureFormat::RGB8;
+    std::vector<TextureMip> mips;
+    std::shared_ptr<const void> storage;
+
+    bool empty() const                              { return mips.empty(); }
+};
+
+GLenum textureInternalFormat(TextureFormat format);
+
+// Levels are uploaded in rows of textureRowHeight() pixels, each textureRowBytes() long.  1 pixel for uncompressed
+// formats, 1 block for compressed ones.
+int textureRowHeight(TextureFormat format);
+size_t textureRowBytes(TextureFormat format, int width);
+int textureNumRows(TextureFormat format, int height);
+
+
+//
+// Uploads textures a little at a time, so that large textures don't stall a frame.
+//  - add() allocates storage for the whole mip chain and uploads the levels up to PLACEHOLDER_SIZE right away.
+//    The texture can be used immediately, blurry.  Other levels are queued.
+//  - update(), once per frame, uploads queued rows through a pixel buffer object, up to bytesPerFrame in total.
+//    Rows are rows of blocks for compressed formats.
+//    Coarser levels go first, across all textures, so that everything sharpens at the same pace.
+//  - GL_TEXTURE_BASE_LEVEL of a texture is its finest complete level, so sampling never reads a level that is
+//    still being uploaded.
+//
+class TextureStreamer
+{
+public:
+    static constexpr int PLACEHOLDER_SIZE = 64;
+
+    // `texture` must be a texture name without storage.  `image` is released once all of it is uploaded.
+    void add(GLuint texture, TextureImage&& image);
+    void update();
+
+    unsigned int pendingTextures() const            { return unsigned(_pending.size()); }
+    size_t pendingBytes() const                     { return _pendingBytes; }
+    size_t lastUpdateBytes() const                  { return _lastUpdateBytes; }
+
+public:
+    size_t bytesPerFrame = 4 * 1024 * 1024;
+
+private:
+    struct PendingTexture
+    {
+        GLuint texture;
+        TextureImage image;
+        int level;                                  // level being uploaded.  Finer levels are still to come.
+        int row;                                    // next row of `level` to upload, in units of textureRowHeight()
+    };
+
+    struct Chunk
+    {
+        size_t pendingIndex;
+        int level;
+        int row;
+        int numRows;
+        size_t offset;                              // in the pixel buffer
+    };
+
+    GLuint _pbo = 0;
+    size_t _pboCapacity = 0;
+
+    std::vector<PendingTexture> _pending;
+    std::vector<Chunk> _chunks;
+    size_t _pendingBytes = 0;
+    size_t _lastUpdateBytes = 0;
+};
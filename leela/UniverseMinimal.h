@@ -11,6 +11,7 @@ enum class RenderStage
                             // It still doesn't solve all problems.
     Final,
 } ;
+constexpr int NUM_RENDER_STAGES = 5;
 
 enum class ViewportType
 {
@@ -18,3 +19,4 @@ enum class ViewportType
     Minimap,
     AlternateObserver
 };
+constexpr int NUM_VIEWPORT_TYPES = 3;
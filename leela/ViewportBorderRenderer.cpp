@@ -1,5 +1,6 @@
 #include "ViewportBorderRenderer.h"
 #include "ViewportSceneObject.h"
+#include "GlslUniforms.h"
 #include "Utils.h"
 
 
@@ -83,6 +84,13 @@ void ViewportBorderRenderer::render(ViewportType viewportType, RenderStage rende
 	}
 }
 
+bool ViewportBorderRenderer::rendersIn(ViewportType viewportType, RenderStage renderStage, GlslProgramType programType)
+{
+	return viewportType == _viewport->_viewportType &&
+		   renderStage == RenderStage::Final &&
+		   programType == GlslProgramType::SimpleOrtho;
+}
+
 void ViewportBorderRenderer::renderBorder(GlslProgram& glslProgram)
 {
 	glm::mat4 projection = glm::ortho(float(( - _viewport->_w - 2) / 2),
@@ -91,7 +99,7 @@ void ViewportBorderRenderer::renderBorder(GlslProgram& glslProgram)
 		                              float(( + _viewport->_h + 2) / 2),
 		                              -1.0f,
 		                              1.0f);
-	glslProgram.setMat4("proj", glm::value_ptr(projection));
+	glslProgram.set(Uniforms::proj, projection);
 
 	glEnable(GL_BLEND);
 
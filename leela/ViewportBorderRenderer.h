@@ -16,6 +16,7 @@ public:
 	void parentChanged();
 
 	void render(ViewportType viewportType, RenderStage sceneType, GlslProgram& glslProgram);
+	bool rendersIn(ViewportType viewportType, RenderStage renderStage, GlslProgramType programType);
 	void renderBorder(GlslProgram& glslProgram);
 
 	GLuint _borderVao = 0;
@@ -0,0 +1,559 @@
+#include "VirtualTexture.h"
+#include "GlslUniforms.h"
+#include "TextureCache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+
+#include "lodepng.h"
+#include "spdlog/spdlog.h"
+
+
+// Bump when the layout of the pyramid file or the way it's baked changes.
+static constexpr uint32_t PYRAMID_VERSION = 1;
+static const char PYRAMID_MAGIC[4] = { 'L', 'V', 'T', 'X' };
+
+//
+// Pyramid file layout:
+//      VirtualTexturePyramidHeader
+//      tiles                   from PYRAMID_TILES_OFFSET.  Level 0 first, rows of tiles top to bottom.  Each tile
+//                              is SLOT_SIZE x SLOT_SIZE RGB pixels, border included.
+//
+struct VirtualTexturePyramidHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t tileSize;
+    uint32_t tileBorder;
+    uint32_t width;                     // of level 0
+    uint32_t height;
+    uint64_t sourceSize;
+    int64_t sourceModifiedTime;
+};
+
+static constexpr size_t PYRAMID_TILES_OFFSET = 64;
+static_assert(sizeof(VirtualTexturePyramidHeader) <= PYRAMID_TILES_OFFSET, "Pyramid header overlaps the tiles");
+
+// The level table at the start of the pages buffer: width, height, tiles per row, first tile of each level
+static constexpr size_t LEVEL_TABLE_BYTES = VirtualTexture::MAX_LEVELS * 4 * sizeof(int32_t);
+
+
+VirtualTexture::~VirtualTexture()
+{
+    if (_loader.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(_loaderMutex);
+            _bQuit = true;
+        }
+        _loaderCondition.notify_all();
+        _loader.join();
+    }
+}
+
+//---------------------------------------------------------------------------------------------------
+// Tile pyramid
+
+void VirtualTexture::_layOut(int width, int height)
+{
+    _levels.clear();
+    _numTiles = 0;
+
+    while (true)
+    {
+        Level level;
+        level.width = width;
+        level.height = height;
+        level.tilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+        level.tilesY = (height + TILE_SIZE - 1) / TILE_SIZE;
+        level.firstTile = _numTiles;
+        _levels.push_back(level);
+        _numTiles += level.tilesX * level.tilesY;
+
+        if (level.tilesX == 1 && level.tilesY == 1)
+            break;
+
+        // same sizes as halveImage()
+        width = std::max(width / 2, 1);
+        height = std::max(height / 2, 1);
+    }
+}
+
+bool VirtualTexture::open(const std::string& sourcePath, const std::string& cacheFolder)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    if (cacheFolder.empty()) {
+        spdlog::error("Virtual texture {} needs a cache folder for its tiles", sourcePath);
+        return false;
+    }
+
+    std::error_code ec;
+    uint64_t sourceSize = std::filesystem::file_size(sourcePath, ec);
+    int64_t sourceModifiedTime = int64_t(std::filesystem::last_write_time(sourcePath, ec).time_since_epoch().count());
+
+    // e.g. earth16k.vtex
+    std::filesystem::create_directories(cacheFolder, ec);
+    std::string name = std::filesystem::path(sourcePath).stem().string() + ".vtex";
+    std::string pyramidPath = (std::filesystem::path(cacheFolder) / name).string();
+
+    //---------------------------------------------------------------
+    // Validate the mapped pyramid against its source, and bake it again if it's out of date
+    auto isValid = [&]() {
+        if (_pyramid->size() < PYRAMID_TILES_OFFSET)
+            return false;
+
+        const VirtualTexturePyramidHeader* header = (const VirtualTexturePyramidHeader*)_pyramid->data();
+        if (memcmp(header->magic, PYRAMID_MAGIC, sizeof(PYRAMID_MAGIC)) != 0 ||
+            header->version != PYRAMID_VERSION ||
+            header->tileSize != uint32_t(TILE_SIZE) ||
+            header->tileBorder != uint32_t(TILE_BORDER) ||
+            header->sourceSize != sourceSize ||
+            header->sourceModifiedTime != sourceModifiedTime ||
+            header->width == 0 || header->height == 0)
+        {
+            return false;
+        }
+
+        _layOut(int(header->width), int(header->height));
+        return _levels.size() <= MAX_LEVELS && _pyramid->size() >= PYRAMID_TILES_OFFSET + size_t(_numTiles) * TILE_BYTES;
+    };
+
+    _pyramid = std::make_unique<MappedFile>();
+    bool bFromCache = _pyramid->open(pyramidPath) && isValid();
+    if (!bFromCache)
+    {
+        _pyramid->close();
+        if (!_bake(sourcePath, pyramidPath, sourceSize, sourceModifiedTime))
+        {
+            _levels.clear();
+            return false;
+        }
+
+        if (!_pyramid->open(pyramidPath) || !isValid())
+        {
+            spdlog::error("Couldn't open virtual texture tiles {}", pyramidPath);
+            _levels.clear();
+            return false;
+        }
+    }
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    spdlog::info("Virtual texture {}: {}x{}, {} levels, {} tiles, {} in {:.1f} ms",
+                 sourcePath, width(), height(), _levels.size(), _numTiles, bFromCache ? "mapped" : "baked", ms);
+    return true;
+}
+
+// Decode the source and write the tiles of all levels to `pyramidPath`.  Only one level is in memory at a time,
+// next to the source.
+bool VirtualTexture::_bake(const std::string& sourcePath, const std::string& pyramidPath, uint64_t sourceSize,
+                           int64_t sourceModifiedTime)
+{
+    RgbImage level;
+    unsigned int width, height;
+    unsigned int error = lodepng::decode(level.pixels, width, height, sourcePath, LCT_RGB, 8);
+    if (error) {
+        spdlog::error("Couldn't decode virtual texture {}: {}", sourcePath, lodepng_error_text(error));
+        return false;
+    }
+    level.width = int(width);
+    level.height = int(height);
+
+    _layOut(level.width, level.height);
+    if (_levels.size() > MAX_LEVELS) {
+        spdlog::error("Virtual texture {} is too large: {}x{}", sourcePath, width, height);
+        return false;
+    }
+
+    VirtualTexturePyramidHeader header;
+    memcpy(header.magic, PYRAMID_MAGIC, sizeof(PYRAMID_MAGIC));
+    header.version = PYRAMID_VERSION;
+    header.tileSize = uint32_t(TILE_SIZE);
+    header.tileBorder = uint32_t(TILE_BORDER);
+    header.width = width;
+    header.height = height;
+    header.sourceSize = sourceSize;
+    header.sourceModifiedTime = sourceModifiedTime;
+
+    // Write to a temporary file first, so that an interrupted write doesn't leave a broken pyramid behind.
+    std::string tempPath = pyramidPath + ".tmp";
+    bool bWritten = false;
+    {
+        std::ofstream f(tempPath, std::ios::binary | std::ios::trunc);
+        char headerBytes[PYRAMID_TILES_OFFSET] = {};
+        memcpy(headerBytes, &header, sizeof(header));
+        f.write(headerBytes, sizeof(headerBytes));
+
+        std::vector<unsigned char> tile(TILE_BYTES);
+        for (size_t l = 0; l < _levels.size(); l++)
+        {
+            const Level& lv = _levels[l];
+            for (int ty = 0; ty < lv.tilesY; ty++)
+            {
+                for (int tx = 0; tx < lv.tilesX; tx++)
+                {
+                    // pixels past the edges of the level repeat the edge
+                    for (int y = 0; y < SLOT_SIZE; y++)
+                    {
+                        int sy = std::clamp(ty * TILE_SIZE - TILE_BORDER + y, 0, level.height - 1);
+                        for (int x = 0; x < SLOT_SIZE; x++)
+                        {
+                            int sx = std::clamp(tx * TILE_SIZE - TILE_BORDER + x, 0, level.width - 1);
+                            memcpy(&tile[(size_t(y) * SLOT_SIZE + x) * 3], &level.pixels[(size_t(sy) * level.width + sx) * 3], 3);
+                        }
+                    }
+                    f.write((const char*)tile.data(), tile.size());
+                }
+            }
+
+            if (l + 1 < _levels.size())
+                level = halveImage(level);
+        }
+
+        f.close();
+        bWritten = bool(f);
+    }
+
+    std::error_code ec;
+    if (!bWritten) {
+        // e.g. disk full.  The partial file can be gigabytes; don't leave it behind.
+        spdlog::error("Couldn't write virtual texture tiles {}", tempPath);
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+
+    std::filesystem::rename(tempPath, pyramidPath, ec);
+    if (ec) {
+        spdlog::error("Couldn't write virtual texture tiles {}: {}", pyramidPath, ec.message());
+        return false;
+    }
+    return true;
+}
+
+const unsigned char* VirtualTexture::_tileData(int tile) const
+{
+    return (const unsigned char*)_pyramid->data() + PYRAMID_TILES_OFFSET + size_t(tile) * TILE_BYTES;
+}
+
+int VirtualTexture::_tileLevel(int tile) const
+{
+    int l = 0;
+    while (l + 1 < int(_levels.size()) && _levels[l + 1].firstTile <= tile)
+        l++;
+    return l;
+}
+
+// The tile of the next coarser level covering `tile`.  -1 for the coarsest level.
+int VirtualTexture::_parentTile(int tile) const
+{
+    int l = _tileLevel(tile);
+    if (l + 1 == int(_levels.size()))
+        return -1;
+
+    const Level& level = _levels[l];
+    const Level& parent = _levels[l + 1];
+    int index = tile - level.firstTile;
+    int tx = std::min((index % level.tilesX) / 2, parent.tilesX - 1);
+    int ty = std::min((index / level.tilesX) / 2, parent.tilesY - 1);
+    return parent.firstTile + ty * parent.tilesX + tx;
+}
+
+//---------------------------------------------------------------------------------------------------
+// GPU residency
+
+void VirtualTexture::init(int atlasSlots)
+{
+    if (_levels.empty() || _atlas != 0)
+        return;
+
+    //---------------------------------------------------------------
+    // Atlas
+    glGenTextures(1, &_atlas);
+    glBindTexture(GL_TEXTURE_2D, _atlas);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGB8, atlasSlots * SLOT_SIZE, atlasSlots * SLOT_SIZE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    _atlasSlots = atlasSlots;
+    _slots.assign(size_t(atlasSlots) * atlasSlots, Slot());
+    _freeSlots.clear();
+    for (int s = int(_slots.size()) - 1; s >= 0; s--)
+        _freeSlots.push_back(s);
+
+    _pages.assign(_numTiles, 0);
+    _tileStates.assign(_numTiles, NotResident);
+    _feedback.assign(_numTiles, 0);
+
+    //---------------------------------------------------------------
+    // Level table and page table
+    int32_t levelTable[MAX_LEVELS][4] = {};
+    for (size_t l = 0; l < _levels.size(); l++)
+    {
+        levelTable[l][0] = _levels[l].width;
+        levelTable[l][1] = _levels[l].height;
+        levelTable[l][2] = _levels[l].tilesX;
+        levelTable[l][3] = _levels[l].firstTile;
+    }
+
+    glGenBuffers(1, &_pagesBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _pagesBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, LEVEL_TABLE_BYTES + _pages.size() * sizeof(uint32_t), nullptr, GL_DYNAMIC_DRAW);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, LEVEL_TABLE_BYTES, levelTable);
+
+    //---------------------------------------------------------------
+    // Feedback
+    GLuint zero = 0;
+    glGenBuffers(FEEDBACK_LATENCY, _feedbackBuffers);
+    for (GLuint buffer : _feedbackBuffers)
+    {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, _feedback.size() * sizeof(uint32_t), nullptr, GL_DYNAMIC_READ);
+        glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    //---------------------------------------------------------------
+    // The coarsest tile is always there to fall back to
+    int coarsest = _numTiles - 1;
+    int slot = _allocateSlot();
+    _upload(coarsest, slot, _tileData(coarsest));
+    _slots[slot].lastUsedFrame = UINT64_MAX;
+    _uploadPages();
+
+    _loader = std::thread(&VirtualTexture::_loaderMain, this);
+}
+
+void VirtualTexture::update()
+{
+    if (_atlas == 0)
+        return;
+
+    // Fence the feedback written last frame, so that it can be read without waiting when its turn comes
+    if (_frame > 0)
+    {
+        int written = int(_frame % FEEDBACK_LATENCY);
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        _feedbackFences[written] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    _frame++;
+
+    _wanted.clear();
+    if (_readFeedback())
+    {
+        _request();
+        _lastFeedbackFrame = _frame;
+    }
+
+    _uploadLoadedTiles();
+    if (_bPagesChanged)
+        _uploadPages();
+}
+
+void VirtualTexture::bind(GlslProgram& glslProgram, int textureUnit)
+{
+    glActiveTexture(GL_TEXTURE0 + textureUnit);
+    glBindTexture(GL_TEXTURE_2D, _atlas);
+    glslProgram.set(Uniforms::vtAtlas, textureUnit);
+    glslProgram.set(Uniforms::vtNumLevels, int(_levels.size()));
+    glslProgram.set(Uniforms::vtFeedbackPhase, int(_frame % 16));
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, VIRTUAL_TEXTURE_PAGES_BINDING, _pagesBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, VIRTUAL_TEXTURE_FEEDBACK_BINDING, _feedbackBuffers[_frame % FEEDBACK_LATENCY]);
+}
+
+//
+// Read the feedback written FEEDBACK_LATENCY frames ago and clear its buffer for this frame.  Collects the tiles
+// that are wanted but not resident, along with their missing parents, into _wanted.  false if the GPU isn't done
+// with the buffer yet; it's not waited for.
+//
+bool VirtualTexture::_readFeedback()
+{
+    int index = int(_frame % FEEDBACK_LATENCY);
+    GLsync fence = _feedbackFences[index];
+    if (fence == 0)
+        return false;
+
+    bool bDone = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0) != GL_TIMEOUT_EXPIRED;
+    glDeleteSync(fence);
+    _feedbackFences[index] = 0;
+
+    GLuint zero = 0;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _feedbackBuffers[index]);
+    if (bDone)
+        glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, _feedback.size() * sizeof(uint32_t), _feedback.data());
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    if (!bDone)
+        return false;
+
+    unsigned int numWanted = 0;
+    unsigned int hits = 0;
+    for (int tile = 0; tile < _numTiles; tile++)
+    {
+        if (_feedback[tile] == 0)
+            continue;
+
+        numWanted++;
+        if (_tileStates[tile] == Resident)
+            hits++;
+
+        // The tile drawn in its place is the finest resident one above it.  Keep that, and ask for the others.
+        for (int t = tile; t >= 0; t = _parentTile(t))
+        {
+            if (_tileStates[t] == Resident) {
+                _slots[_pages[t] - 1].lastUsedFrame = std::max(_slots[_pages[t] - 1].lastUsedFrame, _frame);
+                break;
+            }
+            if (_tileStates[t] == NotResident)
+                _wanted.push_back(t);
+        }
+    }
+
+    if (numWanted > 0)
+        _hitRate = float(hits) / float(numWanted);
+    return true;
+}
+
+// Replace the tiles queued for the loader with the ones wanted now, coarsest first.
+void VirtualTexture::_request()
+{
+    // Tiles of coarser levels have larger indices
+    std::sort(_wanted.begin(), _wanted.end(), std::greater<int>());
+    _wanted.erase(std::unique(_wanted.begin(), _wanted.end()), _wanted.end());
+    if (_wanted.size() > MAX_QUEUED_TILES)
+        _wanted.resize(MAX_QUEUED_TILES);
+
+    {
+        std::lock_guard<std::mutex> lock(_loaderMutex);
+
+        // Not wanted any more, or wanted again and queued again below.  Tiles the loader already took stay requested.
+        for (int tile : _queuedTiles)
+            _tileStates[tile] = NotResident;
+        _loadingTiles -= unsigned(_queuedTiles.size());
+        _queuedTiles.clear();
+
+        for (int tile : _wanted)
+        {
+            if (_tileStates[tile] != NotResident)
+                continue;
+            _tileStates[tile] = Requested;
+            _queuedTiles.push_back(tile);
+            _loadingTiles++;
+        }
+    }
+    _loaderCondition.notify_one();
+}
+
+void VirtualTexture::_uploadLoadedTiles()
+{
+    std::vector<LoadedTile> loaded;
+    {
+        std::lock_guard<std::mutex> lock(_loaderMutex);
+        while (!_loadedTiles.empty() && loaded.size() < MAX_UPLOADS_PER_FRAME)
+        {
+            loaded.push_back(std::move(_loadedTiles.front()));
+            _loadedTiles.pop_front();
+        }
+    }
+
+    for (const LoadedTile& t : loaded)
+    {
+        _loadingTiles--;
+
+        int slot = _allocateSlot();
+        if (slot < 0) {
+            // every slot is in use; asked for again if it's still wanted
+            _tileStates[t.tile] = NotResident;
+            continue;
+        }
+        _upload(t.tile, slot, t.pixels.data());
+    }
+}
+
+void VirtualTexture::_upload(int tile, int slot, const unsigned char* pixels)
+{
+    int x = (slot % _atlasSlots) * SLOT_SIZE;
+    int y = (slot / _atlasSlots) * SLOT_SIZE;
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);          // rows of SLOT_SIZE RGB pixels aren't 4 byte aligned
+    glBindTexture(GL_TEXTURE_2D, _atlas);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, SLOT_SIZE, SLOT_SIZE, GL_RGB, GL_UNSIGNED_BYTE, pixels);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    _slots[slot].tile = tile;
+    _slots[slot].lastUsedFrame = _frame;
+    _pages[tile] = uint32_t(slot + 1);
+    _tileStates[tile] = Resident;
+    _residentTiles++;
+    _bPagesChanged = true;
+}
+
+void VirtualTexture::_uploadPages()
+{
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, _pagesBuffer);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, LEVEL_TABLE_BYTES, _pages.size() * sizeof(uint32_t), _pages.data());
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+    _bPagesChanged = false;
+}
+
+// A free slot, or the least recently used one that wasn't used in the latest feedback.  -1 if there's none.
+int VirtualTexture::_allocateSlot()
+{
+    if (!_freeSlots.empty())
+    {
+        int slot = _freeSlots.back();
+        _freeSlots.pop_back();
+        return slot;
+    }
+
+    int lru = -1;
+    for (int s = 0; s < int(_slots.size()); s++)
+    {
+        if (_slots[s].lastUsedFrame < _lastFeedbackFrame &&
+            (lru < 0 || _slots[s].lastUsedFrame < _slots[lru].lastUsedFrame))
+        {
+            lru = s;
+        }
+    }
+    if (lru < 0)
+        return -1;
+
+    int evicted = _slots[lru].tile;
+    _pages[evicted] = 0;
+    _tileStates[evicted] = NotResident;
+    _residentTiles--;
+    _bPagesChanged = true;
+    return lru;
+}
+
+// Reading a tile from the mapped pyramid faults its pages in from disk; that happens here rather than on the
+// main thread.
+void VirtualTexture::_loaderMain()
+{
+    while (true)
+    {
+        int tile;
+        {
+            std::unique_lock<std::mutex> lock(_loaderMutex);
+            _loaderCondition.wait(lock, [this]() { return _bQuit || !_queuedTiles.empty(); });
+            if (_bQuit)
+                return;
+            tile = _queuedTiles.front();
+            _queuedTiles.pop_front();
+        }
+
+        const unsigned char* data = _tileData(tile);
+        LoadedTile loaded = { tile, std::vector<unsigned char>(data, data + TILE_BYTES) };
+
+        std::lock_guard<std::mutex> lock(_loaderMutex);
+        _loadedTiles.push_back(std::move(loaded));
+    }
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "GlslProgram.h"
+#include "MappedFile.h"
+
+// Binding points of the shader storage blocks of virtual_texture.glsl
+constexpr GLuint VIRTUAL_TEXTURE_PAGES_BINDING = 1;
+constexpr GLuint VIRTUAL_TEXTURE_FEEDBACK_BINDING = 2;
+
+//
+// Texture too large to keep in memory, e.g. a 16k or 43k map of the earth.  Only the tiles that are visible are
+// resident.
+//  - open() bakes the source into a tile pyramid file in the cache folder the first time, and memory maps it.
+//    Each level is half the size of the previous one, down to the first level that fits a single tile.  Tiles
+//    carry a border of neighbouring pixels for bilinear filtering across tile edges.
+//  - Resident tiles live in slots of one atlas texture.  The page table has an entry per tile of the pyramid: 0 if
+//    not resident, else 1 + its atlas slot.  The shader samples the finest resident tile at or coarser than the
+//    level it wants.  The tile of the coarsest level is always resident.
+//  - Feedback: while drawing, the shader writes the tiles it wants into a feedback buffer, one pixel of every
+//    4x4 block per frame.  update() reads the buffer a couple of frames later, so it never waits for the GPU.
+//  - Missing tiles are requested from a loader thread, coarsest first.  Loaded tiles are copied into free or
+//    least recently used slots, a few per frame.  Slots used in the latest feedback are never given up.
+//  - PNG sources only.
+//
+class VirtualTexture
+{
+public:
+    static constexpr int TILE_SIZE = 128;                   // must match virtual_texture.glsl
+    static constexpr int TILE_BORDER = 1;
+    static constexpr int SLOT_SIZE = TILE_SIZE + 2 * TILE_BORDER;
+    static constexpr int MAX_LEVELS = 16;
+
+    VirtualTexture() {}
+    ~VirtualTexture();
+
+    VirtualTexture(const VirtualTexture&) = delete;
+    VirtualTexture& operator=(const VirtualTexture&) = delete;
+
+    // No GL calls; can run on a worker thread.  false if the source can't be decoded.
+    bool open(const std::string& sourcePath, const std::string& cacheFolder);
+
+    // Creates the atlas, with `atlasSlots` x `atlasSlots` tiles, and the buffers, and starts the loader thread.
+    void init(int atlasSlots = 24);
+    void update();
+
+    // Textures and buffers for the planet program.  Uses texture unit `textureUnit`.
+    void bind(GlslProgram& glslProgram, int textureUnit);
+
+    bool isOpen() const                             { return !_levels.empty(); }
+    bool isReady() const                            { return _atlas != 0; }
+    int width() const                               { return _levels.empty() ? 0 : _levels[0].width; }
+    int height() const                              { return _levels.empty() ? 0 : _levels[0].height; }
+
+    unsigned int residentTiles() const              { return _residentTiles; }
+    unsigned int atlasTiles() const                 { return unsigned(_slots.size()); }
+    size_t residentBytes() const                    { return size_t(_residentTiles) * TILE_BYTES; }
+    size_t atlasBytes() const                       { return _slots.size() * TILE_BYTES; }
+    unsigned int loadingTiles() const               { return _loadingTiles; }
+    float hitRate() const                           { return _hitRate; }        // of tiles wanted last time feedback was read
+
+private:
+    static constexpr size_t TILE_BYTES = size_t(SLOT_SIZE) * SLOT_SIZE * 3;
+    static constexpr int FEEDBACK_LATENCY = 2;             // frames between writing feedback and reading it
+    static constexpr int MAX_QUEUED_TILES = 64;
+    static constexpr int MAX_UPLOADS_PER_FRAME = 16;
+
+    struct Level
+    {
+        int width;
+        int height;
+        int tilesX;
+        int tilesY;
+        int firstTile;                              // index of the level's first tile in the page table
+    };
+
+    struct Slot
+    {
+        int tile = -1;
+        uint64_t lastUsedFrame = 0;
+    };
+
+    struct LoadedTile
+    {
+        int tile;
+        std::vector<unsigned char> pixels;
+    };
+
+    enum TileState : uint8_t { NotResident, Requested, Resident };
+
+    void _layOut(int width, int height);
+    bool _bake(const std::string& sourcePath, const std::string& pyramidPath, uint64_t sourceSize,
+               int64_t sourceModifiedTime);
+    const unsigned char* _tileData(int tile) const;
+    int _tileLevel(int tile) const;
+    int _parentTile(int tile) const;
+
+    bool _readFeedback();
+    void _request();
+    void _uploadLoadedTiles();
+    void _upload(int tile, int slot, const unsigned char* pixels);
+    void _uploadPages();
+    int _allocateSlot();
+    void _loaderMain();
+
+private:
+    std::vector<Level> _levels;
+    int _numTiles = 0;
+    std::unique_ptr<MappedFile> _pyramid;
+
+    //-------------------------------------------
+    // GPU resources
+    GLuint _atlas = 0;
+    GLuint _pagesBuffer = 0;                        // level table, then the page table
+    GLuint _feedbackBuffers[FEEDBACK_LATENCY] = {};
+    GLsync _feedbackFences[FEEDBACK_LATENCY] = {};
+
+    //-------------------------------------------
+    // Residency; main thread only
+    std::vector<uint32_t> _pages;
+    std::vector<TileState> _tileStates;
+    int _atlasSlots = 0;                            // per side
+    std::vector<Slot> _slots;
+    std::vector<int> _freeSlots;
+    std::vector<uint32_t> _feedback;
+    std::vector<int> _wanted;                       // missing tiles in the latest feedback
+    uint64_t _frame = 0;
+    uint64_t _lastFeedbackFrame = 0;                // slots used since then are kept
+    bool _bPagesChanged = false;
+
+    unsigned int _residentTiles = 0;
+    unsigned int _loadingTiles = 0;
+    float _hitRate = 1.0f;
+
+    //-------------------------------------------
+    // Loader thread
+    std::thread _loader;
+    std::mutex _loaderMutex;
+    std::condition_variable _loaderCondition;
+    std::deque<int> _queuedTiles;                   // coarsest first
+    std::deque<LoadedTile> _loadedTiles;
+    bool _bQuit = false;
+};
@@ -1,6 +1,7 @@
 #include "Utils.h"
 #include "CoordinateAxisRenderer.h"
 #include "Leela.h"
+#include "GlslUniforms.h"
 
 
 CoordinateAxisRenderer::CoordinateAxisRenderer()
@@ -69,7 +70,7 @@ void CoordinateAxisRenderer::_renderAxis(GlslProgram glslProgram)
         //----------------------------------------------
         // Axis model transformation
         //----------------------------------------------
-        glslProgram.setMat4("model", glm::value_ptr(glm::mat4(1.0)));
+        glslProgram.set(Uniforms::model, glm::mat4(1.0));
         glBindVertexArray(_axisVao);
         // Draw vertices
         glDrawArrays(GL_LINES, 0, numVertices);
@@ -86,3 +87,10 @@ void CoordinateAxisRenderer::render(ViewportType viewportType, RenderStage rende
         }
     }
 }
+
+bool CoordinateAxisRenderer::rendersIn(ViewportType viewportType, RenderStage renderStage, GlslProgramType programType)
+{
+    return renderStage == RenderStage::Main &&
+           programType == GlslProgramType::Simple &&
+           (viewportType == ViewportType::Primary || viewportType == ViewportType::Minimap);
+}
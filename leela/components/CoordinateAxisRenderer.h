@@ -15,6 +15,7 @@ public:
     void constructVerticesAndSendToGpu();
     void _renderAxis(GlslProgram glslProgram);
     virtual void render(ViewportType viewportType, RenderStage renderStage, GlslProgram& glslProgram);
+    virtual bool rendersIn(ViewportType viewportType, RenderStage renderStage, GlslProgramType programType);
 
     void advance(float stepMultiplier) {}
 
@@ -1,6 +1,7 @@
 #include "MonthLabelsRenderer.h"
 
 #include "Leela.h"
+#include "GlslUniforms.h"
 
 
 void MonthLabelsRenderer::init()
@@ -56,7 +57,6 @@ void MonthLabelsRenderer::_renderLabels(GlslProgram& glslProgram, bool isPre)
 
             //----- TEMP ------
             glm::mat4 projection = glm::ortho(float(g_leela->curViewportX), float(g_leela->curViewportX + g_leela->curViewportWidth), float(g_leela->curViewportY), float(g_leela->curViewportY + g_leela->curViewportHeight));
-            glslProgram.setMat4("projection", glm::value_ptr(projection));
             //----- TEMP ------
 
 
@@ -75,7 +75,7 @@ void MonthLabelsRenderer::_renderLabels(GlslProgram& glslProgram, bool isPre)
                 if (projected.z < 1.0f)
                 {
                     g_leela->RenderText(
-                        glslProgram,
+                        projection,
                         RenderTextType_ScreenText,
                         monthNames[i].c_str(),
                         projected.x,
@@ -110,3 +110,10 @@ void MonthLabelsRenderer::render(ViewportType viewportType, RenderStage renderSt
         }
     }
 }
+
+bool MonthLabelsRenderer::rendersIn(ViewportType viewportType, RenderStage renderStage, GlslProgramType programType)
+{
+    return programType == GlslProgramType::Font &&
+           viewportType == ViewportType::Primary &&
+           (renderStage == RenderStage::Pre || renderStage == RenderStage::Post);
+}
@@ -19,6 +19,7 @@ public:
     void calculateMonthPositions(float labelPositionScale);
     void _renderLabels(GlslProgram& glslProgram, bool isPre);
     virtual void render(ViewportType viewportType, RenderStage renderStage, GlslProgram& glslProgram);
+    virtual bool rendersIn(ViewportType viewportType, RenderStage renderStage, GlslProgramType programType);
 
 private:
 	SphericalBody* _sphere = nullptr;
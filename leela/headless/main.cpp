@@ -0,0 +1,240 @@
+//
+// Headless simulation runner.
+//  - Builds the scene from the Elements.cpp tables without SDL, OpenGL or FreeType, runs it for a number of
+//    steps and reports throughput.  Intended for measuring simulation performance without a display (CI).
+//  - Optionally evaluates a minor body catalog every step as well, and can dump body positions to a CSV file so
+//    that runs can be compared against each other for regressions.
+//
+// Usage:
+//      leela-headless [--steps N] [--step-size S] [--to-scale] [--threads T] [--catalog MPCORB.DAT]
+//                     [--dump FILE] [--dump-every K]
+//
+
+#include "SceneObject.h"
+#include "SphericalBody.h"
+#include "BodyStore.h"
+#include "JobSystem.h"
+#include "MinorBodyCatalog.h"
+#include "Elements.h"
+#include <spdlog/spdlog.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+
+struct HeadlessOptions
+{
+    long long steps = 100000;
+    double stepSize = 1.0;                      // simulation time advanced per step, in reference frame steps
+    bool bToScale = false;
+    int threads = 1;
+    std::string catalogPath;
+    std::string dumpPath;
+    long long dumpEvery = 1000;
+};
+
+
+static void printUsage()
+{
+    printf("Usage: leela-headless [--steps N] [--step-size S] [--to-scale] [--threads T] [--catalog MPCORB.DAT]\n"
+           "                      [--dump FILE] [--dump-every K]\n");
+}
+
+static bool parseOptions(int argc, char* argv[], HeadlessOptions& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        bool bHasValue = (i + 1 < argc);
+
+        if (arg == "--to-scale")
+            options.bToScale = true;
+        else if (arg == "--steps" && bHasValue)
+            options.steps = atoll(argv[++i]);
+        else if (arg == "--step-size" && bHasValue)
+            options.stepSize = atof(argv[++i]);
+        else if (arg == "--threads" && bHasValue)
+            options.threads = atoi(argv[++i]);
+        else if (arg == "--catalog" && bHasValue)
+            options.catalogPath = argv[++i];
+        else if (arg == "--dump" && bHasValue)
+            options.dumpPath = argv[++i];
+        else if (arg == "--dump-every" && bHasValue)
+            options.dumpEvery = atoll(argv[++i]);
+        else
+            return false;
+    }
+
+    return options.steps > 0 && options.threads > 0 && options.dumpEvery > 0;
+}
+
+//
+// Same configuration of spherical bodies as Leela's constructor, minus the renderers.
+//
+static std::vector<SphericalBody*> buildScene(Scene& scene, BodyStore& store, bool bToScale)
+{
+    PlanetInfo* planetInfos = bToScale ? &planetInfoToScale[0] : &planetInfo[0];
+    int numPlanetInfos = bToScale ? numPlanetInfoToScale : numPlanetInfo;
+
+    std::vector<SphericalBody*> bodies;
+    SphericalBody* sun = nullptr;
+
+    for (int i = 0; i < numPlanetInfos; i++)
+    {
+        PlanetInfo& pi = planetInfos[i];
+
+        SphericalBody* sb = new SphericalBody(pi.name, store);
+        sb->setRotationParameters(pi.radius,
+                                  glm::radians(pi.rotationAngle),
+                                  pi.rotationAngularVelocity,
+                                  glm::radians(pi.axisTiltOrientationAngle),
+                                  glm::radians(pi.axisTiltAngle)
+        );
+        sb->setOrbitalParameters(pi.orbitalRadius,
+                                 glm::radians(pi.orbitalAngle),
+                                 pi.orbitalAngularVelocity,
+                                 glm::radians(pi.nodalPrecessionInitialAngle),
+                                 glm::radians(pi.orbitalPlaneTiltAngle)
+        );
+        sb->setOrbitShape(pi.eccentricity, glm::radians(pi.argumentOfPeriapsis));
+        sb->setColor(pi.color);
+
+        if (pi.name == "Sun")
+            sun = sb;
+        else
+            sb->setSunSphere(sun);
+
+        SceneObject* parentObj = &scene;
+        if (pi.parentName != "")
+            parentObj = SceneObject::getSceneObjectByName(&scene, pi.parentName);
+        parentObj->addSceneObject(sb);
+
+        bodies.push_back(sb);
+    }
+
+    for (int i = 0; i < numPlanetInfos; i++)
+    {
+        for (std::string relatedObjName : planetInfos[i].relatedObjectNames)
+        {
+            SphericalBody* relatedSphere = dynamic_cast<SphericalBody*>(SceneObject::getSceneObjectByName(&scene, relatedObjName));
+            if (relatedSphere)
+                bodies[i]->addRelatedSphere(relatedSphere);
+        }
+    }
+
+    return bodies;
+}
+
+// Same work as Leela::evaluateScene(), plus the world transform of each body which rendering would ask for.
+static void evaluateScene(Scene& scene, BodyStore& store, JobSystem& jobSystem, double t)
+{
+    store.evaluateAt(t, &jobSystem);
+    scene.invalidateTransforms();
+
+    for (const Scene::FlatNode& node : scene.flattened())
+    {
+        node.object->evaluateAt(t);
+        node.object->getTransform();
+    }
+}
+
+static void dumpPositions(FILE* f, long long step, double t, const std::vector<SphericalBody*>& bodies)
+{
+    for (SphericalBody* sb : bodies)
+    {
+        glm::vec3 p = sb->getModelTransformedCenter();
+        fprintf(f, "%lld,%.6f,%s,%.9g,%.9g,%.9g\n", step, t, sb->_name.c_str(), p.x, p.y, p.z);
+    }
+}
+
+
+int main(int argc, char* argv[])
+{
+    HeadlessOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    spdlog::set_pattern("[%H:%M:%S.%e] [%^%l%$] %v");
+
+    Scene scene;
+    BodyStore bodyStore;
+    JobSystem jobSystem(options.threads);
+
+    std::vector<SphericalBody*> bodies = buildScene(scene, bodyStore, options.bToScale);
+    for (const Scene::FlatNode& node : scene.flattened())
+        node.object->init();
+
+    MinorBodyCatalog catalog;
+    if (!options.catalogPath.empty() && !catalog.load(options.catalogPath))
+    {
+        spdlog::error("Couldn't load minor body catalog {}", options.catalogPath);
+        return 1;
+    }
+
+    FILE* dumpFile = nullptr;
+    if (!options.dumpPath.empty())
+    {
+        dumpFile = fopen(options.dumpPath.c_str(), "w");
+        if (dumpFile == nullptr)
+        {
+            spdlog::error("Couldn't open {} for writing", options.dumpPath);
+            return 1;
+        }
+        fprintf(dumpFile, "step,time,body,x,y,z\n");
+    }
+
+    // One earth revolution is a year.  Same conversion as Leela::evaluateScene().
+    SphericalBody* earth = dynamic_cast<SphericalBody*>(SceneObject::getSceneObjectByName(&scene, "Earth"));
+    double daysPerStep = earth ? earth->orbitalAngularVelocity() * 365.25 / (2 * M_PI) : 1.0;
+
+    double sceneSeconds = 0.0;
+    double catalogSeconds = 0.0;
+
+    for (long long step = 0; step <= options.steps; step++)
+    {
+        double t = step * options.stepSize;
+
+        auto start = std::chrono::steady_clock::now();
+        evaluateScene(scene, bodyStore, jobSystem, t);
+        auto sceneEnd = std::chrono::steady_clock::now();
+
+        if (catalog.isLoaded())
+            catalog.evaluateAt(t * daysPerStep, &jobSystem);
+        auto catalogEnd = std::chrono::steady_clock::now();
+
+        // step 0 only sets up the initial state
+        if (step != 0)
+        {
+            sceneSeconds += std::chrono::duration<double>(sceneEnd - start).count();
+            catalogSeconds += std::chrono::duration<double>(catalogEnd - sceneEnd).count();
+        }
+
+        if (dumpFile && step % options.dumpEvery == 0)
+            dumpPositions(dumpFile, step, t, bodies);
+    }
+
+    if (dumpFile)
+        fclose(dumpFile);
+
+    spdlog::info("Scene: {} bodies x {} steps in {:.3f} s: {:.0f} steps/s, {:.1f} ns/body",
+                 bodies.size(), options.steps, sceneSeconds,
+                 options.steps / sceneSeconds,
+                 sceneSeconds * 1e9 / (double(options.steps) * bodies.size()));
+
+    if (catalog.isLoaded())
+        spdlog::info("Catalog: {} bodies x {} steps in {:.3f} s: {:.1f} steps/s, {:.1f} ns/body",
+                     catalog.size(), options.steps, catalogSeconds,
+                     options.steps / catalogSeconds,
+                     catalogSeconds * 1e9 / (double(options.steps) * catalog.size()));
+
+    for (SphericalBody* sb : bodies)
+        delete sb;
+
+    return 0;
+}
@@ -3,6 +3,7 @@
 #include "Leela.h"
 #include <spdlog/spdlog.h>
 #include "spdlog/sinks/rotating_file_sink.h"
+#include <filesystem>
 
 /*
  * Change to the parent directory of the executable we are running from.
@@ -70,6 +71,8 @@ int main(int argc, char *argv[])
 
     std::string logFolderPath = std::string(path) + "\\" + appName + "\\" + "Logs";
     std::string logFilePath = logFolderPath + "\\" + "leela.log";
+    g_leela->cacheFolderPath = std::string(path) + "\\" + appName + "\\" + "Cache";
+    g_leela->traceFolderPath = std::string(path) + "\\" + appName + "\\" + "Traces";
 
     spdlog::set_pattern("[%H:%M:%S.%e] [%^%l%$] %v");
 
@@ -85,6 +88,30 @@ int main(int argc, char *argv[])
     spdlog::set_default_logger(logger);
     spdlog::flush_every(std::chrono::seconds(5));
 
+    //-------------------------------------------
+
+    for (int i = 1; i < argc; i++)
+    {
+        // BC1 textures: 1/6 of the memory and upload bandwidth of RGB, at some loss of quality
+        if (std::string(argv[i]) == "--compress-textures")
+            g_leela->bCompressTextures = true;
+
+        // e.g. a 16k map of the earth.  Its tiles are baked into the cache folder the first time.
+        //  - A path relative to where Leela was started is made absolute here, as the working directory changes
+        //    below.  Names not found there are looked up in the textures folder later.
+        else if (std::string(argv[i]) == "--earth-map" && i + 1 < argc)
+        {
+            std::filesystem::path earthMap = argv[++i];
+            std::error_code ec;
+            if (std::filesystem::exists(earthMap, ec)) {
+                std::filesystem::path absolutePath = std::filesystem::absolute(earthMap, ec);
+                if (!ec)
+                    earthMap = absolutePath;
+            }
+            g_leela->earthVirtualTextureFilename = earthMap.string();
+        }
+    }
+
     //-------------------------------------------
     
     if (!changeDirToParentOfExecutable())
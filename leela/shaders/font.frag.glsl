@@ -1,13 +1,16 @@
 #version 330 core
 
 in vec2 TexCoords;
+in vec3 TextColor;
 out vec4 color;
 
-uniform sampler2D text;
-uniform vec3 textColor;
+uniform sampler2D text;     // signed distance field atlas; 0.5 on the glyph outline.  See GlyphAtlas.
 
 void main()
 {
-    vec4 sampled = vec4(1.0, 1.0, 1.0, texture(text, TexCoords).r);
-    color = vec4(textColor, 1.0) * sampled;
+    // Anti-alias over about one screen pixel, whatever the size the glyph is drawn at.
+    float dist = texture(text, TexCoords).r;
+    float edgeWidth = fwidth(dist);
+    float alpha = smoothstep(0.5 - edgeWidth, 0.5 + edgeWidth, dist);
+    color = vec4(TextColor, alpha);
 }
@@ -3,8 +3,10 @@
 
 layout(location = 0) in vec3 vertex;   // <vec3 pos>
 layout(location = 1) in vec2 tex;      // <vec2 tex>
+layout(location = 2) in vec3 color;    // <vec3 color>
 
 out vec2 TexCoords;
+out vec3 TextColor;
 
 uniform mat4 projection;
 
@@ -13,6 +15,7 @@ void main()
 {
     gl_Position = projection * vec4(vertex, 1.0);
     TexCoords = tex;
+    TextColor = color;
 }
 
 
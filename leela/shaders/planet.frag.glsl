@@ -1,25 +1,48 @@
 #version 450 core
 
+// Fragments hidden by the depth test must not report virtual texture tiles as wanted
+layout (early_fragment_tests) in;
+
 in vec4 Color;
 in vec2 TexCoord;
 in float darknessFactor;
+in vec3 WorldPosition;
+in vec3 WorldNormal;
+
+// Camera and sun, shared by all programs.  See FrameUniforms in FrameUniformBuffer.h.
+layout (std140) uniform FrameUniforms
+{
+    mat4  view;
+    mat4  proj;
+    vec3  sunCenterTransformed;
+    float sunRadius;
+    bool  realisticShading;
+};
 
 uniform bool useTexture = false;
 uniform bool useTexture2 = false;
+uniform bool useVirtualTexture = false;        // in place of texture1.  Only if useTexture is set.
 uniform sampler2D texture1;
 uniform sampler2D texture2;
+uniform bool perFragmentShading = false;       // compute darkness factor here rather than using the per vertex one
+
+#include "eclipse_shading.glsl"
+#include "virtual_texture.glsl"
 
 out vec4 FragColor;
 
 void main()
 {
+    // Shadow edges are as sharp as the shading allows rather than following the triangles of the mesh.
+    float d = perFragmentShading ? eclipseDarknessFactor(WorldPosition, normalize(WorldNormal)) : darknessFactor;
+
     if (useTexture) {
-        FragColor = texture(texture1, TexCoord) * darknessFactor;
+        FragColor = (useVirtualTexture ? sampleVirtualTexture(TexCoord) : texture(texture1, TexCoord)) * d;
         if (useTexture2) {
-            FragColor += texture(texture2, TexCoord) * darknessFactor;
+            FragColor += texture(texture2, TexCoord) * d;
         }
     }
     else {
-        FragColor = vec4(Color.rgb * darknessFactor, Color.a);
+        FragColor = vec4(Color.rgb * d, Color.a);
     }
 }
@@ -3,9 +3,17 @@
 layout (location = 0) in vec3 position;
 layout (location = 1) in vec4 in_color;
 
+// Camera and sun, shared by all programs.  See FrameUniforms in FrameUniformBuffer.h.
+layout (std140) uniform FrameUniforms
+{
+    mat4  view;
+    mat4  proj;
+    vec3  sunCenterTransformed;
+    float sunRadius;
+    bool  realisticShading;
+};
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 proj;
 
 out vec4 Color;
 
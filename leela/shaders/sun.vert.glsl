@@ -5,9 +5,17 @@ layout (location = 1) in vec4 in_color;
 layout (location = 2) in vec3 normal;
 layout (location = 3) in vec2 texCoord;
 
+// Camera and sun, shared by all programs.  See FrameUniforms in FrameUniformBuffer.h.
+layout (std140) uniform FrameUniforms
+{
+    mat4  view;
+    mat4  proj;
+    vec3  sunCenterTransformed;
+    float sunRadius;
+    bool  realisticShading;
+};
+
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 proj;
 
 out vec4 Color;
 out vec2 TexCoord;
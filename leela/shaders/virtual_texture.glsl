@@ -0,0 +1,70 @@
+//
+// Sampling of a virtual texture, which has only some of its tiles resident.  Pulled in with #include by
+// planet.frag.glsl.  See VirtualTexture.h.
+//
+
+const int VT_TILE_SIZE = 128;           // VirtualTexture::TILE_SIZE
+const int VT_TILE_BORDER = 1;           // VirtualTexture::TILE_BORDER
+const int VT_SLOT_SIZE = VT_TILE_SIZE + 2 * VT_TILE_BORDER;
+
+layout (std430, binding = 1) readonly buffer VirtualTexturePages
+{
+    ivec4 vtLevels[16];                 // width, height, tiles per row, first tile
+    uint  vtPages[];                    // per tile: 0 if not resident, else 1 + its slot in vtAtlas
+};
+
+layout (std430, binding = 2) writeonly buffer VirtualTextureFeedback
+{
+    uint vtFeedback[];                  // per tile: non-zero if it was wanted
+};
+
+uniform sampler2D vtAtlas;
+uniform int vtNumLevels;
+uniform int vtFeedbackPhase;            // the pixel of each 4x4 block that reports its tile this frame
+
+
+ivec2 vtTile(vec2 uv, int level)
+{
+    ivec4 l = vtLevels[level];
+    ivec2 tile = ivec2(clamp(uv, 0.0, 1.0) * vec2(l.xy)) / VT_TILE_SIZE;
+    return min(tile, (l.xy - 1) / VT_TILE_SIZE);
+}
+
+int vtTileIndex(vec2 uv, int level)
+{
+    ivec2 tile = vtTile(uv, level);
+    return vtLevels[level].w + tile.y * vtLevels[level].z + tile.x;
+}
+
+vec4 sampleVirtualTexture(vec2 uv)
+{
+    // The level a mipmapped texture of the full size would be sampled from
+    vec2 texel = uv * vec2(vtLevels[0].xy);
+    vec2 dx = dFdx(texel);
+    vec2 dy = dFdy(texel);
+    float lod = 0.5 * log2(max(dot(dx, dx), dot(dy, dy)));
+    int wanted = clamp(int(floor(lod + 0.5)), 0, vtNumLevels - 1);
+
+    ivec2 pixel = ivec2(gl_FragCoord.xy) & 3;
+    if (pixel.y * 4 + pixel.x == vtFeedbackPhase)
+        vtFeedback[vtTileIndex(uv, wanted)] = 1u;
+
+    // Finest resident tile at or above the wanted level.  The coarsest level is always resident.
+    int level = wanted;
+    uint page = vtPages[vtTileIndex(uv, level)];
+    while (page == 0u && level < vtNumLevels - 1) {
+        level++;
+        page = vtPages[vtTileIndex(uv, level)];
+    }
+
+    ivec2 atlasSlots = textureSize(vtAtlas, 0) / VT_SLOT_SIZE;
+    int slot = int(page) - 1;
+    ivec2 slotOrigin = ivec2(slot % atlasSlots.x, slot / atlasSlots.x) * VT_SLOT_SIZE;
+
+    vec2 levelTexel = clamp(uv, 0.0, 1.0) * vec2(vtLevels[level].xy);
+    vec2 inTile = levelTexel - vec2(vtTile(uv, level) * VT_TILE_SIZE);
+    vec2 atlasTexel = vec2(slotOrigin + VT_TILE_BORDER) + inTile;
+
+    // The atlas has no mipmaps.  Explicit level, as derivatives aren't defined after the loop above.
+    return textureLod(vtAtlas, atlasTexel / vec2(textureSize(vtAtlas, 0)), 0.0);
+}